@@ -57,11 +57,17 @@
 #include "src/oscillators.h"
 #include "src/timers.h"
 #include "src/irq.h"
-//#include "src/i2c.h"
+#include "src/i2c.h"
 #include <stdint.h>
 #include "app.h"
 #include "src/scheduler.h"
+#include "src/task.h"
+#include "src/power.h"
+#include "src/energy.h"
+#include "src/vcom.h"
 #include "src/bme680.h"
+#include "src/grid_eye.h"
+#include "src/ble.h"
 
 
 
@@ -136,7 +142,15 @@
 bool app_is_ok_to_sleep(void)
 {
 
-  return APP_IS_OK_TO_SLEEP;
+  // A blocking wait serves no events, only its own completion must not wait
+  // for the next IRQ
+  if (powerWaiting()) {
+      return APP_IS_OK_TO_SLEEP && !powerWaitDone();
+  }
+
+  // An event posted after the last getNextEvent() must not wait for the next IRQ,
+  // nor a message logged by an interrupt after the last logDrain()
+  return APP_IS_OK_TO_SLEEP && !schedulerEventsPending() && !logPending();
 
 } // app_is_ok_to_sleep()
 
@@ -168,21 +182,17 @@ SL_WEAK void app_init(void)
   gpioInit();
   oscillatorInit();
   low_energy_timerInit();
+  powerInit(); // Applies the LOWEST_ENERGY_MODE floor, drivers raise it per operation
+  vcomInit();  // Log output is written out by the LDMA from here on
   letimer0_irq_init();
+  gpio_irq_init();
   i2c_Init();
   grid_eye_init();
-  get_calibration_parameters();
+  displayInit(); // Shares SENSOR_ENABLE with the sensors, no BT calls are made
+  BME680_init();
 
   LOG_INFO("\n\n\rStarting new program\n\n\r");
 
-  if (LOWEST_ENERGY_MODE == 1) {
-    sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
-  }
-  else if (LOWEST_ENERGY_MODE == 2) {
-    sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM2);
-  }
-
-
 }
 
 
@@ -216,21 +226,40 @@ SL_WEAK void app_process_action(void)
   //         We will create/use a scheme that is far more energy efficient in
   //         later assignments.
 
-  uint32_t evt;
+  sched_event_t event;
+  static uint32_t reportCount = 0;
 
-  evt = getNextEvent();
+  /* Time from wake up to going back to sleep counts as compute */
+  energyBegin(energySubCompute);
 
-  switch(evt) {
+  /* Drain every queued event, highest priority first, resuming the driver
+   * tasks that wait for it; the main loop sleeps once the queues are empty */
+  while (getNextEvent(&event)) {
 
-    case evtLETIMER0_UF:
-//      read_max_17048();
-      read_BME680();
-//      read_temp();
-//      read_grid_eye();
-//      grid_eye_te mp_test();
-      break;
+    taskDispatch(&event);
+
+    switch(event.id) {
+
+      case evtLETIMER0_UF:
+//        read_max_17048();
+//        read_grid_eye();
+//        grid_eye_te mp_test();
+        if (++reportCount == ENERGY_REPORT_UF) {
+          reportCount = 0;
+          energyLogReport();
+        }
+        break;
+
+      default:
+        break;
+    }
   }
 
+  energyEnd(energySubCompute);
+
+  // Everything is handled, write out the deferred log before sleeping
+  logDrain();
+
 }
 
 /**************************************************************************//**
@@ -245,18 +274,16 @@ SL_WEAK void app_process_action(void)
 void sl_bt_on_event(sl_bt_msg_t *evt)
 {
 
-  // Just a trick to hide a compiler warning about unused input parameter evt.
-  (void) evt;
+  energyBegin(energySubBle);
 
   // Some events require responses from our application code,
   // and don’t necessarily advance our state machines.
-  // For assignment 5 uncomment the next 2 function calls
-  // handle_ble_event(evt); // put this code in ble.c/.h
+  handle_ble_event(evt); // in ble.c/.h
 
   // sequence through states driven by events
   // state_machine(evt);    // put this code in scheduler.c/.h
 
-
+  energyEnd(energySubBle);
 
 } // sl_bt_on_event()
 
@@ -47,7 +47,7 @@
 #define APP_H
 
 
-#define LOWEST_ENERGY_MODE 3 /* Energy mode Macro: Number represents respective mode 3: EM3*/
+#define LOWEST_ENERGY_MODE 3 /* Deepest energy mode the build allows, 3: EM3; src/power.c raises it per operation */
 #define LETIMER_ON_TIME_MS 175 /* LETIMER On time in milliseconds*/
 #define LETIMER_PERIOD_MS 3000 /* LETIMER Period in milliseconds*/
 
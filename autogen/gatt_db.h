@@ -15,7 +15,9 @@ extern const sli_bt_gattdb_t gattdb;
 #define gattdb_device_name                    11
 #define gattdb_manufacturer_name_string       16
 #define gattdb_system_id                      18
-#define gattdb_ota_control                    21
+#define gattdb_energy_report                  21
+#define gattdb_log_mask                       24
+#define gattdb_ota_control                    27
 
 
 #endif // __GATT_DB_H
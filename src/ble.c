@@ -0,0 +1,127 @@
+/*
+* File Name: ble.c
+* File Description: This file contains the Bluetooth event handling of the
+* application, called from sl_bt_on_event in app.c
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#include <stdint.h>
+#include "sl_bluetooth.h"
+#include "gatt_db.h"
+#include "src/power.h"
+#include "src/energy.h"
+#include "src/ble.h"
+
+#define INCLUDE_LOG_DEBUG 1
+#define LOG_MODULE LOG_MOD_BLE
+#include "src/log.h"
+
+/*
+ * Function Name: ble_user_read
+ *
+ * Parameters:
+ * sl_bt_evt_gatt_server_user_read_request_t *req Read request
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function answers a read of a user characteristic from the live
+ * state. Long reads arrive as several requests with increasing offsets.
+ * Characteristics without a handler get an ATT error response.
+ *
+ */
+static void ble_user_read(sl_bt_evt_gatt_server_user_read_request_t *req)
+{
+  uint16_t sent;
+  sl_status_t sc;
+
+  if (req->characteristic == gattdb_energy_report) {
+      uint8_t report[ENERGY_PACKED_SIZE];
+      uint16_t offset = req->offset;
+      size_t len = energyPackReport(report, sizeof(report));
+
+      if (offset > len) {
+          offset = len;
+      }
+
+      sc = sl_bt_gatt_server_send_user_read_response(req->connection, req->characteristic, 0, len - offset,
+                                                     report + offset, &sent);
+  }
+  else if (req->characteristic == gattdb_log_mask) {
+      /* Log level mask per module, one byte each in LOG_MOD_* order */
+      uint8_t masks[LOG_MOD_COUNT];
+
+      for (uint32_t module = 0; module < LOG_MOD_COUNT; module++) {
+          masks[module] = logGetMask(module);
+      }
+
+      sc = sl_bt_gatt_server_send_user_read_response(req->connection, req->characteristic, 0, sizeof(masks),
+                                                     masks, &sent);
+  }
+  else {
+      sc = sl_bt_gatt_server_send_user_read_response(req->connection, req->characteristic,
+                                                     (uint8_t) SL_STATUS_BT_ATT_REQUEST_NOT_SUPPORTED,
+                                                     0, NULL, &sent);
+  }
+
+  if (sc != SL_STATUS_OK) {
+      LOG_ERROR("sl_bt_gatt_server_send_user_read_response() returned non-zero status=0x%04x\n\r", (unsigned int) sc);
+  }
+}
+
+/*
+ * Function Name: ble_user_write
+ *
+ * Parameters:
+ * sl_bt_evt_gatt_server_user_write_request_t *req Write request
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function applies a write of the log mask characteristic, which
+ * sets the masks of the first len modules. Writes of ota_control are handled
+ * by the OTA DFU component and are left alone here.
+ *
+ */
+static void ble_user_write(sl_bt_evt_gatt_server_user_write_request_t *req)
+{
+  if (req->characteristic != gattdb_log_mask) {
+      return;
+  }
+
+  for (uint32_t module = 0; module < req->value.len && module < LOG_MOD_COUNT; module++) {
+      logSetMask(module, req->value.data[module]);
+  }
+
+  sl_status_t sc = sl_bt_gatt_server_send_user_write_response(req->connection, req->characteristic, 0);
+  if (sc != SL_STATUS_OK) {
+      LOG_ERROR("sl_bt_gatt_server_send_user_write_response() returned non-zero status=0x%04x\n\r", (unsigned int) sc);
+  }
+}
+
+void handle_ble_event(sl_bt_msg_t *evt)
+{
+  switch (SL_BT_MSG_ID(evt->header)) {
+
+    // An open connection keeps the device out of EM3
+    case sl_bt_evt_connection_opened_id:
+      powerRequire(powerReasonBleConnected);
+      break;
+
+    case sl_bt_evt_connection_closed_id:
+      powerRelease(powerReasonBleConnected);
+      break;
+
+    case sl_bt_evt_gatt_server_user_read_request_id:
+      ble_user_read(&evt->data.evt_gatt_server_user_read_request);
+      break;
+
+    case sl_bt_evt_gatt_server_user_write_request_id:
+      ble_user_write(&evt->data.evt_gatt_server_user_write_request);
+      break;
+
+    default:
+      break;
+  }
+}
@@ -0,0 +1,31 @@
+/*
+* File Name: ble.h
+* File Description: This file contains the declarations for the Bluetooth
+* event handling in ble.c
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#ifndef SRC_BLE_H_
+#define SRC_BLE_H_
+
+#include "sl_bluetooth.h"
+
+/*
+ * Function Name: handle_ble_event
+ *
+ * Parameters:
+ * sl_bt_msg_t *evt Event from the Bluetooth stack
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function handles the Bluetooth stack events of the application:
+ * an open connection holds the device out of EM3, and the user characteristics
+ * (energy report, log mask) are read and written here. Reads of any other user
+ * characteristic get an error response so the client does not time out.
+ *
+ */
+void handle_ble_event(sl_bt_msg_t *evt);
+
+#endif /* SRC_BLE_H_ */
@@ -12,480 +12,822 @@
 **/
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "em_chip.h"
 #include "em_device.h"
 #include "em_i2c.h"
 #include "em_gpio.h"
-#include "sl_i2cspm.h"
+#include "src/i2c.h"
 #include "src/timers.h"
 #include "src/gpio.h"
+#include "src/scheduler.h"
+#include "src/task.h"
+#include "src/bme680.h"
+#include "src/bme680_comp.h"
+#include "src/bme680_cache.h"
 
 #define INCLUDE_LOG_DEBUG 1
+#define LOG_MODULE LOG_MOD_BME680
 #include "src/log.h"
 
-#define BME_680_DEVICE_ADDR 0x76 /* Slave address for BME 280 */
+#define BME_680_DEVICE_ADDR BME680_I2C_ADDR /* Slave address for BME680 */
 
-#define MS_DELAY_80 80000
-#define MS_DELAY_10_8 10800
+#define BME680_RESET_MS 10 /* Start-up time after a soft reset, as used by the Bosch driver */
 
-I2C_TransferReturn_TypeDef transferStatus;
-I2C_TransferSeq_TypeDef transferSequence;
-uint8_t cmd_data; /* Send commands to the Si7021 sensor*/
-uint8_t buffer[2]; /* Read buffer used to store temperature values*/
+/* Oversampling settings, register encoding 0 (skipped), 1 (x1) .. 5 (x16) */
+#define BME680_OSRS_T 0x02 /* x2 */
+#define BME680_OSRS_P 0x05 /* x16 */
+#define BME680_OSRS_H 0x01 /* x1 */
+
+#define BME680_CTRL_MEAS_SLEEP  ((BME680_OSRS_T << 5) | (BME680_OSRS_P << 2))
+#define BME680_CTRL_MEAS_FORCED (BME680_CTRL_MEAS_SLEEP | 0x01)
+
+#define BME680_RUN_GAS (0x01 << 4) /* ctrl_gas_1 run_gas bit, nb_conv in bits 3:0 */
+
+#define BME680_HEATER_STEPS  10 /* res_heat_0..9 and gas_wait_0..9 */
+#define BME680_AMB_DEFAULT   25 /* degC, ambient assumed before the first sample */
+#define BME680_AMB_REPROGRAM 3  /* degC of ambient drift that recomputes the set-points */
+
+#define BME680_POLL_MS 2 /* Retry interval when new_data is not set yet */
+
+#define BME680_CALIB_RETRIES  3   /* Calibration reads tried before the task gives up */
+#define BME680_CALIB_RETRY_MS 100 /* Wait between calibration read attempts */
 
 uint8_t new_buffer[3]; /* Read buffer used to store temperature values*/
 
 /*
- * Function Name: i2c_Init
+ * Function Name: bme680_write_reg
  *
  * Parameters:
- * none
+ * uint8_t reg Register address
+ * uint8_t data Register value
  *
  * Returns:
  * none
  *
- * Brief: This function initializes the I2C peripheral.
+ * Brief: This function writes one BME680 register through the I2C bus manager.
  *
  */
-void i2c_Init(void)
+static void bme680_write_reg(uint8_t reg, uint8_t data)
 {
-  /* Initialize the I2C hardware using I2CSPM_Init_TypeDef*/
-  I2CSPM_Init_TypeDef I2C_Config = {
-    .port = I2C0,
-    .sclPort = gpioPortC,
-    .sclPin = 10,
-    .sdaPort = gpioPortC,
-    .sdaPin = 11,
-    .portLocationScl = 14,
-    .portLocationSda = 16,
-    .i2cRefFreq = 0,
-//    .i2cMaxFreq = I2C_FREQ_STANDARD_MAX,
-    .i2cMaxFreq = I2C_FREQ_FAST_MAX,
-    .i2cClhr = i2cClockHLRStandard
-  };
-
-  I2CSPM_Init(&I2C_Config);
+  I2C_TransferReturn_TypeDef transferStatus = i2c_bus_write_reg(I2C_DEV_BME680, reg, data);
+  if (transferStatus != i2cTransferDone) {
+      LOG_ERROR_LIMITED("i2c_bus_write_reg: I2C bus write of cmd = %02X with error code: %d\n\r", reg, transferStatus);
+  }
 }
 
-
-
 /*
- * Function Name: I2C_Write
+ * Function Name: bme680_read_regs
  *
  * Parameters:
- * none
+ * uint8_t reg First register address
+ * uint8_t *buf Read buffer
+ * uint16_t len Number of bytes to read
  *
  * Returns:
  * none
  *
- * Brief: This function writes a value (command/data) to the I2C slave device based on
- * transferSequence structure values.
+ * Brief: This function reads consecutive BME680 registers through the I2C bus
+ * manager.
  *
  */
-static void I2C_Write_Reset(void)
+static void bme680_read_regs(uint8_t reg, uint8_t *buf, uint16_t len)
 {
-  cmd_data = 0xE0;
-  uint8_t data = 0xB6;
-  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-  transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-  transferSequence.buf[0].data = &cmd_data;
-  transferSequence.buf[0].len = sizeof(cmd_data);
-  transferSequence.buf[1].data = &data;
-  transferSequence.buf[1].len = 1;
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
+  I2C_TransferReturn_TypeDef transferStatus = i2c_bus_read_regs(I2C_DEV_BME680, reg, buf, len);
   if (transferStatus != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
+      LOG_ERROR_LIMITED("i2c_bus_read_regs: I2C bus write of cmd = %02X with error code: %d\n\r", reg, transferStatus);
   }
 }
 
-/* Function to set BME680 in forced mode */
-static void I2C_Set_Mode_Forced(void)
+/* Soft reset, writes 0xB6 to the reset register */
+static const uint8_t bme680_reset_cmd[] = {BME680_REG_RESET, BME680_SOFT_RESET};
+
+/* Oversampling and gas settings as register/data pairs, ctrl_hum only takes
+ * effect with the ctrl_meas write that follows it */
+static const uint8_t bme680_config_cmd[] = {
+    BME680_REG_CTRL_HUM, BME680_OSRS_H,            /* Humidity oversampling */
+    BME680_REG_CTRL_MEAS, BME680_CTRL_MEAS_SLEEP,  /* Temperature and pressure oversampling, sleep mode */
+    BME680_REG_CTRL_GAS_0, 0x00,                   /* heat_off cleared so the heater runs during gas conversions */
+};
+
+/* Function to set config for BME280*/
+static void I2C_Set_IIR_Filter(void)
 {
-  cmd_data = 0x74; /* Control Meas register*/
-  uint8_t temp_buffer[2]; // Temporary buffer to store ctrl meas contents
-//  uint8_t data = (0x02 << 5) | (0x05 << 2) | 0x01; // Temperature oversampling, pressure oversampling, forced mode
-  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-  transferSequence.flags = I2C_FLAG_WRITE_READ;
-  transferSequence.buf[0].data = &cmd_data;
-  transferSequence.buf[0].len = sizeof(cmd_data);
-  transferSequence.buf[1].data = temp_buffer;
-  transferSequence.buf[1].len = sizeof(temp_buffer);
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-  }
+  uint8_t data = 0x01 << 2; /* Filter coefficient*/
+  bme680_write_reg(0x75, data); /* Config register */
+}
 
-  LOG_INFO("BME680 CTRL_MEAS register data is 0x%02X\n\r", temp_buffer[0]);
+/* Register block read as part of a burst */
+typedef struct {
+  uint8_t addr;   /* First register of the block */
+  uint8_t len;    /* Number of registers */
+  uint8_t *data;  /* Destination for the block */
+} bme680_block_t;
 
-  uint8_t data = temp_buffer[0] | 0x01; // Temperature oversampling, pressure oversampling, forced mode
-  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-  transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-  transferSequence.buf[0].data = &cmd_data;
-  transferSequence.buf[0].len = sizeof(cmd_data);
-  transferSequence.buf[1].data = data;
-  transferSequence.buf[1].len = sizeof(data);
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-  }
+#define BME680_BURST_MAX 64 /* Longest merged burst, bounded by burst_buffer */
 
-}
+static uint8_t burst_buffer[BME680_BURST_MAX]; /* Receives bursts spanning more than one block */
 
-/* Function to set oversampling for humidity*/
-static void I2C_Set_Oversampling_Hum(void)
+/*
+ * Function Name: bme680_plan_burst
+ *
+ * Parameters:
+ * const bme680_block_t *blocks Register blocks sorted by ascending address
+ * uint8_t count Number of blocks
+ * uint8_t first First block of the burst
+ * uint16_t *len Set to the number of registers in the burst
+ *
+ * Returns:
+ * uint8_t Last block of the burst
+ *
+ * Brief: This function merges neighbouring blocks separated by at most
+ * BME680_BURST_GAP_MAX unused registers into one auto-incrementing read.
+ *
+ */
+static uint8_t bme680_plan_burst(const bme680_block_t *blocks, uint8_t count, uint8_t first, uint16_t *len)
 {
-  cmd_data = 0x72; /* Control Hum register*/
-  uint8_t data = 0x01; // Temperature oversampling, pressure oversampling, forced mode
-  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-  transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-  transferSequence.buf[0].data = &cmd_data;
-  transferSequence.buf[0].len = sizeof(cmd_data);
-  transferSequence.buf[1].data = &data;
-  transferSequence.buf[1].len = 1;
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
+  uint8_t last = first;
+  uint16_t end = blocks[first].addr + blocks[first].len;
+
+  /* Extend the burst while the next block is close enough and fits */
+  while (last + 1 < count) {
+      const bme680_block_t *next = &blocks[last + 1];
+      uint16_t next_end = next->addr + next->len;
+
+      if (next_end < end) {
+          next_end = end;
+      }
+
+      if ((next->addr > end + BME680_BURST_GAP_MAX) ||
+          (next_end - blocks[first].addr > BME680_BURST_MAX)) {
+          break;
+      }
+
+      end = next_end;
+      last++;
   }
+
+  *len = end - blocks[first].addr;
+
+  return last;
 }
 
-/* Function to set oversampling for temperature and pressure*/
-static void I2C_Set_Oversampling_Temp_Pres(void)
+/*
+ * Function Name: bme680_burst_dest
+ *
+ * Parameters:
+ * const bme680_block_t *blocks Register blocks
+ * uint8_t first First block of the burst
+ * uint8_t last Last block of the burst
+ *
+ * Returns:
+ * uint8_t * Buffer the burst is read into
+ *
+ * Brief: This function returns where a burst is read to; a block read on its
+ * own goes straight to its destination, merged bursts go through
+ * burst_buffer.
+ *
+ */
+static uint8_t *bme680_burst_dest(const bme680_block_t *blocks, uint8_t first, uint8_t last)
 {
-  cmd_data = 0x74; /* Control Meas register*/
-  uint8_t data = (0x02 << 5) | (0x05 << 2); // Temperature oversampling, pressure oversampling, forced mode
-  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-  transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-  transferSequence.buf[0].data = &cmd_data;
-  transferSequence.buf[0].len = sizeof(cmd_data);
-  transferSequence.buf[1].data = &data;
-  transferSequence.buf[1].len = 1;
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-  }
+  return (last == first) ? blocks[first].data : burst_buffer;
 }
 
-/* Function to set config for BME280*/
-static void I2C_Set_IIR_Filter(void)
+/*
+ * Function Name: bme680_split_burst
+ *
+ * Parameters:
+ * const bme680_block_t *blocks Register blocks
+ * uint8_t first First block of the burst
+ * uint8_t last Last block of the burst
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function copies a merged burst from burst_buffer back into its
+ * blocks.
+ *
+ */
+static void bme680_split_burst(const bme680_block_t *blocks, uint8_t first, uint8_t last)
 {
-  cmd_data = 0x75; /* Config register */
-  uint8_t data = 0x01 << 2; /* Filter coefficient*/
-  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-  transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-  transferSequence.buf[0].data = &cmd_data;
-  transferSequence.buf[0].len = sizeof(cmd_data);
-  transferSequence.buf[1].data = &data;
-  transferSequence.buf[1].len = 1;
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
+  if (last == first) {
+      return;
   }
-}
 
-/* Function to set ctrl gas 1 for BME680*/
-static void I2C_Set_Ctrl_Gas_1(void)
-{
-  cmd_data = 0x71; /* ctrl gas 1 register */
-  uint8_t data = (0x01 << 4) | (0x01); /* run_gas and heater set-point*/
-//  0b11111000
-  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-  transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-  transferSequence.buf[0].data = &cmd_data;
-  transferSequence.buf[0].len = sizeof(cmd_data);
-  transferSequence.buf[1].data = &data;
-  transferSequence.buf[1].len = 1;
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
+  for (uint8_t i = first; i <= last; i++) {
+      memcpy(blocks[i].data, &burst_buffer[blocks[i].addr - blocks[first].addr], blocks[i].len);
   }
 }
 
-/* Function to set ctrl gas 0 for BME680*/
-static void I2C_Set_Ctrl_Gas_0(void)
+/*
+ * Function Name: bme680_read_blocks
+ *
+ * Parameters:
+ * const bme680_block_t *blocks Register blocks sorted by ascending address
+ * uint8_t count Number of blocks
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function reads a set of register blocks with the fewest burst
+ * reads, blocking until each burst has completed.
+ *
+ */
+static void bme680_read_blocks(const bme680_block_t *blocks, uint8_t count)
 {
-  cmd_data = 0x70; /* ctrl gas 1 register */
-  uint8_t data = (0x01 << 3); /* run_gas and heater set-point*/
-  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-  transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-  transferSequence.buf[0].data = &cmd_data;
-  transferSequence.buf[0].len = sizeof(cmd_data);
-  transferSequence.buf[1].data = &data;
-  transferSequence.buf[1].len = 1;
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
+  uint8_t first = 0;
+
+  while (first < count) {
+      uint16_t len;
+      uint8_t last = bme680_plan_burst(blocks, count, first, &len);
+
+      bme680_read_regs(blocks[first].addr, bme680_burst_dest(blocks, first, last), len);
+      bme680_split_burst(blocks, first, last);
+
+      first = last + 1;
   }
 }
 
-static void set_res_heat_0(void)
+// Calibration parameters
+static bme680_calib_t calib;
+
+static uint8_t coeff1[BME680_COEFF1_LEN]; /* 0x89..0xA1 */
+static uint8_t coeff2[BME680_COEFF2_LEN]; /* 0xE1..0xF0 */
+static uint8_t coeff3[BME680_COEFF3_LEN]; /* 0x00..0x04 */
+
+static const bme680_block_t calib_blocks[] = {
+    {BME680_COEFF3_ADDR, BME680_COEFF3_LEN, coeff3},
+    {BME680_COEFF1_ADDR, BME680_COEFF1_LEN, coeff1},
+    {BME680_COEFF2_ADDR, BME680_COEFF2_LEN, coeff2},
+};
+
+#define CALIB_BLOCK_COUNT (sizeof(calib_blocks) / sizeof(calib_blocks[0]))
+
+/* Register accessors for the calibration blocks */
+#define C1(reg) coeff1[BME680_OFFSET(BME680_COEFF1_ADDR, reg)]
+#define C2(reg) coeff2[BME680_OFFSET(BME680_COEFF2_ADDR, reg)]
+#define C3(reg) coeff3[BME680_OFFSET(BME680_COEFF3_ADDR, reg)]
+
+/* Little endian 16 bit value from an LSB and MSB register */
+#define U16(lsb, msb) ((uint16_t)((lsb) | ((msb) << 8)))
+
+/*
+ * Function Name: bme680_decode_calibration
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function decodes every temperature, pressure, humidity and gas
+ * coefficient from the raw calibration blocks.
+ *
+ */
+static void bme680_decode_calibration(void)
 {
+  //  Temperature Calibration Parameters
+  calib.par_t1 = U16(C2(0xE9), C2(0xEA));
+  calib.par_t2 = (int16_t)U16(C1(0x8A), C1(0x8B));
+  calib.par_t3 = (int8_t)C1(0x8C);
+
+  // Pressure Calibration Parameters
+  calib.par_p1 = U16(C1(0x8E), C1(0x8F));
+  calib.par_p2 = (int16_t)U16(C1(0x90), C1(0x91));
+  calib.par_p3 = (int8_t)C1(0x92);
+  calib.par_p4 = (int16_t)U16(C1(0x94), C1(0x95));
+  calib.par_p5 = (int16_t)U16(C1(0x96), C1(0x97));
+  calib.par_p7 = (int8_t)C1(0x98);
+  calib.par_p6 = (int8_t)C1(0x99);
+  calib.par_p8 = (int16_t)U16(C1(0x9C), C1(0x9D));
+  calib.par_p9 = (int16_t)U16(C1(0x9E), C1(0x9F));
+  calib.par_p10 = C1(0xA0);
+
+  // Humidity Calibration Parameters, H1 and H2 share the nibbles of 0xE2
+  calib.par_h2 = (uint16_t)((C2(0xE1) << 4) | (C2(0xE2) >> 4));
+  calib.par_h1 = (uint16_t)((C2(0xE3) << 4) | (C2(0xE2) & 0x0F));
+  calib.par_h3 = (int8_t)C2(0xE4);
+  calib.par_h4 = (int8_t)C2(0xE5);
+  calib.par_h5 = (int8_t)C2(0xE6);
+  calib.par_h6 = C2(0xE7);
+  calib.par_h7 = (int8_t)C2(0xE8);
+
+  // Gas Calibration Parameters
+  calib.par_gh2 = (int16_t)U16(C2(0xEB), C2(0xEC));
+  calib.par_gh1 = (int8_t)C2(0xED);
+  calib.par_gh3 = (int8_t)C2(0xEE);
 
+  calib.res_heat_val = (int8_t)C3(BME680_REG_RES_HEAT_VAL);
+  calib.res_heat_range = (C3(BME680_REG_RES_HEAT_RANGE) & 0x30) >> 4;
+  calib.range_sw_err = (int8_t)(C3(BME680_REG_RANGE_SW_ERR) & 0xF0) >> 4; /* Signed 4 bit */
 }
 
-/* Function to set gas wait 0 for BME680*/
-static void I2C_Set_Gas_Wait_0(void)
+/*
+ * Function Name: get_calibration_parameters
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function reads the three calibration blocks in one burst each
+ * and decodes them, blocking until the reads have completed.
+ *
+ */
+void get_calibration_parameters(void)
 {
-  cmd_data = 0x64; /* gas wait 0 register */
-  uint8_t data = 0x41; // 4 ms wait time
-  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-  transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-  transferSequence.buf[0].data = &cmd_data;
-  transferSequence.buf[0].len = sizeof(cmd_data);
-  transferSequence.buf[1].data = &data;
-  transferSequence.buf[1].len = 1;
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-  }
+  bme680_read_blocks(calib_blocks, CALIB_BLOCK_COUNT);
+  bme680_decode_calibration();
 }
 
-/* Function to set res heat 0 for BME680*/
-static void I2C_Set_Res_Heat_0(void)
+/*
+ * Function Name: bme680_get_calibration
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * const bme680_calib_t * Decoded calibration coefficients
+ *
+ * Brief: This function returns the coefficients decoded by
+ * get_calibration_parameters.
+ *
+ */
+const bme680_calib_t *bme680_get_calibration(void)
 {
-  cmd_data = 0x64; /* res heat 0 register */
-  uint8_t data = (0x01 << 4) | (0x01); /* run_gas and heater set-point*/
-  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-  transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-  transferSequence.buf[0].data = &cmd_data;
-  transferSequence.buf[0].len = sizeof(cmd_data);
-  transferSequence.buf[1].data = &data;
-  transferSequence.buf[1].len = 1;
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-  }
+  return &calib;
 }
 
-// Calibration parameters
-uint8_t par_t1_data[2], par_t2_t3_data[3];
-// uint32_t par_t1_32bit, par_t2_32bit, par_t3_32bit;
-uint16_t par_t1;
-int16_t par_t2;
-int8_t par_t3;
+// Latest field 0 data
+static uint8_t field0[BME680_FIELD0_LEN]; /* 0x1D..0x2B */
+static bme680_field_t field;
 
-// Gas calibration parameters
-uint8_t par_g2_g1_g3_data[4];
-int8_t par_gh1, par_gh3;
-int16_t par_gh2;
+#define F0(reg) field0[BME680_OFFSET(BME680_FIELD0_ADDR, reg)]
 
-void get_calibration_parameters(void)
+/*
+ * Function Name: bme680_decode_field
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function decodes the raw field 0 block into field.
+ *
+ */
+static void bme680_decode_field(void)
 {
-//  Temperature Calibration Parameters
-  uint8_t par_t1_addr = 0xE9;
-  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-  transferSequence.flags = I2C_FLAG_WRITE_READ;
-  transferSequence.buf[0].data = &par_t1_addr;
-  transferSequence.buf[0].len = sizeof(par_t1_addr);
-  transferSequence.buf[1].data = par_t1_data;
-  transferSequence.buf[1].len = sizeof(par_t1_data);
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-  }
+  field.status = F0(BME680_REG_MEAS_STATUS_0);
+  field.press_adc = ((uint32_t)F0(0x1F) << 12) | ((uint32_t)F0(0x20) << 4) | (F0(0x21) >> 4);
+  field.temp_adc = ((uint32_t)F0(0x22) << 12) | ((uint32_t)F0(0x23) << 4) | (F0(0x24) >> 4);
+  field.hum_adc = U16(F0(0x26), F0(0x25));
+  field.gas_adc = (uint16_t)((F0(BME680_REG_GAS_R_MSB) << 2) | (F0(BME680_REG_GAS_R_LSB) >> 6));
+  field.gas_range = F0(BME680_REG_GAS_R_LSB) & BME680_GAS_RANGE_MSK;
+  field.gas_status = F0(BME680_REG_GAS_R_LSB) & (BME680_GAS_VALID_MSK | BME680_HEAT_STAB_MSK);
+}
 
-  par_t1 = (uint16_t)(par_t1_data[0] | (par_t1_data[1] << 8));
+/*
+ * Function Name: bme680_read_field
+ *
+ * Parameters:
+ * bme680_field_t *out Decoded raw measurement, may be NULL
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function reads status, pressure, temperature, humidity and gas
+ * ADC values of field 0 in a single burst and decodes them.
+ *
+ */
+void bme680_read_field(bme680_field_t *out)
+{
+  static const bme680_block_t field_block = {BME680_FIELD0_ADDR, BME680_FIELD0_LEN, field0};
 
-  uint8_t par_t2_addr = 0x8A;
-  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-  transferSequence.flags = I2C_FLAG_WRITE_READ;
-  transferSequence.buf[0].data = &par_t2_addr;
-  transferSequence.buf[0].len = sizeof(par_t2_addr);
-  transferSequence.buf[1].data = par_t2_t3_data;
-  transferSequence.buf[1].len = sizeof(par_t2_t3_data);
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
+  bme680_read_blocks(&field_block, 1);
+  bme680_decode_field();
+
+  if (out) {
+      *out = field;
   }
+}
 
-  par_t3 = (int8_t)par_t2_t3_data[2];
+/*
+ * Function Name: I2C_Read_ID
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function reads the BME680 chip ID register into new_buffer.
+ *
+ */
+void I2C_Read_ID(void)
+{
+  bme680_read_regs(BME680_REG_CHIP_ID, new_buffer, sizeof(new_buffer)); /* Chip ID register */
+}
 
-  par_t2 = (int16_t)(par_t2_t3_data[0] | (par_t2_t3_data[1] << 8));
+static i2c_request_t measRequest = {.status = i2cTransferDone};
+static uint8_t measCmd[4]; /* Register/data pairs for the trigger, register address for reads */
+static uint8_t parT1[2];   /* par_t1, read to tell sensors apart */
 
-  // Gas Calibration Parameters
-  uint8_t par_g2_addr = 0xEB;
-  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-  transferSequence.flags = I2C_FLAG_WRITE_READ;
-  transferSequence.buf[0].data = &par_g2_addr;
-  transferSequence.buf[0].len = sizeof(par_g2_addr);
-  transferSequence.buf[1].data = par_g2_g1_g3_data;
-  transferSequence.buf[1].len = sizeof(par_g2_g1_g3_data);
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-  }
+static uint8_t heaterStep; /* Heater set-point used by the next forced measurement */
 
-  par_gh2 = (int16_t)(par_g2_g1_g3_data[0] | (par_g2_g1_g3_data[1] << 8));
-  par_gh1 = (int8_t)par_g2_g1_g3_data[2];
-  par_gh3 = (int8_t)par_g2_g1_g3_data[3];
-
-  uint8_t res_heat_val_addr = 0x00;
-  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-  transferSequence.flags = I2C_FLAG_WRITE_READ;
-  transferSequence.buf[0].data = &res_heat_val_addr;
-  transferSequence.buf[0].len = sizeof(res_heat_val_addr);
-  transferSequence.buf[1].data = par_g2_g1_g3_data;
-  transferSequence.buf[1].len = sizeof(par_g2_g1_g3_data);
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-  }
+/*
+ * Function Name: bme680_prepare_write
+ *
+ * Parameters:
+ * const uint8_t *pairs Register address/data pairs
+ * uint16_t len Number of bytes
+ *
+ * Returns:
+ * i2c_request_t * The filled in measurement request
+ *
+ * Brief: This function sets up measRequest as a write of register/data pairs
+ * that sets evtI2C0_Transfer_Done when it completes.
+ *
+ */
+static i2c_request_t *bme680_prepare_write(const uint8_t *pairs, uint16_t len)
+{
+  measRequest.device = I2C_DEV_BME680;
+  measRequest.seq.flags = I2C_FLAG_WRITE;
+  measRequest.seq.buf[0].data = (uint8_t *)pairs;
+  measRequest.seq.buf[0].len = len;
+  measRequest.seq.buf[1].data = NULL;
+  measRequest.seq.buf[1].len = 0;
+  measRequest.callback = NULL;
+
+  return &measRequest;
 }
 
-void BME680_init(void)
+/*
+ * Function Name: bme680_prepare_read
+ *
+ * Parameters:
+ * uint8_t reg First register address
+ * uint8_t *buf Read buffer
+ * uint16_t len Number of bytes to read
+ *
+ * Returns:
+ * i2c_request_t * The filled in measurement request
+ *
+ * Brief: This function sets up measRequest as a burst read that sets
+ * evtI2C0_Transfer_Done when it completes.
+ *
+ */
+static i2c_request_t *bme680_prepare_read(uint8_t reg, uint8_t *buf, uint16_t len)
 {
-  i2c_Init();
-  I2C_Write_Reset();
-  timerWaitUs(MS_DELAY_80);
-
-  I2C_Set_Oversampling_Temp_Pres();
+  measCmd[0] = reg;
 
-  I2C_Set_Gas_Wait_0();
-
-  I2C_Set_Ctrl_Gas_0();
-  I2C_Set_Res_Heat_0();
-  I2C_Set_Ctrl_Gas_1();
+  measRequest.device = I2C_DEV_BME680;
+  measRequest.seq.flags = I2C_FLAG_WRITE_READ;
+  measRequest.seq.buf[0].data = measCmd;
+  measRequest.seq.buf[0].len = 1;
+  measRequest.seq.buf[1].data = buf;
+  measRequest.seq.buf[1].len = len;
+  measRequest.callback = NULL;
 
+  return &measRequest;
 }
 
-// Temperature compensated value
-int16_t temp_comp;
-
-static void Compute_Temperature(void)
+/*
+ * Function Name: bme680_transfer_ok
+ *
+ * Parameters:
+ * const char *what Transfer name for the error message
+ *
+ * Returns:
+ * bool true if the last measRequest transfer succeeded
+ *
+ * Brief: This function checks and logs the result of a measRequest transfer.
+ *
+ */
+static bool bme680_transfer_ok(const char *what)
 {
-  uint8_t temp_adc[3];
-  uint8_t temp_adc_addr = 0x22;
-  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-  transferSequence.flags = I2C_FLAG_WRITE_READ;
-  transferSequence.buf[0].data = &temp_adc_addr;
-  transferSequence.buf[0].len = sizeof(temp_adc_addr);
-  transferSequence.buf[1].data = temp_adc;
-  transferSequence.buf[1].len = sizeof(temp_adc);
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
+  if (measRequest.status != i2cTransferDone) {
+      LOG_ERROR_LIMITED("BME680 %s failed with error code: %d\n\r", what, measRequest.status);
+      return false;
   }
 
-  uint32_t temp_32_bit = (temp_adc[1] << 4) | (temp_adc[0] << 12) | ((temp_adc[2] & 0xF0) >> 4);
+  return true;
+}
 
-  int64_t var1 = ((int32_t)temp_32_bit >> 3) - ((int32_t)par_t1 << 1);
-  int64_t var2 = (var1 * (int32_t)par_t2) >> 11;
-  int64_t var3 = ((((var1 >> 1)*(var1 >> 1)) >> 12)*(par_t3 << 4)) >> 14;
-  int32_t t_fine = (int32_t)(var2 + var3);
-  temp_comp = (int16_t)((t_fine*5) + 128) >> 8;
+/*
+ * Function Name: bme680_prepare_trigger
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * i2c_request_t * The filled in measurement request
+ *
+ * Brief: This function sets up the write that selects the current heater step
+ * in ctrl_gas_1 and starts a forced measurement in ctrl_meas.
+ *
+ */
+static i2c_request_t *bme680_prepare_trigger(void)
+{
+  measCmd[0] = BME680_REG_CTRL_GAS_1;
+  measCmd[1] = BME680_RUN_GAS | heaterStep;
+  measCmd[2] = BME680_REG_CTRL_MEAS;
+  measCmd[3] = BME680_CTRL_MEAS_FORCED;
 
+  return bme680_prepare_write(measCmd, sizeof(measCmd));
 }
 
-uint8_t gas_adc_range[2];
-uint8_t range_switching_error;
+/* Heater profile, one step per forced measurement */
+typedef struct {
+  uint16_t temp;   /* Heater target in degC */
+  uint16_t dur_ms; /* Heater on time in ms */
+} bme680_heater_step_t;
 
-uint32_t lookup_table_gas[16] = {
-    4096000000, 2048000000, 1024000000,
-    512000000, 255744255, 127110228, 64000000,
-    32258064, 16016016, 8000000, 4000000,
-    2000000, 1000000, 500000, 250000, 125000
+static const bme680_heater_step_t heater_profile[BME680_HEATER_STEPS] = {
+    {200, 150}, {240, 100}, {280, 100}, {320, 100}, {360, 100},
+    {400, 100}, {360, 100}, {320, 100}, {280, 100}, {240, 100},
 };
 
-const int array1_int = 2147483647;
+/* res_heat_x and gas_wait_x as register/data pairs, written in one transaction */
+static uint8_t heaterCmd[4 * BME680_HEATER_STEPS];
 
-void Compute_AIQ(void)
+static int16_t heaterAmbient;  /* Ambient the set-points were computed for, degC */
+static uint32_t gas_fingerprint[BME680_HEATER_STEPS]; /* Last gas resistance per step */
+
+/*
+ * Function Name: bme680_build_heater_table
+ *
+ * Parameters:
+ * int16_t amb_temp Ambient temperature in degC
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function computes all heater set-points and on times of the
+ * profile into heaterCmd. The BME680 does not auto-increment on I2C writes,
+ * so every register is sent as an address/data pair.
+ *
+ */
+static void bme680_build_heater_table(int16_t amb_temp)
 {
-  uint8_t gas_adc_addr = 0x2A;
-  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-  transferSequence.flags = I2C_FLAG_WRITE_READ;
-  transferSequence.buf[0].data = &gas_adc_addr;
-  transferSequence.buf[0].len = sizeof(gas_adc_addr);
-  transferSequence.buf[1].data = gas_adc_range;
-  transferSequence.buf[1].len = sizeof(gas_adc_range);
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-  }
+  for (uint8_t i = 0; i < BME680_HEATER_STEPS; i++) {
+      heaterCmd[2 * i] = BME680_REG_RES_HEAT_0 + i;
+      heaterCmd[2 * i + 1] = bme680_calc_res_heat(&calib, heater_profile[i].temp, amb_temp);
 
-  uint8_t range_switching_addr = 0x04;
-  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-  transferSequence.flags = I2C_FLAG_WRITE_READ;
-  transferSequence.buf[0].data = &range_switching_addr;
-  transferSequence.buf[0].len = sizeof(range_switching_addr);
-  transferSequence.buf[1].data = &range_switching_error;
-  transferSequence.buf[1].len = 1;
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
+      heaterCmd[2 * (BME680_HEATER_STEPS + i)] = BME680_REG_GAS_WAIT_0 + i;
+      heaterCmd[2 * (BME680_HEATER_STEPS + i) + 1] = bme680_calc_gas_wait(heater_profile[i].dur_ms);
   }
 
-
-
+  heaterAmbient = amb_temp;
 }
 
 /*
- * Function Name: I2C_Read_ID
+ * Function Name: bme680_get_gas_fingerprint
  *
  * Parameters:
  * none
  *
  * Returns:
- * none
+ * const uint32_t * Gas resistance in Ohm of each of the BME680_HEATER_STEPS
+ * heater steps, 0 while a step has no valid reading
  *
- * Brief: This function writes a value (command/data) to the I2C slave device based on
- * transferSequence structure values.
+ * Brief: This function returns the latest gas resistance per heater step.
  *
  */
-void I2C_Read_ID(void)
+const uint32_t *bme680_get_gas_fingerprint(void)
 {
-  cmd_data = 0xD0;
-  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-  transferSequence.flags = I2C_FLAG_WRITE_READ;
-  transferSequence.buf[0].data = &cmd_data;
-  transferSequence.buf[0].len = sizeof(cmd_data);
-  transferSequence.buf[1].data = new_buffer;
-  transferSequence.buf[1].len = sizeof(new_buffer);
-  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-  if (transferStatus != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-  }
+  return gas_fingerprint;
 }
 
-
 /*
- * Function Name: read_BME680
+ * Function Name: bme680_meas_duration_ms
  *
  * Parameters:
- * none
+ * uint8_t step Heater profile step
  *
  * Returns:
- * none
+ * uint32_t TPHG conversion time in ms
  *
- * Brief: This function is used to read and measure the temperature in degrees
- * Celsius from the Si7021 sensor. The temperature values are logged onto UART.
+ * Brief: This function computes the forced mode conversion time from the
+ * oversampling settings and the heater on time of a step, following the Bosch profile
+ * duration formula.
  *
  */
-void read_BME680(void)
+static uint32_t bme680_meas_duration_ms(uint8_t step)
 {
-  /* The below sequence is written based on the datasheet sequence and considerations for Si7021*/
-  Si7021Enable();
-  /* The below sequence is written based on the datasheet sequence and considerations for BME280*/
-  I2C_Write_Reset();
-  timerWaitUs(MS_DELAY_80);
-  i2c_Init();
+  static const uint8_t os_to_meas_cycles[6] = {0, 1, 2, 4, 8, 16};
 
-  I2C_Read_ID();
+  uint32_t meas_cycles = os_to_meas_cycles[BME680_OSRS_T] + os_to_meas_cycles[BME680_OSRS_P] +
+                         os_to_meas_cycles[BME680_OSRS_H];
 
-  LOG_INFO("BME680 (0x%2X) Chip ID registor (0x%D0) is 0x%02X\n\r", BME_680_DEVICE_ADDR, new_buffer[0]);
+  uint32_t tph_dur = meas_cycles * 1963;
+  tph_dur += 477 * 4; /* TPH switching */
+  tph_dur += 477 * 5; /* Gas measurement */
+  tph_dur += 500; /* Round to the closest ms */
+  tph_dur /= 1000;
+  tph_dur += 1; /* Wake up */
+
+  /* Heater on time as programmed, the encoding drops low bits above 63 ms */
+  tph_dur += bme680_gas_wait_ms(bme680_calc_gas_wait(heater_profile[step].dur_ms));
+
+  return tph_dur;
 }
 
+// Latest compensated measurement, ambient defaults until the first sample
+static bme680_data_t sample = {.temperature = BME680_AMB_DEFAULT * 100};
+
+static task_t bme680Task;
+
+/* Queue a transfer on measRequest and wait for it to complete, retrying while
+ * the bus queue is full */
+#define BME680_TRANSFER(task, req)                 \
+  do {                                             \
+      while (!i2c_bus_submit(req)) {               \
+          TASK_SLEEP_MS((task), BME680_POLL_MS);   \
+      }                                            \
+      TASK_WAIT_I2C((task), &measRequest);         \
+  } while (0)
 
-void read_temp(void)
+/*
+ * Function Name: bme680_task
+ *
+ * Parameters:
+ * task_t *task The BME680 task
+ *
+ * Returns:
+ * char Protothread state
+ *
+ * Brief: This function is the BME680 driver as one sequence. It resets the
+ * sensor, checks the chip ID, programs oversampling and heater settings and
+ * loads the calibration, from the flash cache when it matches the attached
+ * sensor and over I2C otherwise. A wrong chip ID, a failed configuration write
+ * or a calibration that cannot be read ends the task, nothing is cached then.
+ * If par_t1 cannot be read the cache is skipped. It then runs one forced mode
+ * measurement per LETIMER0 underflow: the forced mode write is queued on the
+ * bus, the task sleeps for the TPHG conversion time and burst reads the field
+ * 0 block. The task yields on every bus transfer and timer, so the core sleeps
+ * or serves other tasks in between.
+ *
+ */
+static char bme680_task(task_t *task)
 {
+  static uint8_t burst, last, attempt;
+  static bool calib_ok, id_ok;
+  static uint16_t len;
+  static uint16_t polls;
+  static uint32_t sensor_id, wait_ms;
+
+  PT_BEGIN(&task->pt);
+
   Si7021Enable();
-  /* The below sequence is written based on the datasheet sequence and considerations for BME280*/
 
-//  I2C_Set_IIR_Filter();
-  I2C_Set_Mode_Forced();
-  timerWaitUs(5000); // 5ms wait
-  Compute_Temperature();
+  BME680_TRANSFER(task, bme680_prepare_write(bme680_reset_cmd, sizeof(bme680_reset_cmd)));
+  TASK_SLEEP_MS(task, BME680_RESET_MS);
+
+  BME680_TRANSFER(task, bme680_prepare_read(BME680_REG_CHIP_ID, new_buffer, sizeof(new_buffer)));
+  if (!bme680_transfer_ok("chip ID read")) {
+      PT_EXIT(&task->pt);
+  }
+  LOG_INFO("BME680 (0x%2X) Chip ID registor (0x%D0) is 0x%02X\n\r", BME_680_DEVICE_ADDR, new_buffer[0]);
+
+  /* Nothing else at this address is a BME680, its calibration must not be cached */
+  if (new_buffer[0] != BME680_CHIP_ID) {
+      LOG_ERROR("BME680 chip ID 0x%02X does not match 0x%02X, sensor not started\n\r",
+                new_buffer[0], BME680_CHIP_ID);
+      PT_EXIT(&task->pt);
+  }
+
+  BME680_TRANSFER(task, bme680_prepare_write(bme680_config_cmd, sizeof(bme680_config_cmd)));
+  if (!bme680_transfer_ok("configuration write")) {
+      LOG_ERROR("BME680 could not be configured, sensor not started\n\r");
+      PT_EXIT(&task->pt);
+  }
+
+  /* The chip ID alone is the same on every part, par_t1 tells sensors apart.
+   * Without it the sensor is unknown and the cache is neither used nor written */
+  BME680_TRANSFER(task, bme680_prepare_read(0xE9, parT1, sizeof(parT1)));
+  id_ok = bme680_transfer_ok("par_t1 read");
+  sensor_id = ((uint32_t)new_buffer[0] << 16) | U16(parT1[0], parT1[1]);
 
+  if (id_ok && bme680_cache_load(sensor_id, &calib)) {
+      LOG_INFO("BME680 calibration loaded from flash\n\r");
+  }
+  else {
+      /* Coefficients from a failed burst would be cached with a valid CRC and
+       * reused on every boot, so the whole set is read again instead */
+      calib_ok = false;
+      for (attempt = 0; attempt < BME680_CALIB_RETRIES && !calib_ok; attempt++) {
+          if (attempt) {
+              TASK_SLEEP_MS(task, BME680_CALIB_RETRY_MS);
+          }
+
+          calib_ok = true;
+          for (burst = 0; burst < CALIB_BLOCK_COUNT && calib_ok; burst = last + 1) {
+              last = bme680_plan_burst(calib_blocks, CALIB_BLOCK_COUNT, burst, &len);
+              BME680_TRANSFER(task, bme680_prepare_read(calib_blocks[burst].addr,
+                                                        bme680_burst_dest(calib_blocks, burst, last), len));
+              calib_ok = bme680_transfer_ok("calibration read");
+              bme680_split_burst(calib_blocks, burst, last);
+          }
+      }
+
+      if (!calib_ok) {
+          LOG_ERROR("BME680 calibration could not be read, sensor not started\n\r");
+          PT_EXIT(&task->pt);
+      }
+
+      bme680_decode_calibration();
+
+      if (!id_ok) {
+          LOG_WARN("BME680 calibration not cached, the sensor ID could not be read\n\r");
+      }
+      else if (!bme680_cache_store(sensor_id, &calib)) {
+          LOG_WARN("BME680 calibration could not be cached\n\r");
+      }
+  }
 
-  LOG_INFO("BME680 temperature in celsius is %d\n\r", temp_comp);
+  /* Program all heater set-points, nb_conv selects one per measurement */
+  bme680_build_heater_table(BME680_AMB_DEFAULT);
+  BME680_TRANSFER(task, bme680_prepare_write(heaterCmd, sizeof(heaterCmd)));
+  bme680_transfer_ok("heater profile write");
+
+  heaterStep = 0;
+
+  LOG_INFO("BME680 TPHG conversion time %lu ms\n\r", (unsigned long)bme680_meas_duration_ms(heaterStep));
+
+  for (;;) {
+      TASK_WAIT_EVENT(task, evtLETIMER0_UF);
+
+      /* Recompute the set-points between profile passes if the ambient drifted */
+      if (heaterStep == 0 && abs(sample.temperature / 100 - heaterAmbient) >= BME680_AMB_REPROGRAM) {
+          bme680_build_heater_table(sample.temperature / 100);
+          BME680_TRANSFER(task, bme680_prepare_write(heaterCmd, sizeof(heaterCmd)));
+          bme680_transfer_ok("heater profile write");
+      }
+
+      BME680_TRANSFER(task, bme680_prepare_trigger());
+      if (!bme680_transfer_ok("forced mode write")) {
+          continue;
+      }
+
+      /* Sleep for the conversion, then poll until new_data is set, for at
+       * most one more conversion time */
+      wait_ms = bme680_meas_duration_ms(heaterStep);
+      polls = wait_ms / BME680_POLL_MS + 1;
+      do {
+          TASK_SLEEP_MS(task, wait_ms);
+          wait_ms = BME680_POLL_MS;
+
+          BME680_TRANSFER(task, bme680_prepare_read(BME680_FIELD0_ADDR, field0, sizeof(field0)));
+          if (!bme680_transfer_ok("field read")) {
+              field.status = 0;
+              break;
+          }
+
+          bme680_decode_field();
+      } while (!(field.status & BME680_NEW_DATA_MSK) && polls--);
+
+      if (!(field.status & BME680_NEW_DATA_MSK)) {
+          if (polls == UINT16_MAX) {
+              LOG_ERROR_LIMITED("BME680 new_data not set %lu ms after the conversion time, step %u\n\r",
+                                (unsigned long)bme680_meas_duration_ms(heaterStep), heaterStep);
+          }
+          continue;
+      }
+
+      bme680_compensate(&calib, &field, &sample);
+
+      /* Only keep gas readings taken with the heater at its set-point */
+      gas_fingerprint[heaterStep] = (field.gas_status & BME680_HEAT_STAB_MSK) ? sample.gas_resistance : 0;
+
+      LOG_INFO("BME680 T %d.%02d C P %lu Pa H %lu.%03lu %%RH gas %lu Ohm at %u C (step %u)\n\r",
+               sample.temperature / 100, abs(sample.temperature % 100), (unsigned long)sample.pressure,
+               (unsigned long)(sample.humidity / 1000), (unsigned long)(sample.humidity % 1000),
+               (unsigned long)sample.gas_resistance, heater_profile[heaterStep].temp, heaterStep);
+
+      heaterStep = (heaterStep + 1) % BME680_HEATER_STEPS;
+  }
 
+  PT_END(&task->pt);
+}
 
+/*
+ * Function Name: BME680_init
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function starts the BME680 task, which initializes the sensor
+ * without blocking and then measures once per LETIMER0 underflow. The bus
+ * must already be initialized with i2c_Init.
+ *
+ */
+void BME680_init(void)
+{
+  taskStart(&bme680Task, bme680_task, "bme680");
 }
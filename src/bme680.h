@@ -8,14 +8,88 @@
 #ifndef SRC_BME680_H_
 #define SRC_BME680_H_
 
+#include <stdint.h>
+#include "src/bme680_regs.h"
 
-void i2c_Init(void);
-
+/*
+ * Function Name: get_calibration_parameters
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function burst reads the calibration blocks 0x00..0x04,
+ * 0x89..0xA1 and 0xE1..0xF0 and decodes all coefficients.
+ *
+ */
 void get_calibration_parameters(void);
 
-void read_BME680(void);
+/*
+ * Function Name: bme680_get_calibration
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * const bme680_calib_t * Decoded calibration coefficients
+ *
+ * Brief: This function returns the coefficients read by
+ * get_calibration_parameters.
+ *
+ */
+const bme680_calib_t *bme680_get_calibration(void);
+
+/*
+ * Function Name: bme680_read_field
+ *
+ * Parameters:
+ * bme680_field_t *out Decoded raw measurement, may be NULL
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function burst reads the field 0 data block 0x1D..0x2B and
+ * decodes the status and ADC values.
+ *
+ */
+void bme680_read_field(bme680_field_t *out);
 
-void read_temp(void);
+/*
+ * Function Name: BME680_init
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function starts the BME680 task. The task resets the sensor,
+ * checks the chip ID, programs oversampling and heater settings and loads the
+ * calibration from the flash cache, reading it over I2C only when the cache
+ * does not match the sensor; it then measures once per evtLETIMER0_UF. None
+ * of these steps block. The task stops with an error if the chip ID is not
+ * BME680_CHIP_ID or the calibration cannot be read, and only a calibration
+ * read without errors is cached.
+ *
+ */
+void BME680_init(void);
 
+/*
+ * Function Name: bme680_get_gas_fingerprint
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * const uint32_t * Gas resistance in Ohm of each heater profile step, 0 while
+ * a step has no valid heater stable reading
+ *
+ * Brief: This function returns the latest gas resistance per heater step. The
+ * heater profile advances by one step with every forced measurement.
+ *
+ */
+const uint32_t *bme680_get_gas_fingerprint(void);
 
 #endif /* SRC_BME680_H_ */
@@ -0,0 +1,149 @@
+/*
+* File Name: bme680_cache.c
+* File Description: This file keeps the decoded BME680 calibration in a
+* dedicated flash page so it does not have to be read over I2C on every boot
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#include <stddef.h>
+#include <string.h>
+#include "em_device.h"
+#include "em_msc.h"
+#include "src/bme680_cache.h"
+
+#define INCLUDE_LOG_DEBUG 1
+#define LOG_MODULE LOG_MOD_BME680
+#include "src/log.h"
+
+#define BME680_CACHE_MAGIC 0x30383642 /* "B680" */
+
+/* Cached record, a whole number of words as required by MSC_WriteWord */
+typedef struct {
+  uint32_t magic;
+  uint32_t sensor_id;
+  bme680_calib_t calib;
+  uint32_t crc;
+} bme680_cache_t;
+
+/*
+ * Flash page reserved for the cache. It is page aligned and page sized so
+ * erasing it never touches code, and it is part of the image as erased flash,
+ * so programming new firmware also drops a stale record.
+ */
+static const uint8_t cache_page[FLASH_PAGE_SIZE]
+  __attribute__((aligned(FLASH_PAGE_SIZE), used, section(".text.bme680_cache"))) = {
+    [0 ... FLASH_PAGE_SIZE - 1] = 0xFF
+};
+
+/* The page is rewritten at run time, so it is only read through this pointer
+ * to keep the compiler from folding reads of the 0xFF initializer */
+static const bme680_cache_t *volatile cacheRecord = (const bme680_cache_t *)cache_page;
+
+/*
+ * Function Name: cache_crc32
+ *
+ * Parameters:
+ * const uint8_t *data Data to check
+ * uint32_t len Number of bytes
+ *
+ * Returns:
+ * uint32_t CRC-32 (IEEE 802.3) of the data
+ *
+ * Brief: This function computes a bitwise CRC-32, only run once per boot.
+ *
+ */
+static uint32_t cache_crc32(const uint8_t *data, uint32_t len)
+{
+  uint32_t crc = 0xFFFFFFFF;
+
+  while (len--) {
+      crc ^= *data++;
+      for (int i = 0; i < 8; i++) {
+          crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+      }
+  }
+
+  return ~crc;
+}
+
+/*
+ * Function Name: bme680_cache_load
+ *
+ * Parameters:
+ * uint32_t sensor_id Identity of the attached sensor
+ * bme680_calib_t *calib Filled in with the cached coefficients on success
+ *
+ * Returns:
+ * bool true if a valid record for this sensor was found
+ *
+ * Brief: This function loads the calibration cached in flash. The record is
+ * rejected if its CRC is wrong or it was stored for a different sensor.
+ *
+ */
+bool bme680_cache_load(uint32_t sensor_id, bme680_calib_t *calib)
+{
+  const bme680_cache_t *record = cacheRecord;
+
+  if (record->magic != BME680_CACHE_MAGIC) {
+      return false;
+  }
+
+  if (record->crc != cache_crc32((const uint8_t *)record, offsetof(bme680_cache_t, crc))) {
+      LOG_WARN("BME680 calibration cache CRC mismatch\n\r");
+      return false;
+  }
+
+  if (record->sensor_id != sensor_id) {
+      LOG_INFO("BME680 calibration cache is for sensor 0x%08lX, found 0x%08lX\n\r",
+               (unsigned long)record->sensor_id, (unsigned long)sensor_id);
+      return false;
+  }
+
+  memcpy(calib, &record->calib, sizeof(*calib));
+
+  return true;
+}
+
+/*
+ * Function Name: bme680_cache_store
+ *
+ * Parameters:
+ * uint32_t sensor_id Identity of the attached sensor
+ * const bme680_calib_t *calib Coefficients read from the sensor
+ *
+ * Returns:
+ * bool true if the record was written and reads back correctly
+ *
+ * Brief: This function erases the cache page and writes a new record with
+ * MSC_WriteWord.
+ *
+ */
+bool bme680_cache_store(uint32_t sensor_id, const bme680_calib_t *calib)
+{
+  bme680_cache_t record;
+  uint32_t *page = (uint32_t *)cacheRecord;
+  MSC_Status_TypeDef status;
+
+  memset(&record, 0, sizeof(record)); /* Defined padding bytes for the CRC */
+  record.magic = BME680_CACHE_MAGIC;
+  record.sensor_id = sensor_id;
+  memcpy(&record.calib, calib, sizeof(*calib));
+  record.crc = cache_crc32((const uint8_t *)&record, offsetof(bme680_cache_t, crc));
+
+  MSC_Init();
+
+  status = MSC_ErasePage(page);
+  if (status == mscReturnOk) {
+      status = MSC_WriteWord(page, &record, sizeof(record));
+  }
+
+  MSC_Deinit();
+
+  if (status != mscReturnOk) {
+      LOG_ERROR("BME680 calibration cache write failed with status %d\n\r", status);
+      return false;
+  }
+
+  return memcmp(page, &record, sizeof(record)) == 0;
+}
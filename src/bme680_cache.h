@@ -0,0 +1,48 @@
+/*
+* File Name: bme680_cache.h
+* File Description: This file contains the declarations for functions in
+* bme680_cache.c
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#ifndef SRC_BME680_CACHE_H_
+#define SRC_BME680_CACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "src/bme680_regs.h"
+
+/*
+ * Function Name: bme680_cache_load
+ *
+ * Parameters:
+ * uint32_t sensor_id Identity of the attached sensor
+ * bme680_calib_t *calib Filled in with the cached coefficients on success
+ *
+ * Returns:
+ * bool true if a valid record for this sensor was found
+ *
+ * Brief: This function loads the calibration cached in flash. The record is
+ * rejected if its CRC is wrong or it was stored for a different sensor.
+ *
+ */
+bool bme680_cache_load(uint32_t sensor_id, bme680_calib_t *calib);
+
+/*
+ * Function Name: bme680_cache_store
+ *
+ * Parameters:
+ * uint32_t sensor_id Identity of the attached sensor
+ * const bme680_calib_t *calib Coefficients read from the sensor
+ *
+ * Returns:
+ * bool true if the record was written and reads back correctly
+ *
+ * Brief: This function erases the cache page and writes a new record with
+ * MSC_WriteWord.
+ *
+ */
+bool bme680_cache_store(uint32_t sensor_id, const bme680_calib_t *calib);
+
+#endif /* SRC_BME680_CACHE_H_ */
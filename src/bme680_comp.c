@@ -0,0 +1,314 @@
+/*
+* File Name: bme680_comp.c
+* File Description: This file contains the integer compensation of BME680
+* temperature, pressure, humidity and gas resistance readings. It depends on
+* nothing but the calibration structure so it also builds on a host.
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+* Reference: Bosch Sensortec BME680 datasheet and BME680 driver integer
+* compensation
+**/
+
+#include "src/bme680_comp.h"
+
+/* Range switching tables for the gas resistance */
+static const uint32_t lookup_table_gas_1[16] = {
+    2147483647, 2147483647, 2147483647, 2147483647,
+    2147483647, 2126008810, 2147483647, 2130303777,
+    2147483647, 2147483647, 2143188679, 2136746228,
+    2147483647, 2126008810, 2147483647, 2147483647
+};
+
+static const uint32_t lookup_table_gas_2[16] = {
+    4096000000, 2048000000, 1024000000,
+    512000000, 255744255, 127110228, 64000000,
+    32258064, 16016016, 8000000, 4000000,
+    2000000, 1000000, 500000, 250000, 125000
+};
+
+/*
+ * Function Name: bme680_comp_temperature
+ *
+ * Parameters:
+ * const bme680_calib_t *calib Calibration coefficients
+ * uint32_t temp_adc 20 bit temperature ADC value
+ * int32_t *t_fine Fine temperature used by pressure and humidity compensation
+ *
+ * Returns:
+ * int16_t Temperature in 0.01 degC
+ *
+ * Brief: This function compensates the temperature ADC value with 32 bit
+ * integer math only.
+ *
+ */
+/*
+ * The temperature terms below are (var1 * par_t2) >> 11 and
+ * ((var1 / 2)^2 >> 12) * (par_t3 << 4) >> 14. Over the full 20 bit ADC range
+ * both products can exceed 32 bits, which is why the reference uses int64.
+ * Splitting the first factor into the bits above and below the shift keeps
+ * every partial product within 32 bits and gives the exact same result:
+ * (a * m) >> s == (a >> s) * m + (((a & (2^s - 1)) * m) >> s)
+ */
+int16_t bme680_comp_temperature(const bme680_calib_t *calib, uint32_t temp_adc, int32_t *t_fine)
+{
+  int32_t var1 = ((int32_t)temp_adc >> 3) - ((int32_t)calib->par_t1 << 1);
+
+  int32_t var2 = (var1 >> 11) * calib->par_t2 +
+                 (((var1 & 0x7FF) * calib->par_t2) >> 11);
+
+  /* |var1 / 2| <= 65535 so the square fits in 32 bits unsigned */
+  uint32_t half = (uint32_t)((var1 < 0) ? -(var1 >> 1) : (var1 >> 1));
+  int32_t sq = (int32_t)((half * half) >> 12);
+  int32_t t3 = (int32_t)calib->par_t3 << 4;
+  int32_t var3 = (sq >> 14) * t3 + (((sq & 0x3FFF) * t3) >> 14);
+
+  int32_t fine = var2 + var3;
+
+  if (t_fine) {
+      *t_fine = fine;
+  }
+
+  return (int16_t)(((fine * 5) + 128) >> 8);
+}
+
+/*
+ * Function Name: bme680_comp_pressure
+ *
+ * Parameters:
+ * const bme680_calib_t *calib Calibration coefficients
+ * uint32_t press_adc 20 bit pressure ADC value
+ * int32_t t_fine Fine temperature from bme680_comp_temperature
+ *
+ * Returns:
+ * uint32_t Pressure in Pa
+ *
+ * Brief: This function compensates the pressure ADC value with 32 bit integer
+ * math only.
+ *
+ */
+uint32_t bme680_comp_pressure(const bme680_calib_t *calib, uint32_t press_adc, int32_t t_fine)
+{
+  int32_t var1, var2, var3, pressure_comp;
+
+  var1 = (t_fine >> 1) - 64000;
+  var2 = ((((var1 >> 2) * (var1 >> 2)) >> 11) * (int32_t)calib->par_p6) >> 2;
+  var2 = var2 + ((var1 * (int32_t)calib->par_p5) << 1);
+  var2 = (var2 >> 2) + ((int32_t)calib->par_p4 << 16);
+  var1 = (((((var1 >> 2) * (var1 >> 2)) >> 13) * ((int32_t)calib->par_p3 << 5)) >> 3) +
+         (((int32_t)calib->par_p2 * var1) >> 1);
+  var1 = var1 >> 18;
+  var1 = ((32768 + var1) * (int32_t)calib->par_p1) >> 15;
+
+  if (var1 == 0) {
+      return 0; /* Avoid a division by zero with blank calibration */
+  }
+
+  pressure_comp = 1048576 - (int32_t)press_adc;
+  pressure_comp = (int32_t)((uint32_t)(pressure_comp - (var2 >> 12)) * 3125U);
+
+  /* Keep the intermediate below 2^31 before doubling */
+  if (pressure_comp >= 0x40000000) {
+      pressure_comp = (pressure_comp / var1) << 1;
+  }
+  else {
+      pressure_comp = (pressure_comp << 1) / var1;
+  }
+
+  var1 = ((int32_t)calib->par_p9 * (((pressure_comp >> 3) * (pressure_comp >> 3)) >> 13)) >> 12;
+  var2 = ((pressure_comp >> 2) * (int32_t)calib->par_p8) >> 13;
+  var3 = ((pressure_comp >> 8) * (pressure_comp >> 8) * (pressure_comp >> 8) *
+          (int32_t)calib->par_p10) >> 17;
+
+  pressure_comp = pressure_comp + ((var1 + var2 + var3 + ((int32_t)calib->par_p7 << 7)) >> 4);
+
+  return (uint32_t)pressure_comp;
+}
+
+/*
+ * Function Name: bme680_comp_humidity
+ *
+ * Parameters:
+ * const bme680_calib_t *calib Calibration coefficients
+ * uint16_t hum_adc 16 bit humidity ADC value
+ * int32_t t_fine Fine temperature from bme680_comp_temperature
+ *
+ * Returns:
+ * uint32_t Relative humidity in 0.001 %RH, clamped to 0..100000
+ *
+ * Brief: This function compensates the humidity ADC value with 32 bit integer
+ * math only.
+ *
+ */
+uint32_t bme680_comp_humidity(const bme680_calib_t *calib, uint16_t hum_adc, int32_t t_fine)
+{
+  int32_t var1, var2, var3, var4, var5, var6, temp_scaled, calc_hum;
+
+  temp_scaled = ((t_fine * 5) + 128) >> 8;
+  var1 = ((int32_t)hum_adc - ((int32_t)calib->par_h1 * 16)) -
+         (((temp_scaled * (int32_t)calib->par_h3) / 100) >> 1);
+  var2 = ((int32_t)calib->par_h2 *
+          (((temp_scaled * (int32_t)calib->par_h4) / 100) +
+           (((temp_scaled * ((temp_scaled * (int32_t)calib->par_h5) / 100)) >> 6) / 100) +
+           (1 << 14))) >> 10;
+  var3 = var1 * var2;
+  var4 = (int32_t)calib->par_h6 << 7;
+  var4 = (var4 + ((temp_scaled * (int32_t)calib->par_h7) / 100)) >> 4;
+  var5 = ((var3 >> 14) * (var3 >> 14)) >> 10;
+  var6 = (var4 * var5) >> 1;
+  calc_hum = (((var3 + var6) >> 10) * 1000) >> 12;
+
+  if (calc_hum > 100000) {
+      calc_hum = 100000;
+  }
+  else if (calc_hum < 0) {
+      calc_hum = 0;
+  }
+
+  return (uint32_t)calc_hum;
+}
+
+/*
+ * Function Name: bme680_comp_gas
+ *
+ * Parameters:
+ * const bme680_calib_t *calib Calibration coefficients
+ * uint16_t gas_adc 10 bit gas ADC value
+ * uint8_t gas_range 4 bit gas range
+ *
+ * Returns:
+ * uint32_t Gas resistance in Ohm
+ *
+ * Brief: This function converts the gas ADC value to a resistance using the
+ * range switching tables.
+ *
+ */
+/*
+ * var1 = ((1340 + 5 * range_sw_err) * table1) >> 16 is computed exactly in 32
+ * bits by splitting table1 into 16 bit halves. The final quotient needs
+ * table2 * var1, up to 2^58, so a single 64 bit multiply and divide remain.
+ * This runs once per gas measurement, not per byte or per pixel.
+ */
+uint32_t bme680_comp_gas(const bme680_calib_t *calib, uint16_t gas_adc, uint8_t gas_range)
+{
+  gas_range &= BME680_GAS_RANGE_MSK;
+
+  uint32_t k = (uint32_t)(1340 + 5 * (int32_t)calib->range_sw_err);
+  uint32_t table1 = lookup_table_gas_1[gas_range];
+  uint32_t var1 = k * (table1 >> 16) + ((k * (table1 & 0xFFFF)) >> 16);
+  uint32_t var2 = ((uint32_t)gas_adc << 15) - 16777216U + var1;
+  uint64_t var3 = ((uint64_t)lookup_table_gas_2[gas_range] * var1) >> 9;
+
+  return (uint32_t)((var3 + (var2 >> 1)) / var2);
+}
+
+#define BME680_MAX_HEATER_TEMP 400 /* degC */
+
+/*
+ * Function Name: bme680_calc_res_heat
+ *
+ * Parameters:
+ * const bme680_calib_t *calib Calibration coefficients
+ * uint16_t target_temp Heater target temperature in degC, limited to 400
+ * int16_t amb_temp Ambient temperature in degC
+ *
+ * Returns:
+ * uint8_t res_heat_x register value
+ *
+ * Brief: This function computes the heater resistance set-point that reaches
+ * the target temperature at the given ambient temperature.
+ *
+ */
+uint8_t bme680_calc_res_heat(const bme680_calib_t *calib, uint16_t target_temp, int16_t amb_temp)
+{
+  int32_t var1, var2, var3, var4, var5, heatr_res_x100;
+
+  if (target_temp > BME680_MAX_HEATER_TEMP) {
+      target_temp = BME680_MAX_HEATER_TEMP;
+  }
+
+  var1 = (((int32_t)amb_temp * calib->par_gh3) / 1000) * 256;
+  var2 = (calib->par_gh1 + 784) * (((((calib->par_gh2 + 154009) * target_temp * 5) / 100) + 3276800) / 10);
+  var3 = var1 + (var2 / 2);
+  var4 = var3 / (calib->res_heat_range + 4);
+  var5 = (131 * calib->res_heat_val) + 65536;
+  heatr_res_x100 = ((var4 / var5) - 250) * 34;
+
+  return (uint8_t)((heatr_res_x100 + 50) / 100);
+}
+
+/*
+ * Function Name: bme680_calc_gas_wait
+ *
+ * Parameters:
+ * uint16_t dur_ms Heater on time in ms
+ *
+ * Returns:
+ * uint8_t gas_wait_x register value, 0xFF for 4032 ms or more
+ *
+ * Brief: This function encodes a heater on time as a 6 bit value with a
+ * 1/4/16/64 multiplier.
+ *
+ */
+uint8_t bme680_calc_gas_wait(uint16_t dur_ms)
+{
+  uint8_t factor = 0;
+
+  if (dur_ms >= 0xFC0) {
+      return 0xFF; /* Longest duration */
+  }
+
+  while (dur_ms > 0x3F) {
+      dur_ms = dur_ms / 4;
+      factor++;
+  }
+
+  return (uint8_t)(dur_ms + (factor * 64));
+}
+
+/*
+ * Function Name: bme680_gas_wait_ms
+ *
+ * Parameters:
+ * uint8_t gas_wait gas_wait_x register value
+ *
+ * Returns:
+ * uint32_t Heater on time in ms
+ *
+ * Brief: This function decodes a gas_wait_x register value.
+ *
+ */
+uint32_t bme680_gas_wait_ms(uint8_t gas_wait)
+{
+  return (uint32_t)(gas_wait & 0x3F) << (2 * (gas_wait >> 6));
+}
+
+/*
+ * Function Name: bme680_compensate
+ *
+ * Parameters:
+ * const bme680_calib_t *calib Calibration coefficients
+ * const bme680_field_t *field Raw measurement
+ * bme680_data_t *out Compensated measurement
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function runs the temperature, pressure, humidity and gas
+ * compensation for one measurement.
+ *
+ */
+void bme680_compensate(const bme680_calib_t *calib, const bme680_field_t *field, bme680_data_t *out)
+{
+  int32_t t_fine;
+
+  out->temperature = bme680_comp_temperature(calib, field->temp_adc, &t_fine);
+  out->pressure = bme680_comp_pressure(calib, field->press_adc, t_fine);
+  out->humidity = bme680_comp_humidity(calib, field->hum_adc, t_fine);
+
+  if (field->gas_status & BME680_GAS_VALID_MSK) {
+      out->gas_resistance = bme680_comp_gas(calib, field->gas_adc, field->gas_range);
+  }
+  else {
+      out->gas_resistance = 0;
+  }
+}
@@ -0,0 +1,154 @@
+/*
+* File Name: bme680_comp.h
+* File Description: This file contains the declarations for the fixed point
+* BME680 compensation functions in bme680_comp.c
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#ifndef SRC_BME680_COMP_H_
+#define SRC_BME680_COMP_H_
+
+#include <stdint.h>
+#include "src/bme680_regs.h"
+
+/* Compensated measurement */
+typedef struct {
+  int16_t  temperature;    /* 0.01 degC */
+  uint32_t pressure;       /* Pa */
+  uint32_t humidity;       /* 0.001 %RH */
+  uint32_t gas_resistance; /* Ohm, 0 when the gas reading is not valid */
+} bme680_data_t;
+
+/*
+ * Function Name: bme680_comp_temperature
+ *
+ * Parameters:
+ * const bme680_calib_t *calib Calibration coefficients
+ * uint32_t temp_adc 20 bit temperature ADC value
+ * int32_t *t_fine Fine temperature used by pressure and humidity compensation
+ *
+ * Returns:
+ * int16_t Temperature in 0.01 degC
+ *
+ * Brief: This function compensates the temperature ADC value with 32 bit
+ * integer math only.
+ *
+ */
+int16_t bme680_comp_temperature(const bme680_calib_t *calib, uint32_t temp_adc, int32_t *t_fine);
+
+/*
+ * Function Name: bme680_comp_pressure
+ *
+ * Parameters:
+ * const bme680_calib_t *calib Calibration coefficients
+ * uint32_t press_adc 20 bit pressure ADC value
+ * int32_t t_fine Fine temperature from bme680_comp_temperature
+ *
+ * Returns:
+ * uint32_t Pressure in Pa
+ *
+ * Brief: This function compensates the pressure ADC value with 32 bit integer
+ * math only.
+ *
+ */
+uint32_t bme680_comp_pressure(const bme680_calib_t *calib, uint32_t press_adc, int32_t t_fine);
+
+/*
+ * Function Name: bme680_comp_humidity
+ *
+ * Parameters:
+ * const bme680_calib_t *calib Calibration coefficients
+ * uint16_t hum_adc 16 bit humidity ADC value
+ * int32_t t_fine Fine temperature from bme680_comp_temperature
+ *
+ * Returns:
+ * uint32_t Relative humidity in 0.001 %RH, clamped to 0..100000
+ *
+ * Brief: This function compensates the humidity ADC value with 32 bit integer
+ * math only.
+ *
+ */
+uint32_t bme680_comp_humidity(const bme680_calib_t *calib, uint16_t hum_adc, int32_t t_fine);
+
+/*
+ * Function Name: bme680_comp_gas
+ *
+ * Parameters:
+ * const bme680_calib_t *calib Calibration coefficients
+ * uint16_t gas_adc 10 bit gas ADC value
+ * uint8_t gas_range 4 bit gas range
+ *
+ * Returns:
+ * uint32_t Gas resistance in Ohm
+ *
+ * Brief: This function converts the gas ADC value to a resistance using the
+ * range switching tables.
+ *
+ */
+uint32_t bme680_comp_gas(const bme680_calib_t *calib, uint16_t gas_adc, uint8_t gas_range);
+
+/*
+ * Function Name: bme680_calc_res_heat
+ *
+ * Parameters:
+ * const bme680_calib_t *calib Calibration coefficients
+ * uint16_t target_temp Heater target temperature in degC, limited to 400
+ * int16_t amb_temp Ambient temperature in degC
+ *
+ * Returns:
+ * uint8_t res_heat_x register value
+ *
+ * Brief: This function computes the heater resistance set-point that reaches
+ * the target temperature at the given ambient temperature.
+ *
+ */
+uint8_t bme680_calc_res_heat(const bme680_calib_t *calib, uint16_t target_temp, int16_t amb_temp);
+
+/*
+ * Function Name: bme680_calc_gas_wait
+ *
+ * Parameters:
+ * uint16_t dur_ms Heater on time in ms
+ *
+ * Returns:
+ * uint8_t gas_wait_x register value, 0xFF for 4032 ms or more
+ *
+ * Brief: This function encodes a heater on time as a 6 bit value with a
+ * 1/4/16/64 multiplier.
+ *
+ */
+uint8_t bme680_calc_gas_wait(uint16_t dur_ms);
+
+/*
+ * Function Name: bme680_gas_wait_ms
+ *
+ * Parameters:
+ * uint8_t gas_wait gas_wait_x register value
+ *
+ * Returns:
+ * uint32_t Heater on time in ms
+ *
+ * Brief: This function decodes a gas_wait_x register value.
+ *
+ */
+uint32_t bme680_gas_wait_ms(uint8_t gas_wait);
+
+/*
+ * Function Name: bme680_compensate
+ *
+ * Parameters:
+ * const bme680_calib_t *calib Calibration coefficients
+ * const bme680_field_t *field Raw measurement
+ * bme680_data_t *out Compensated measurement
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function runs the temperature, pressure, humidity and gas
+ * compensation for one measurement.
+ *
+ */
+void bme680_compensate(const bme680_calib_t *calib, const bme680_field_t *field, bme680_data_t *out);
+
+#endif /* SRC_BME680_COMP_H_ */
@@ -0,0 +1,109 @@
+/*
+* File Name: bme680_regs.h
+* File Description: This file contains the BME680 register map, the burst read
+* blocks and the decoded calibration structure
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#ifndef SRC_BME680_REGS_H_
+#define SRC_BME680_REGS_H_
+
+#include <stdint.h>
+
+/* Control and status registers */
+#define BME680_REG_RES_HEAT_VAL   0x00
+#define BME680_REG_RES_HEAT_RANGE 0x02
+#define BME680_REG_RANGE_SW_ERR   0x04
+#define BME680_REG_MEAS_STATUS_0  0x1D
+#define BME680_REG_PRESS_MSB      0x1F
+#define BME680_REG_TEMP_MSB       0x22
+#define BME680_REG_HUM_MSB        0x25
+#define BME680_REG_GAS_R_MSB      0x2A
+#define BME680_REG_GAS_R_LSB      0x2B
+#define BME680_REG_RES_HEAT_0     0x5A
+#define BME680_REG_GAS_WAIT_0     0x64
+#define BME680_REG_CTRL_GAS_0     0x70
+#define BME680_REG_CTRL_GAS_1     0x71
+#define BME680_REG_CTRL_HUM       0x72
+#define BME680_REG_CTRL_MEAS      0x74
+#define BME680_REG_CONFIG         0x75
+#define BME680_REG_CHIP_ID        0xD0
+#define BME680_REG_RESET          0xE0
+
+#define BME680_CHIP_ID       0x61
+#define BME680_SOFT_RESET    0xB6
+
+/* Burst read blocks */
+#define BME680_COEFF1_ADDR   0x89 /* 0x89..0xA1: T2, T3, P1..P10 */
+#define BME680_COEFF1_LEN    25
+#define BME680_COEFF2_ADDR   0xE1 /* 0xE1..0xF0: H1..H7, T1, GH1..GH3 */
+#define BME680_COEFF2_LEN    16
+#define BME680_COEFF3_ADDR   0x00 /* 0x00..0x04: res_heat_val, res_heat_range, range_sw_err */
+#define BME680_COEFF3_LEN    5
+#define BME680_FIELD0_ADDR   0x1D /* 0x1D..0x2B: status, P, T, H and gas ADC of field 0 */
+#define BME680_FIELD0_LEN    15
+
+/* Byte offset of a register within a burst block */
+#define BME680_OFFSET(block_addr, reg) ((reg) - (block_addr))
+
+/* meas_status_0 bits */
+#define BME680_NEW_DATA_MSK  0x80
+#define BME680_MEASURING_MSK 0x20
+
+/* gas_r_lsb bits */
+#define BME680_GAS_VALID_MSK 0x20
+#define BME680_HEAT_STAB_MSK 0x10
+#define BME680_GAS_RANGE_MSK 0x0F
+
+/* Maximum number of unused registers read to merge two blocks into one burst.
+ * A separate write-read costs START, address, register and a repeated START
+ * plus address, so reading up to that many bytes extra is cheaper */
+#define BME680_BURST_GAP_MAX 4
+
+/* Decoded calibration coefficients */
+typedef struct {
+  uint16_t par_t1;
+  int16_t  par_t2;
+  int8_t   par_t3;
+
+  uint16_t par_p1;
+  int16_t  par_p2;
+  int8_t   par_p3;
+  int16_t  par_p4;
+  int16_t  par_p5;
+  int8_t   par_p6;
+  int8_t   par_p7;
+  int16_t  par_p8;
+  int16_t  par_p9;
+  uint8_t  par_p10;
+
+  uint16_t par_h1;
+  uint16_t par_h2;
+  int8_t   par_h3;
+  int8_t   par_h4;
+  int8_t   par_h5;
+  uint8_t  par_h6;
+  int8_t   par_h7;
+
+  int8_t   par_gh1;
+  int16_t  par_gh2;
+  int8_t   par_gh3;
+
+  uint8_t  res_heat_range;
+  int8_t   res_heat_val;
+  int8_t   range_sw_err;
+} bme680_calib_t;
+
+/* Raw ADC values of one measurement (field 0) */
+typedef struct {
+  uint8_t  status;     /* meas_status_0 */
+  uint32_t press_adc;  /* 20 bit */
+  uint32_t temp_adc;   /* 20 bit */
+  uint16_t hum_adc;    /* 16 bit */
+  uint16_t gas_adc;    /* 10 bit */
+  uint8_t  gas_range;  /* 4 bit */
+  uint8_t  gas_status; /* gas_valid_r and heat_stab_r bits */
+} bme680_field_t;
+
+#endif /* SRC_BME680_REGS_H_ */
@@ -0,0 +1,253 @@
+/*
+* File Name: energy.c
+* File Description: This file contains the on-device energy accounting. The
+* time in each energy mode comes from the governor's transition events, the
+* active time per subsystem from energyBegin/energyEnd around each activity.
+* Reports go to the UART log and to a BLE characteristic so nodes can report
+* their own duty cycle.
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#include "em_core.h"
+#include "src/energy.h"
+#include "src/timers.h"
+
+#define INCLUDE_LOG_DEBUG 1
+#include "src/log.h"
+
+static uint8_t depth[energyNumberOfSubsystems];  /* Nested energyBegin calls */
+static uint64_t since[energyNumberOfSubsystems]; /* Start of the running activity */
+static uint64_t active_us[energyNumberOfSubsystems];
+static uint32_t activations[energyNumberOfSubsystems];
+
+/* The report is logged at info level, its helpers go with it */
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_INFO
+static const char *const subsystemName[energyNumberOfSubsystems] = {
+  [energySubI2C]     = "i2c",
+  [energySubLcd]     = "lcd",
+  [energySubBle]     = "ble",
+  [energySubCompute] = "compute",
+};
+#endif
+
+/*
+ * Function Name: energyBegin
+ *
+ * Parameters:
+ * energy_subsystem_t sub Subsystem becoming active
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function starts the active time of a subsystem. Calls nest, the
+ * time runs until the matching number of energyEnd calls. It may be called
+ * from interrupt context.
+ *
+ */
+void energyBegin(energy_subsystem_t sub)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if (sub >= energyNumberOfSubsystems) {
+      return;
+  }
+
+  CORE_ENTER_CRITICAL();
+  if (depth[sub]++ == 0) {
+      since[sub] = timerNowUs();
+      activations[sub]++;
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/*
+ * Function Name: energyEnd
+ *
+ * Parameters:
+ * energy_subsystem_t sub Subsystem becoming idle
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function stops the active time of a subsystem started with
+ * energyBegin. It may be called from interrupt context.
+ *
+ */
+void energyEnd(energy_subsystem_t sub)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if (sub >= energyNumberOfSubsystems) {
+      return;
+  }
+
+  CORE_ENTER_CRITICAL();
+  if (depth[sub] && --depth[sub] == 0) {
+      active_us[sub] += timerNowUs() - since[sub];
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/*
+ * Function Name: energyGetReport
+ *
+ * Parameters:
+ * energy_report_t *report Filled in with the current counters
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function combines the energy mode residency from the governor
+ * with the subsystem active times, including the time in the current energy
+ * mode and any activity still running, so the modes add up to the uptime.
+ *
+ */
+void energyGetReport(energy_report_t *report)
+{
+  const power_stats_t *power = powerGetStats();
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+
+  report->uptime_us = timerNowUs();
+
+  for (int em = 0; em < POWER_EM_COUNT; em++) {
+      report->em_us[em] = power->residency_us[em];
+      report->em_entries[em] = power->entries[em];
+  }
+
+  /* The governor charges a mode when it is left, the current one runs on */
+  if (power->current_em < POWER_EM_COUNT) {
+      report->em_us[power->current_em] += report->uptime_us - power->last_transition_us;
+  }
+
+  for (int sub = 0; sub < energyNumberOfSubsystems; sub++) {
+      report->active_us[sub] = active_us[sub];
+      if (depth[sub]) {
+          report->active_us[sub] += report->uptime_us - since[sub];
+      }
+      report->activations[sub] = activations[sub];
+  }
+
+  CORE_EXIT_CRITICAL();
+}
+
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_INFO
+/*
+ * Function Name: energy_permille
+ *
+ * Parameters:
+ * uint64_t part Time in us
+ * uint64_t total Time in us
+ *
+ * Returns:
+ * unsigned long part as a fraction of total in 1/1000
+ *
+ * Brief: This function computes a duty cycle for the report.
+ *
+ */
+static unsigned long energy_permille(uint64_t part, uint64_t total)
+{
+  return total ? (unsigned long)((part * 1000) / total) : 0;
+}
+#endif
+
+/*
+ * Function Name: energyLogReport
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function prints the duty cycle breakdown on the UART log.
+ *
+ */
+void energyLogReport(void)
+{
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_INFO
+  energy_report_t report;
+
+  energyGetReport(&report);
+
+  LOG_INFO("Energy: uptime %lu ms\n\r", (unsigned long)(report.uptime_us / 1000));
+
+  for (int em = 0; em < POWER_EM_COUNT; em++) {
+      LOG_INFO("Energy: EM%d %lu ms (%lu permille), %lu entries\n\r", em,
+               (unsigned long)(report.em_us[em] / 1000),
+               energy_permille(report.em_us[em], report.uptime_us),
+               (unsigned long)report.em_entries[em]);
+  }
+
+  for (int sub = 0; sub < energyNumberOfSubsystems; sub++) {
+      LOG_INFO("Energy: %s active %lu ms (%lu permille), %lu times\n\r", subsystemName[sub],
+               (unsigned long)(report.active_us[sub] / 1000),
+               energy_permille(report.active_us[sub], report.uptime_us),
+               (unsigned long)report.activations[sub]);
+  }
+#endif
+}
+
+/*
+ * Function Name: energy_put_u32
+ *
+ * Parameters:
+ * uint8_t *buf Destination
+ * uint32_t value Value to store
+ *
+ * Returns:
+ * uint8_t * Byte after the value
+ *
+ * Brief: This function stores a 32 bit value little endian.
+ *
+ */
+static uint8_t *energy_put_u32(uint8_t *buf, uint32_t value)
+{
+  buf[0] = (uint8_t)value;
+  buf[1] = (uint8_t)(value >> 8);
+  buf[2] = (uint8_t)(value >> 16);
+  buf[3] = (uint8_t)(value >> 24);
+
+  return buf + 4;
+}
+
+/*
+ * Function Name: energyPackReport
+ *
+ * Parameters:
+ * uint8_t *buf Destination, ENERGY_PACKED_SIZE bytes
+ * size_t size Size of buf
+ *
+ * Returns:
+ * size_t Bytes written, 0 if buf is too small
+ *
+ * Brief: This function packs the report for the BLE energy characteristic,
+ * times in ms as 32 bit little endian values.
+ *
+ */
+size_t energyPackReport(uint8_t *buf, size_t size)
+{
+  energy_report_t report;
+  uint8_t *p = buf;
+
+  if (size < ENERGY_PACKED_SIZE) {
+      return 0;
+  }
+
+  energyGetReport(&report);
+
+  *p++ = ENERGY_PACKED_VERSION;
+  p = energy_put_u32(p, (uint32_t)(report.uptime_us / 1000));
+
+  for (int em = 0; em < POWER_EM_COUNT; em++) {
+      p = energy_put_u32(p, (uint32_t)(report.em_us[em] / 1000));
+  }
+
+  for (int sub = 0; sub < energyNumberOfSubsystems; sub++) {
+      p = energy_put_u32(p, (uint32_t)(report.active_us[sub] / 1000));
+  }
+
+  return p - buf;
+}
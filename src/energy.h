@@ -0,0 +1,119 @@
+/*
+* File Name: energy.h
+* File Description: This file contains the declarations for the energy
+* accounting in energy.c
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#ifndef SRC_ENERGY_H_
+#define SRC_ENERGY_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include "src/power.h"
+
+/* Subsystems whose active time is accounted. The times overlap: LCD drawing
+ * done from a driver task also counts as compute, and the I2C bus is active
+ * while the core sleeps in EM1. */
+typedef enum {
+  energySubI2C = 0, /* I2C0 queue not empty */
+  energySubLcd,     /* Memory LCD SPI updates */
+  energySubBle,     /* Bluetooth stack event handling */
+  energySubCompute, /* Scheduler events and driver tasks */
+  energyNumberOfSubsystems
+} energy_subsystem_t;
+
+/* Snapshot of the counters, times in us since boot */
+typedef struct {
+  uint64_t uptime_us;
+  uint64_t em_us[POWER_EM_COUNT];              /* Residency per energy mode */
+  uint32_t em_entries[POWER_EM_COUNT];         /* Transitions into each energy mode */
+  uint64_t active_us[energyNumberOfSubsystems];
+  uint32_t activations[energyNumberOfSubsystems];
+} energy_report_t;
+
+#define ENERGY_REPORT_UF      20 /* LETIMER0 underflows between UART reports */
+
+#define ENERGY_PACKED_VERSION 1
+/* Version, uptime, then per EM and per subsystem time in ms, little endian */
+#define ENERGY_PACKED_SIZE    (1 + 4 + 4 * POWER_EM_COUNT + 4 * energyNumberOfSubsystems)
+
+/*
+ * Function Name: energyBegin
+ *
+ * Parameters:
+ * energy_subsystem_t sub Subsystem becoming active
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function starts the active time of a subsystem. Calls nest, the
+ * time runs until the matching number of energyEnd calls. It may be called
+ * from interrupt context.
+ *
+ */
+void energyBegin(energy_subsystem_t sub);
+
+/*
+ * Function Name: energyEnd
+ *
+ * Parameters:
+ * energy_subsystem_t sub Subsystem becoming idle
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function stops the active time of a subsystem started with
+ * energyBegin. It may be called from interrupt context.
+ *
+ */
+void energyEnd(energy_subsystem_t sub);
+
+/*
+ * Function Name: energyGetReport
+ *
+ * Parameters:
+ * energy_report_t *report Filled in with the current counters
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function combines the energy mode residency from the governor
+ * with the subsystem active times, including the time in the current energy
+ * mode and any activity still running, so the modes add up to the uptime.
+ *
+ */
+void energyGetReport(energy_report_t *report);
+
+/*
+ * Function Name: energyLogReport
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function prints the duty cycle breakdown on the UART log.
+ *
+ */
+void energyLogReport(void);
+
+/*
+ * Function Name: energyPackReport
+ *
+ * Parameters:
+ * uint8_t *buf Destination, ENERGY_PACKED_SIZE bytes
+ * size_t size Size of buf
+ *
+ * Returns:
+ * size_t Bytes written, 0 if buf is too small
+ *
+ * Brief: This function packs the report for the BLE energy characteristic,
+ * times in ms as 32 bit little endian values.
+ *
+ */
+size_t energyPackReport(uint8_t *buf, size_t size);
+
+#endif /* SRC_ENERGY_H_ */
@@ -0,0 +1,257 @@
+/*
+* File Name: frame_history.c
+* File Description: This file contains a history of recent Grid-EYE frames,
+* stored as key frames plus bit packed per pixel deltas
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#include <string.h>
+#include "src/frame_history.h"
+
+#define Q88_TO_UNITS(q) ((q) >> 6)    /* Q8.8 to 0.25 degC sensor units */
+#define UNITS_TO_Q88(u) ((int16_t)((u) * 64))
+
+#define DELTA_BYTES(bits) ((bits) * GRID_EYE_PIXELS / 8)
+
+/*
+ * Function Name: frame_history_init
+ *
+ * Parameters:
+ * frame_history_t *h Frame history
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function empties the frame history.
+ *
+ */
+void frame_history_init(frame_history_t *h)
+{
+  memset(h, 0, sizeof(*h));
+}
+
+/*
+ * Function Name: frame_history_count
+ *
+ * Parameters:
+ * const frame_history_t *h Frame history
+ *
+ * Returns:
+ * uint8_t Number of stored frames
+ *
+ * Brief: This function returns how many frames can be read back.
+ *
+ */
+uint8_t frame_history_count(const frame_history_t *h)
+{
+  return h->count;
+}
+
+/*
+ * Function Name: frame_history_drop_oldest
+ *
+ * Parameters:
+ * frame_history_t *h Frame history
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function forgets the oldest frame. Pool space is handed out in
+ * append order, so its deltas are always the oldest bytes in the pool.
+ *
+ */
+static void frame_history_drop_oldest(frame_history_t *h)
+{
+  h->pool_used -= DELTA_BYTES(h->desc[h->tail].bits);
+  h->tail = (h->tail + 1) % FRAME_HISTORY_DEPTH;
+  h->count--;
+}
+
+/*
+ * Function Name: pack_deltas
+ *
+ * Parameters:
+ * uint8_t *pool Delta pool
+ * uint16_t offset First byte, wraps at the end of the pool
+ * const int16_t *delta 64 signed deltas
+ * uint8_t bits Bits per delta
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function packs the low bits of each delta LSB first.
+ *
+ */
+static void pack_deltas(uint8_t *pool, uint16_t offset, const int16_t *delta, uint8_t bits)
+{
+  uint32_t acc = 0;
+  uint8_t acc_bits = 0;
+  uint32_t mask = (1U << bits) - 1;
+
+  for (uint8_t p = 0; p < GRID_EYE_PIXELS; p++) {
+      acc |= ((uint32_t)delta[p] & mask) << acc_bits;
+      acc_bits += bits;
+
+      while (acc_bits >= 8) {
+          pool[offset] = (uint8_t)acc;
+          offset = (offset + 1) % FRAME_HISTORY_POOL;
+          acc >>= 8;
+          acc_bits -= 8;
+      }
+  }
+}
+
+/*
+ * Function Name: unpack_deltas
+ *
+ * Parameters:
+ * const uint8_t *pool Delta pool
+ * uint16_t offset First byte, wraps at the end of the pool
+ * const int16_t *key Key frame in sensor units
+ * uint8_t bits Bits per delta
+ * int16_t *frame Reconstructed frame in Q8.8
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function sign extends each packed delta and adds the key pixel.
+ *
+ */
+static void unpack_deltas(const uint8_t *pool, uint16_t offset, const int16_t *key, uint8_t bits, int16_t *frame)
+{
+  uint32_t acc = 0;
+  uint8_t acc_bits = 0;
+
+  for (uint8_t p = 0; p < GRID_EYE_PIXELS; p++) {
+      while (acc_bits < bits) {
+          acc |= (uint32_t)pool[offset] << acc_bits;
+          offset = (offset + 1) % FRAME_HISTORY_POOL;
+          acc_bits += 8;
+      }
+
+      int32_t delta = (int32_t)(acc << (32 - bits)) >> (32 - bits);
+      acc >>= bits;
+      acc_bits -= bits;
+
+      frame[p] = UNITS_TO_Q88(key[p] + delta);
+  }
+}
+
+/*
+ * Function Name: frame_history_append
+ *
+ * Parameters:
+ * frame_history_t *h Frame history
+ * const int16_t *frame 64 pixel temperatures in Q8.8 degC
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function stores a frame as the newest entry and drops the
+ * oldest frames when the history, the key slots or the pool are full. The
+ * cost does not depend on the number of stored frames.
+ *
+ */
+void frame_history_append(frame_history_t *h, const int16_t *frame)
+{
+  int16_t delta[GRID_EYE_PIXELS];
+  int16_t max_abs = 0;
+  uint8_t bits;
+
+  if (h->count == FRAME_HISTORY_DEPTH) {
+      frame_history_drop_oldest(h);
+  }
+
+  if (h->count) {
+      const int16_t *key = h->keys[h->key];
+
+      for (uint8_t p = 0; p < GRID_EYE_PIXELS; p++) {
+          int16_t d = Q88_TO_UNITS(frame[p]) - key[p];
+
+          delta[p] = d;
+          if (d < 0) {
+              d = -d;
+          }
+          if (d > max_abs) {
+              max_abs = d;
+          }
+      }
+  }
+
+  frame_desc_t *desc = &h->desc[(h->tail + h->count) % FRAME_HISTORY_DEPTH];
+
+  if (h->count == 0 || max_abs > 31) {
+      /* New key frame; frames still using the slot are the oldest ones */
+      uint8_t slot = (h->count == 0) ? 0 : (h->key + 1) % FRAME_HISTORY_KEYS;
+
+      while (h->count && h->desc[h->tail].key == slot) {
+          frame_history_drop_oldest(h);
+      }
+
+      for (uint8_t p = 0; p < GRID_EYE_PIXELS; p++) {
+          h->keys[slot][p] = Q88_TO_UNITS(frame[p]);
+      }
+
+      h->key = slot;
+      desc = &h->desc[(h->tail + h->count) % FRAME_HISTORY_DEPTH];
+      desc->bits = 0;
+      desc->offset = h->pool_head;
+      desc->key = slot;
+      h->count++;
+      return;
+  }
+
+  bits = (max_abs <= 7) ? 4 : (max_abs <= 15) ? 5 : 6;
+
+  while (FRAME_HISTORY_POOL - h->pool_used < DELTA_BYTES(bits)) {
+      frame_history_drop_oldest(h);
+  }
+
+  desc = &h->desc[(h->tail + h->count) % FRAME_HISTORY_DEPTH];
+  desc->bits = bits;
+  desc->offset = h->pool_head;
+  desc->key = h->key;
+
+  pack_deltas(h->pool, h->pool_head, delta, bits);
+
+  h->pool_head = (h->pool_head + DELTA_BYTES(bits)) % FRAME_HISTORY_POOL;
+  h->pool_used += DELTA_BYTES(bits);
+  h->count++;
+}
+
+/*
+ * Function Name: frame_history_get
+ *
+ * Parameters:
+ * const frame_history_t *h Frame history
+ * uint8_t age 0 for the newest frame, count - 1 for the oldest
+ * int16_t *frame 64 pixel temperatures in Q8.8 degC
+ *
+ * Returns:
+ * bool false if fewer than age + 1 frames are stored
+ *
+ * Brief: This function reconstructs any stored frame from its key frame and
+ * deltas, without touching the frames in between.
+ *
+ */
+bool frame_history_get(const frame_history_t *h, uint8_t age, int16_t *frame)
+{
+  if (age >= h->count) {
+      return false;
+  }
+
+  const frame_desc_t *desc = &h->desc[(h->tail + h->count - 1 - age) % FRAME_HISTORY_DEPTH];
+  const int16_t *key = h->keys[desc->key];
+
+  if (desc->bits == 0) {
+      for (uint8_t p = 0; p < GRID_EYE_PIXELS; p++) {
+          frame[p] = UNITS_TO_Q88(key[p]);
+      }
+  }
+  else {
+      unpack_deltas(h->pool, desc->offset, key, desc->bits, frame);
+  }
+
+  return true;
+}
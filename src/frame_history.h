@@ -0,0 +1,106 @@
+/*
+* File Name: frame_history.h
+* File Description: This file contains the declarations for the delta encoded
+* Grid-EYE frame history in frame_history.c
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#ifndef SRC_FRAME_HISTORY_H_
+#define SRC_FRAME_HISTORY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "src/grid_eye_frame.h"
+
+#define FRAME_HISTORY_DEPTH 32   /* Most frames remembered */
+#define FRAME_HISTORY_KEYS  4    /* Key frames, full 12 bit pixels */
+#define FRAME_HISTORY_POOL  1280 /* Delta bytes, 32 frames at 5 bits per pixel */
+
+/* Stored frame: a key frame or packed deltas against one */
+typedef struct {
+  uint16_t offset;  /* First byte of the deltas in the pool */
+  uint8_t bits;     /* Bits per pixel delta: 4, 5 or 6; 0 for the key frame itself */
+  uint8_t key;      /* Key frame slot the deltas apply to */
+} frame_desc_t;
+
+/*
+ * Frame history. Pixels are kept in sensor units (0.25 degC), which is
+ * lossless for Grid-EYE frames. A frame within +-31 units (about 8 degC) of
+ * the current key frame is stored as deltas packed into the fewest of 4, 5
+ * or 6 bits; anything else becomes a new key frame.
+ */
+typedef struct {
+  int16_t keys[FRAME_HISTORY_KEYS][GRID_EYE_PIXELS];
+  frame_desc_t desc[FRAME_HISTORY_DEPTH];
+  uint8_t pool[FRAME_HISTORY_POOL];
+  uint8_t tail;       /* Oldest frame in desc */
+  uint8_t count;      /* Frames stored */
+  uint8_t key;        /* Most recent key slot */
+  uint16_t pool_head; /* Next free pool byte */
+  uint16_t pool_used; /* Pool bytes in use */
+} frame_history_t;
+
+/*
+ * Function Name: frame_history_init
+ *
+ * Parameters:
+ * frame_history_t *h Frame history
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function empties the frame history.
+ *
+ */
+void frame_history_init(frame_history_t *h);
+
+/*
+ * Function Name: frame_history_append
+ *
+ * Parameters:
+ * frame_history_t *h Frame history
+ * const int16_t *frame 64 pixel temperatures in Q8.8 degC
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function stores a frame as the newest entry and drops the
+ * oldest frames when the history, the key slots or the pool are full. The
+ * cost does not depend on the number of stored frames.
+ *
+ */
+void frame_history_append(frame_history_t *h, const int16_t *frame);
+
+/*
+ * Function Name: frame_history_get
+ *
+ * Parameters:
+ * const frame_history_t *h Frame history
+ * uint8_t age 0 for the newest frame, count - 1 for the oldest
+ * int16_t *frame 64 pixel temperatures in Q8.8 degC
+ *
+ * Returns:
+ * bool false if fewer than age + 1 frames are stored
+ *
+ * Brief: This function reconstructs any stored frame from its key frame and
+ * deltas, without touching the frames in between.
+ *
+ */
+bool frame_history_get(const frame_history_t *h, uint8_t age, int16_t *frame);
+
+/*
+ * Function Name: frame_history_count
+ *
+ * Parameters:
+ * const frame_history_t *h Frame history
+ *
+ * Returns:
+ * uint8_t Number of stored frames
+ *
+ * Brief: This function returns how many frames can be read back.
+ *
+ */
+uint8_t frame_history_count(const frame_history_t *h);
+
+#endif /* SRC_FRAME_HISTORY_H_ */
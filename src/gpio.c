@@ -58,6 +58,9 @@ void gpioInit()
 	// Setting mode for GPIO Port D Pin 15 to be used as Sensor Enable
 	GPIO_PinModeSet(gpioPortD, 15, gpioModePushPull, false);
 
+	// Grid-EYE INT is open drain, pull up with the glitch filter on
+	GPIO_PinModeSet(GRID_EYE_INT_port, GRID_EYE_INT_pin, gpioModeInputPullFilter, true);
+
 } // gpioInit()
 
 
@@ -96,6 +99,12 @@ void Si7021Disable()
   GPIO_PinOutClear(gpioPortD, 15);
 }
 
+/*Enable the falling edge interrupt on the Grid-EYE INT pin, active in EM0..EM3*/
+void gpioGridEyeIntEnable()
+{
+  GPIO_ExtIntConfig(GRID_EYE_INT_port, GRID_EYE_INT_pin, GRID_EYE_INT_pin, false, true, true);
+}
+
 
 
 
@@ -20,6 +20,11 @@
 
 
 
+// Grid-EYE INT output, open drain and active low. PD14 is also EM4WU4, so the
+// pin can wake the part from any energy mode.
+#define GRID_EYE_INT_port gpioPortD
+#define GRID_EYE_INT_pin  14
+
 // Function prototypes
 void gpioInit();
 void gpioLed0SetOn();
@@ -28,6 +33,7 @@ void gpioLed1SetOn();
 void gpioLed1SetOff();
 void Si7021Enable();
 void Si7021Disable();
+void gpioGridEyeIntEnable();
 
 
 
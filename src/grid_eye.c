@@ -11,176 +11,354 @@
 #include "em_device.h"
 #include "em_i2c.h"
 #include "em_gpio.h"
-#include "sl_i2cspm.h"
+#include "src/i2c.h"
 #include "src/timers.h"
 #include "src/gpio.h"
+#include "src/grid_eye.h"
+#include "src/grid_eye_frame.h"
+#include "src/occupancy.h"
+#include "src/frame_history.h"
+#include "src/scheduler.h"
+#include "src/task.h"
+#include "src/lcd.h"
 
 #define INCLUDE_LOG_DEBUG 1
+#define LOG_MODULE LOG_MOD_GRID_EYE
 #include "src/log.h"
 
 
-#define AMG8833_DEVICE_ADDR 0x68 /* Slave address for Grid Eye */
+#define AMG8833_DEVICE_ADDR AMG8833_I2C_ADDR /* Slave address for Grid Eye */
+
+/* Control registers */
+#define AMG8833_REG_PCTL  0x00 /* Power control */
+#define AMG8833_REG_RST   0x01 /* Reset */
+#define AMG8833_REG_FPSC  0x02 /* Frame rate */
+
+#define AMG8833_PCTL_NORMAL    0x00
+#define AMG8833_RST_INITIAL    0x3F /* Initial reset, reloads the adjustment values */
+#define AMG8833_FPSC_1FPS      0x01
+
+#define GRID_EYE_STARTUP_MS 50 /* Normal mode to first register access */
+#define GRID_EYE_RESET_MS   2  /* Initial reset to first register access */
+#define GRID_EYE_RETRY_MS   100 /* Wait before the flag clear is written again */
+#define GRID_EYE_FRAME_MS   1000 /* One frame at 1 FPS */
+#define GRID_EYE_BACKGROUND_MS 10000 /* Frame read without INT, keeps the background model current */
+
+/* Interrupt registers */
+#define AMG8833_REG_INTC  0x03 /* Interrupt control */
+#define AMG8833_REG_STAT  0x04 /* Status */
+#define AMG8833_REG_SCLR  0x05 /* Status clear */
+#define AMG8833_REG_INTHL 0x08 /* Upper limit, 0x08..0x09 */
+#define AMG8833_REG_INTLL 0x0A /* Lower limit, 0x0A..0x0B */
+#define AMG8833_REG_IHYSL 0x0C /* Hysteresis, 0x0C..0x0D */
+#define AMG8833_REG_INT0  0x10 /* Interrupt table, one bit per pixel, 0x10..0x17 */
+
+#define AMG8833_INTC_INTEN   0x01 /* INT output enabled */
+#define AMG8833_INTC_ABSMOD  0x02 /* Compare absolute temperatures, not the change between frames */
+#define AMG8833_SCLR_ALL     0x0E /* Clear INTF, OVF_IRS and OVF_THS */
+#define AMG8833_SCLR_INTCLR  0x02 /* Clear INTF and the interrupt table */
+
+/* Thresholds, 12 bit two's complement in 0.25 degC steps */
+#define GRID_EYE_DEG_TO_LSB(c) ((int16_t)((c) * 4))
+#define GRID_EYE_INT_HIGH GRID_EYE_DEG_TO_LSB(28) /* A person in front of the sensor */
+#define GRID_EYE_INT_LOW  GRID_EYE_DEG_TO_LSB(0)
+#define GRID_EYE_INT_HYST GRID_EYE_DEG_TO_LSB(2)
+
+static occupancy_model_t background;  /* Running per pixel background */
+static occupancy_result_t occupancy;  /* Blobs of the last frame */
+static frame_history_t history;       /* Recent frames for post-trigger upload */
+static sw_timer_t backgroundTimer;    /* Posts evtGridEye_Int every GRID_EYE_BACKGROUND_MS */
+
+/* Limit registers as register/data pairs, written one pair per transaction */
+static const uint8_t limits[] = {
+    AMG8833_REG_INTHL, GRID_EYE_INT_HIGH & 0xFF, AMG8833_REG_INTHL + 1, (GRID_EYE_INT_HIGH >> 8) & 0x0F,
+    AMG8833_REG_INTLL, GRID_EYE_INT_LOW & 0xFF,  AMG8833_REG_INTLL + 1, (GRID_EYE_INT_LOW >> 8) & 0x0F,
+    AMG8833_REG_IHYSL, GRID_EYE_INT_HYST & 0xFF, AMG8833_REG_IHYSL + 1, (GRID_EYE_INT_HYST >> 8) & 0x0F,
+};
+
+static uint8_t cmdBuf[2]; /* Register/data pair of the write in flight */
+static i2c_request_t cmdRequest = { .status = i2cTransferDone };
 
-I2C_TransferReturn_TypeDef transferStatus1;
-I2C_TransferSeq_TypeDef transferSequence1;
-uint8_t cmd_data1; /* Send commands to the Si7021 sensor*/
-
-
-uint16_t thermistor_value_grideye = 0xFFFF;
-uint8_t thermistor_buffer[2];
-
-static void grid_eye_test(void)
+/*
+ * Function Name: grid_eye_prepare_write
+ *
+ * Parameters:
+ * uint8_t reg Register address
+ * uint8_t data Register value
+ *
+ * Returns:
+ * i2c_request_t * The filled in command request
+ *
+ * Brief: This function sets up cmdRequest as a one register write that sets
+ * evtI2C0_Transfer_Done when it completes.
+ *
+ */
+static i2c_request_t *grid_eye_prepare_write(uint8_t reg, uint8_t data)
 {
-
-  thermistor_buffer[0] = 0xFF;
-  thermistor_buffer[1] = 0xFF;
-
-  cmd_data1 = 0x0E; // TTHL
-//    uint8_t data = 0x59;
-  transferSequence1.addr = AMG8833_DEVICE_ADDR << 1;
-  transferSequence1.flags = I2C_FLAG_WRITE_READ;
-  transferSequence1.buf[0].data = &cmd_data1;
-  transferSequence1.buf[0].len = sizeof(cmd_data1);
-  transferSequence1.buf[1].data = &thermistor_buffer[0];
-  transferSequence1.buf[1].len = 2;
-  transferStatus1 = I2CSPM_Transfer(I2C0, &transferSequence1);
-  if (transferStatus1 != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data1, transferStatus1);
-  }
+  cmdBuf[0] = reg;
+  cmdBuf[1] = data;
+
+  cmdRequest.device = I2C_DEV_GRID_EYE;
+  cmdRequest.seq.flags = I2C_FLAG_WRITE;
+  cmdRequest.seq.buf[0].data = cmdBuf;
+  cmdRequest.seq.buf[0].len = sizeof(cmdBuf);
+  cmdRequest.seq.buf[1].data = NULL;
+  cmdRequest.seq.buf[1].len = 0;
+  cmdRequest.callback = NULL;
+
+  return &cmdRequest;
 }
 
-uint8_t temp_byte;
+/* Write one register from the Grid-EYE task and wait for it, retrying while
+ * the bus queue is full */
+#define GRID_EYE_WRITE(task, reg, data)                                   \
+  do {                                                                    \
+      while (!i2c_bus_submit(grid_eye_prepare_write((reg), (data)))) {    \
+          TASK_SLEEP_MS((task), 1);                                       \
+      }                                                                   \
+      TASK_WAIT_I2C((task), &cmdRequest);                                 \
+      if (cmdRequest.status != i2cTransferDone) {                         \
+          LOG_ERROR_LIMITED("Grid Eye write of reg = %02X failed with error code: %d\n\r", cmdBuf[0], cmdRequest.status); \
+      }                                                                   \
+  } while (0)
+
+/* Queue a transfer from the Grid-EYE task, retrying while the bus queue is full */
+#define GRID_EYE_QUEUE(task, submit)                                      \
+  do {                                                                    \
+      while (!(submit)) {                                                 \
+          TASK_SLEEP_MS((task), 1);                                       \
+      }                                                                   \
+  } while (0)
 
-static void get_pwr_ctl(void)
+/*
+ * Function Name: grid_eye_history_frame
+ *
+ * Parameters:
+ * uint8_t age 0 for the newest captured frame
+ * int16_t *frame 64 pixel temperatures in Q8.8 degC
+ *
+ * Returns:
+ * bool false if the frame is no longer in the history
+ *
+ * Brief: This function reconstructs a recently captured frame.
+ *
+ */
+bool grid_eye_history_frame(uint8_t age, int16_t *frame)
 {
-  cmd_data1 = 0x00; // PWR_CTL
-  transferSequence1.addr = AMG8833_DEVICE_ADDR << 1;
-  transferSequence1.flags = I2C_FLAG_WRITE_READ;
-  transferSequence1.buf[0].data = &cmd_data1;
-  transferSequence1.buf[0].len = sizeof(cmd_data1);
-  transferSequence1.buf[1].data = &temp_byte;
-  transferSequence1.buf[1].len = 1;
-  transferStatus1 = I2CSPM_Transfer(I2C0, &transferSequence1);
-  if (transferStatus1 != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data1, transferStatus1);
-  }
+  return frame_history_get(&history, age, frame);
 }
 
-static void set_pwr_ctl(uint8_t data)
-{
-  cmd_data1 = 0x00; // PWR_CTL
-  transferSequence1.addr = AMG8833_DEVICE_ADDR << 1;
-  transferSequence1.flags = I2C_FLAG_WRITE_WRITE;
-  transferSequence1.buf[0].data = &cmd_data1;
-  transferSequence1.buf[0].len = sizeof(cmd_data1);
-  transferSequence1.buf[1].data = &data;
-  transferSequence1.buf[1].len = 1;
-  transferStatus1 = I2CSPM_Transfer(I2C0, &transferSequence1);
-  if (transferStatus1 != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data1, transferStatus1);
-  }
-}
+// Temperature data for pixel
+uint8_t pixel_reg_data[GRID_EYE_FRAME_SIZE];
 
-static void set_frame_rate(void)
-{
-  cmd_data1 = 0x02; // Frame rate register
-  uint8_t data = 0x01; // 1FPS frame rates
-  transferSequence1.addr = AMG8833_DEVICE_ADDR << 1;
-  transferSequence1.flags = I2C_FLAG_WRITE_WRITE;
-  transferSequence1.buf[0].data = &cmd_data1;
-  transferSequence1.buf[0].len = sizeof(cmd_data1);
-  transferSequence1.buf[1].data = &data;
-  transferSequence1.buf[1].len = 1;
-  transferStatus1 = I2CSPM_Transfer(I2C0, &transferSequence1);
-  if (transferStatus1 != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data1, transferStatus1);
-  }
-}
+static uint8_t pixel_temp_addr = 0x80; /* Pixel 1 low byte, auto incremented over the frame */
+static i2c_request_t frameRequest = { .status = i2cTransferDone };
 
-static void set_reset_reg(void)
-{
-  cmd_data1 = 0x01; // Reset register
-  uint8_t data = 0x3F; // Initial Reset Value
-  transferSequence1.addr = AMG8833_DEVICE_ADDR << 1;
-  transferSequence1.flags = I2C_FLAG_WRITE_WRITE;
-  transferSequence1.buf[0].data = &cmd_data1;
-  transferSequence1.buf[0].len = sizeof(cmd_data1);
-  transferSequence1.buf[1].data = &data;
-  transferSequence1.buf[1].len = 1;
-  transferStatus1 = I2CSPM_Transfer(I2C0, &transferSequence1);
-  if (transferStatus1 != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data1, transferStatus1);
-  }
+// Pixels outside the limits, one bit per pixel
+uint8_t int_table[8];
 
-}
+static uint8_t int_table_addr = AMG8833_REG_INT0;
+static const uint8_t int_clear_cmd[2] = {AMG8833_REG_SCLR, AMG8833_SCLR_INTCLR};
+static i2c_request_t tableRequest = { .status = i2cTransferDone };
+static i2c_request_t clearRequest = { .status = i2cTransferDone };
 
-void grid_eye_init(void)
+/*
+ * Function Name: grid_eye_read_frame_async
+ *
+ * Parameters:
+ * uint8_t *frame Caller supplied buffer of GRID_EYE_FRAME_SIZE bytes
+ * i2c_callback_t callback Called from interrupt context when the frame has landed
+ * void *arg Passed to callback
+ *
+ * Returns:
+ * bool true if the read was queued, false if a frame read is still in flight
+ *
+ * Brief: This function queues a read of the full 8x8 pixel frame. The frame is
+ * received by the LDMA while the core sleeps in EM1, followed by one callback.
+ *
+ */
+bool grid_eye_read_frame_async(uint8_t *frame, i2c_callback_t callback, void *arg)
 {
-  set_frame_rate();
-  set_reset_reg();
+  if (frameRequest.status == i2cTransferInProgress) {
+      return false;
+  }
 
-}
+  frameRequest.device = I2C_DEV_GRID_EYE;
+  frameRequest.seq.flags = I2C_FLAG_WRITE_READ;
+  frameRequest.seq.buf[0].data = &pixel_temp_addr;
+  frameRequest.seq.buf[0].len = sizeof(pixel_temp_addr);
+  frameRequest.seq.buf[1].data = frame;
+  frameRequest.seq.buf[1].len = GRID_EYE_FRAME_SIZE;
+  frameRequest.callback = callback;
+  frameRequest.arg = arg;
 
-// Temperature data for pixel
-uint8_t pixel_reg_data[128];
-
-static void get_temperature_readings(void)
-{
-  uint8_t pixel_temp_addr = 0x80;
-  transferSequence1.addr = AMG8833_DEVICE_ADDR << 1;
-  transferSequence1.flags = I2C_FLAG_WRITE_READ;
-  transferSequence1.buf[0].data = &pixel_temp_addr;
-  transferSequence1.buf[0].len = sizeof(pixel_temp_addr);
-  transferSequence1.buf[1].data = pixel_reg_data;
-  transferSequence1.buf[1].len = sizeof(pixel_reg_data);
-  transferStatus1 = I2CSPM_Transfer(I2C0, &transferSequence1);
-  if (transferStatus1 != i2cTransferDone) {
-      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data1, transferStatus1);
-  }
+  return i2c_bus_submit(&frameRequest);
 }
 
-uint16_t pixel_data[64];
+// Pixel temperatures in Q8.8 degC
+int16_t pixel_data[GRID_EYE_PIXELS];
 
 static void compute_pixel_data(void)
 {
-  for (int i = 0; i < 64; i++) {
-      pixel_data[i] = (uint16_t) (pixel_reg_data[2*i+1] << 8) | ((uint16_t)pixel_reg_data[2*i]);
-  }
+  grid_eye_frame_to_q88(pixel_reg_data, pixel_data);
 }
 
-void grid_eye_temp_test(void)
+static task_t gridEyeTask;
+
+/*
+ * Function Name: grid_eye_task
+ *
+ * Parameters:
+ * task_t *task The Grid-EYE task
+ *
+ * Returns:
+ * char Protothread state
+ *
+ * Brief: This function is the Grid-EYE driver as one sequence. It puts the
+ * sensor in normal mode at 1 FPS and reads OCC_LEARN_FRAMES frames for the
+ * background model, then arms the threshold interrupt and reads a frame when
+ * the Grid-EYE signals that a pixel crossed a limit. INT only fires above
+ * GRID_EYE_INT_HIGH, so a timer also posts the INT event every
+ * GRID_EYE_BACKGROUND_MS; those frames keep the model current while the room
+ * is empty. On the event it queues three transfers back to back: the
+ * interrupt table, the frame and the flag clear. The clear comes last so the
+ * table matches the frame. All three are waited for and a failed clear is
+ * written again, since INT cannot signal another frame before it goes
+ * through. The frame is logged when all three are done. In between the MCU
+ * stays in EM2/EM3.
+ *
+ */
+static char grid_eye_task(task_t *task)
 {
+  static uint8_t i;
+
+  PT_BEGIN(&task->pt);
 
   Si7021Enable();
 
-  uint8_t normal_mode = 0x00;
+  GRID_EYE_WRITE(task, AMG8833_REG_PCTL, AMG8833_PCTL_NORMAL);
+  TASK_SLEEP_MS(task, GRID_EYE_STARTUP_MS);
+  GRID_EYE_WRITE(task, AMG8833_REG_RST, AMG8833_RST_INITIAL);
+  TASK_SLEEP_MS(task, GRID_EYE_RESET_MS);
+  GRID_EYE_WRITE(task, AMG8833_REG_FPSC, AMG8833_FPSC_1FPS);
+
+  /* The background is learnt at the frame rate before INT is armed, INT
+   * alone would only ever show the model a warm scene */
+  for (i = 0; i < OCC_LEARN_FRAMES; i++) {
+      TASK_SLEEP_MS(task, GRID_EYE_FRAME_MS);
+      GRID_EYE_QUEUE(task, grid_eye_read_frame_async(pixel_reg_data, NULL, NULL));
+      TASK_WAIT_I2C(task, &frameRequest);
+
+      if (frameRequest.status != i2cTransferDone) {
+          LOG_ERROR_LIMITED("Grid Eye background frame read failed with error code: %d\n\r", frameRequest.status);
+          continue;
+      }
+
+      compute_pixel_data();
+      occupancy_update(&background, pixel_data, &occupancy);
+  }
 
-  set_pwr_ctl(normal_mode);
-  timerWaitUs(10000);
-  get_temperature_readings();
-  compute_pixel_data();
+  /* INT is pulled low while any pixel is outside the limits */
+  for (i = 0; i < sizeof(limits); i += 2) {
+      GRID_EYE_WRITE(task, limits[i], limits[i + 1]);
+  }
+  GRID_EYE_WRITE(task, AMG8833_REG_SCLR, AMG8833_SCLR_ALL);
+
+  /* The edge detector is set up before INT is enabled on the sensor. With a
+   * pixel already hot INT falls as soon as INTC is written, and
+   * GPIO_ExtIntConfig clears a pending edge, so the other order would lose
+   * it and INTF would never be cleared */
+  gpioGridEyeIntEnable();
+  GRID_EYE_WRITE(task, AMG8833_REG_INTC, AMG8833_INTC_INTEN | AMG8833_INTC_ABSMOD);
+
+  /* Low rate frames that INT did not trigger; the table read and the clear
+   * are harmless then */
+  if (!timerStart(&backgroundTimer, GRID_EYE_BACKGROUND_MS, GRID_EYE_BACKGROUND_MS, evtGridEye_Int, 0)) {
+      LOG_ERROR("Grid Eye background timer could not be started\n\r");
+  }
 
-  LOG_INFO("Frame \n\r");
-  for (int i = 64; i>=0; i=i-8) {
-      LOG_INFO("%d %d %d %d %d %d %d %d\n\r", pixel_data[i-8], pixel_data[i-7], pixel_data[i-6], pixel_data[i-5], pixel_data[i-4], pixel_data[i-3], pixel_data[i-2], pixel_data[i-1]);
+  for (;;) {
+      TASK_WAIT_EVENT(task, evtGridEye_Int);
+
+      tableRequest.device = I2C_DEV_GRID_EYE;
+      tableRequest.seq.flags = I2C_FLAG_WRITE_READ;
+      tableRequest.seq.buf[0].data = &int_table_addr;
+      tableRequest.seq.buf[0].len = sizeof(int_table_addr);
+      tableRequest.seq.buf[1].data = int_table;
+      tableRequest.seq.buf[1].len = sizeof(int_table);
+      tableRequest.callback = NULL;
+
+      clearRequest.device = I2C_DEV_GRID_EYE;
+      clearRequest.seq.flags = I2C_FLAG_WRITE;
+      clearRequest.seq.buf[0].data = (uint8_t *)int_clear_cmd;
+      clearRequest.seq.buf[0].len = sizeof(int_clear_cmd);
+      clearRequest.callback = NULL;
+
+      /* The bus runs queued requests in order. All three are always queued
+       * and waited for, so none of them is refilled while still in flight */
+      GRID_EYE_QUEUE(task, i2c_bus_submit(&tableRequest));
+      GRID_EYE_QUEUE(task, grid_eye_read_frame_async(pixel_reg_data, NULL, NULL));
+      GRID_EYE_QUEUE(task, i2c_bus_submit(&clearRequest));
+
+      TASK_WAIT_I2C(task, &tableRequest);
+      TASK_WAIT_I2C(task, &frameRequest);
+      TASK_WAIT_I2C(task, &clearRequest);
+
+      /* INT stays asserted until INTF is cleared, no further edge would come
+       * and capture would stop, so the clear is repeated until it goes out */
+      while (clearRequest.status != i2cTransferDone) {
+          LOG_ERROR_LIMITED("Grid Eye INT clear failed with error code: %d\n\r", clearRequest.status);
+          TASK_SLEEP_MS(task, GRID_EYE_RETRY_MS);
+          GRID_EYE_QUEUE(task, i2c_bus_submit(&clearRequest));
+          TASK_WAIT_I2C(task, &clearRequest);
+      }
+
+      if (tableRequest.status != i2cTransferDone || frameRequest.status != i2cTransferDone) {
+          LOG_ERROR_LIMITED("Grid Eye frame read failed with error code: %d %d\n\r", tableRequest.status, frameRequest.status);
+          continue;
+      }
+
+      compute_pixel_data();
+      occupancy_update(&background, pixel_data, &occupancy);
+      frame_history_append(&history, pixel_data);
+      displayHeatmap(pixel_data);
+
+      LOG_INFO("Grid Eye INT table %02X %02X %02X %02X %02X %02X %02X %02X, occupancy %u\n\r",
+               int_table[0], int_table[1], int_table[2], int_table[3],
+               int_table[4], int_table[5], int_table[6], int_table[7], occupancy.count);
+
+      for (i = 0; i < occupancy.count; i++) {
+          LOG_INFO("Grid Eye blob %u: %u pixels at (%u.%02u, %u.%02u) peak %d C\n\r", i, occupancy.blobs[i].pixels,
+                   Q88_INT(occupancy.blobs[i].x), Q88_FRAC_HUNDREDTHS(occupancy.blobs[i].x),
+                   Q88_INT(occupancy.blobs[i].y), Q88_FRAC_HUNDREDTHS(occupancy.blobs[i].y),
+                   Q88_INT(occupancy.blobs[i].peak));
+      }
   }
-  LOG_INFO("\n\n\n\r");
+
+  PT_END(&task->pt);
 }
 
-void read_grid_eye(void)
+/*
+ * Function Name: grid_eye_init
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function resets the occupancy model and frame history and
+ * starts the Grid-EYE task, which configures the sensor without blocking.
+ * After the background is learnt, frames are read when the INT pin is
+ * asserted and every GRID_EYE_BACKGROUND_MS.
+ *
+ */
+void grid_eye_init(void)
 {
-  Si7021Enable();
-
-  grid_eye_test();
-
-  get_pwr_ctl();
-
-  uint16_t temp = ((uint16_t)thermistor_buffer[1] << 8 | (uint16_t)thermistor_buffer[0]);
-  float temperature = (float)temp*0.0625;
-
-  LOG_INFO("Grid Eye power control val is 0x%02X \n\n\n\r", temp_byte);
+  occupancy_reset(&background);
+  frame_history_init(&history);
 
-  LOG_INFO("Grid Eye (0x%2X) thermistor val is 0x%02X (0x0F), 0x%02X (0x0E) the temperature is %0.2f C\n\n\n\r", AMG8833_DEVICE_ADDR, thermistor_buffer[1], thermistor_buffer[0], temperature);
+  taskStart(&gridEyeTask, grid_eye_task, "grid_eye");
 }
 
 /*
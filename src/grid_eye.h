@@ -8,10 +8,60 @@
 #ifndef SRC_GRID_EYE_H_
 #define SRC_GRID_EYE_H_
 
-void read_grid_eye(void);
+#include <stdint.h>
+#include <stdbool.h>
+#include "src/i2c.h"
 
-void grid_eye_temp_test(void);
+#define GRID_EYE_FRAME_SIZE 128 /* 64 pixels, 2 bytes each starting at register 0x80 */
 
+/*
+ * Function Name: grid_eye_init
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function starts the Grid-EYE task, which puts the sensor in
+ * normal mode at 1 FPS, learns the background, arms its threshold interrupt
+ * on the INT pin and reads a frame each time INT is asserted, plus one every
+ * few seconds for the background model.
+ *
+ */
 void grid_eye_init(void);
 
+/*
+ * Function Name: grid_eye_history_frame
+ *
+ * Parameters:
+ * uint8_t age 0 for the newest captured frame
+ * int16_t *frame 64 pixel temperatures in Q8.8 degC
+ *
+ * Returns:
+ * bool false if the frame is no longer in the history
+ *
+ * Brief: This function reconstructs one of the last captured frames from the
+ * delta encoded history.
+ *
+ */
+bool grid_eye_history_frame(uint8_t age, int16_t *frame);
+
+/*
+ * Function Name: grid_eye_read_frame_async
+ *
+ * Parameters:
+ * uint8_t *frame Caller supplied buffer of GRID_EYE_FRAME_SIZE bytes
+ * i2c_callback_t callback Called from interrupt context when the frame has landed
+ * void *arg Passed to callback
+ *
+ * Returns:
+ * bool true if the read was queued, false if a frame read is still in flight
+ *
+ * Brief: This function queues a read of the full 8x8 pixel frame. The frame is
+ * received by the LDMA while the core sleeps in EM1, followed by one callback.
+ *
+ */
+bool grid_eye_read_frame_async(uint8_t *frame, i2c_callback_t callback, void *arg);
+
 #endif /* SRC_GRID_EYE_H_ */
@@ -0,0 +1,107 @@
+/*
+* File Name: grid_eye_frame.c
+* File Description: This file contains the Grid-EYE frame conversion kernel.
+* It is plain C with an optional Cortex-M4 DSP path, so it also builds on a
+* host.
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#include <string.h>
+#include "src/grid_eye_frame.h"
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include "cmsis_compiler.h"
+#define GRID_EYE_FRAME_SIMD 1
+#else
+#define GRID_EYE_FRAME_SIMD 0
+#endif
+
+#define PIXEL_MASK_X2 0x0FFF0FFFUL /* 12 bit pixel in each halfword */
+
+#if !GRID_EYE_FRAME_SIMD
+/*
+ * Function Name: sat_q88
+ *
+ * Parameters:
+ * int32_t v Value to saturate
+ *
+ * Returns:
+ * int16_t v limited to the int16 range
+ *
+ * Brief: This function is the portable form of the saturation done by QADD16.
+ *
+ */
+static inline int16_t sat_q88(int32_t v)
+{
+  if (v > INT16_MAX) {
+      return INT16_MAX;
+  }
+  if (v < INT16_MIN) {
+      return INT16_MIN;
+  }
+  return (int16_t)v;
+}
+#endif
+
+/*
+ * Function Name: grid_eye_frame_to_q88
+ *
+ * Parameters:
+ * const uint8_t *frame 128 byte register dump starting at pixel 1 low byte (0x80)
+ * int16_t *out 64 temperatures in Q8.8 degC
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function sign extends the 12 bit two's complement pixels
+ * (0.25 degC per LSB) and scales them to Q8.8, saturating to the int16 range.
+ * Two pixels are converted per 32 bit word; on a Cortex-M4 the scaling uses
+ * the saturating QADD16 SIMD instruction.
+ *
+ */
+/*
+ * Each word holds two little endian pixels. Masking to 12 bits and shifting
+ * left by 4 moves the sign bit to bit 15 of each halfword, which gives the
+ * sign extended value times 16 with no carry between halfwords. Two saturating
+ * doublings bring it to times 64: 0.25 degC per LSB in Q8.8. That is six
+ * instructions per pixel pair, about 200 cycles for the frame.
+ */
+void grid_eye_frame_to_q88(const uint8_t *frame, int16_t *out)
+{
+  for (int i = 0; i < GRID_EYE_PIXELS / 2; i++) {
+      uint32_t w;
+
+      memcpy(&w, &frame[4 * i], sizeof(w)); /* Single LDR, unaligned access is allowed */
+      w = (w & PIXEL_MASK_X2) << 4;
+
+#if GRID_EYE_FRAME_SIMD
+      w = __QADD16(w, w);
+      w = __QADD16(w, w);
+      memcpy(&out[2 * i], &w, sizeof(w));
+#else
+      out[2 * i] = sat_q88((int32_t)(int16_t)(w & 0xFFFF) * 4);
+      out[2 * i + 1] = sat_q88((int32_t)(int16_t)(w >> 16) * 4);
+#endif
+  }
+}
+
+/*
+ * Function Name: grid_eye_thermistor_to_q88
+ *
+ * Parameters:
+ * uint16_t raw Thermistor register value (TTHL/TTHH)
+ *
+ * Returns:
+ * int16_t Thermistor temperature in Q8.8 degC
+ *
+ * Brief: This function converts the 12 bit sign and magnitude thermistor
+ * value (0.0625 degC per LSB) to Q8.8.
+ *
+ */
+int16_t grid_eye_thermistor_to_q88(uint16_t raw)
+{
+  int16_t magnitude = (int16_t)((raw & 0x07FF) << 4); /* 1/16 degC to 1/256 degC */
+
+  return (raw & 0x0800) ? -magnitude : magnitude;
+}
@@ -0,0 +1,53 @@
+/*
+* File Name: grid_eye_frame.h
+* File Description: This file contains the declarations for the Grid-EYE
+* frame conversion functions in grid_eye_frame.c
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#ifndef SRC_GRID_EYE_FRAME_H_
+#define SRC_GRID_EYE_FRAME_H_
+
+#include <stdint.h>
+
+#define GRID_EYE_PIXELS 64 /* 8x8 pixels */
+
+/* Q8.8 fixed point temperature: degC * 256 */
+#define Q88_INT(q)  ((q) / 256)
+#define Q88_FRAC_HUNDREDTHS(q) (((((q) < 0) ? -(q) : (q)) % 256) * 100 / 256)
+
+/*
+ * Function Name: grid_eye_frame_to_q88
+ *
+ * Parameters:
+ * const uint8_t *frame 128 byte register dump starting at pixel 1 low byte (0x80)
+ * int16_t *out 64 temperatures in Q8.8 degC
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function sign extends the 12 bit two's complement pixels
+ * (0.25 degC per LSB) and scales them to Q8.8, saturating to the int16 range.
+ * Two pixels are converted per 32 bit word; on a Cortex-M4 the scaling uses
+ * the saturating QADD16 SIMD instruction.
+ *
+ */
+void grid_eye_frame_to_q88(const uint8_t *frame, int16_t *out);
+
+/*
+ * Function Name: grid_eye_thermistor_to_q88
+ *
+ * Parameters:
+ * uint16_t raw Thermistor register value (TTHL/TTHH)
+ *
+ * Returns:
+ * int16_t Thermistor temperature in Q8.8 degC
+ *
+ * Brief: This function converts the 12 bit sign and magnitude thermistor
+ * value (0.0625 degC per LSB) to Q8.8.
+ *
+ */
+int16_t grid_eye_thermistor_to_q88(uint16_t raw);
+
+#endif /* SRC_GRID_EYE_FRAME_H_ */
@@ -0,0 +1,147 @@
+/*
+* File Name: heatmap.c
+* File Description: This file renders a Grid-EYE frame as a dithered heat map
+* straight into a 1 bit per pixel framebuffer. It has no SDK dependencies so
+* it also builds on a host.
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#include "src/heatmap.h"
+
+/* 4x4 Bayer matrix scaled to 0..255 thresholds, centered in each step */
+static const uint8_t bayer4[4][4] = {
+    {   8, 136,  40, 168 },
+    { 200,  72, 232, 104 },
+    {  56, 184,  24, 152 },
+    { 248, 120, 216,  88 }
+};
+
+/*
+ * Function Name: heatmap_taps
+ *
+ * Parameters:
+ * uint8_t size Rendered edge in pixels
+ * uint8_t *idx Source index of the left/top tap for each output position
+ * uint8_t *weight Q8 weight of the right/bottom tap for each output position
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function computes the bilinear taps once per frame. Output
+ * pixel centers are mapped onto source pixel centers and clamped at the
+ * edges. The same taps serve both passes as the scaling is square.
+ *
+ */
+static void heatmap_taps(uint8_t size, uint8_t *idx, uint8_t *weight)
+{
+  int32_t ratio = size / HEATMAP_SRC_SIZE;
+
+  for (int32_t i = 0; i < size; i++) {
+      /* Source position in Q8: (i + 0.5) / ratio - 0.5 */
+      int32_t pos = ((2 * i + 1) * 128) / ratio - 128;
+
+      if (pos < 0) {
+          pos = 0;
+      }
+      else if (pos > (HEATMAP_SRC_SIZE - 1) * 256) {
+          pos = (HEATMAP_SRC_SIZE - 1) * 256;
+      }
+
+      idx[i] = (uint8_t)(pos >> 8);
+      weight[i] = (uint8_t)(pos & 0xFF);
+  }
+}
+
+/*
+ * Function Name: heatmap_render
+ *
+ * Parameters:
+ * const int16_t *frame 64 temperatures in Q8.8 degC, row major
+ * uint8_t size Rendered edge in pixels, a multiple of 8 up to HEATMAP_MAX_SIZE
+ * uint8_t *fb 1 bit per pixel framebuffer, pixel x is bit (x & 7) of byte x / 8
+ * uint16_t stride Framebuffer bytes per row
+ * uint16_t x0 Left edge of the heat map, a multiple of 8
+ * uint16_t y0 Top row of the heat map
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function scales the frame to 0..255 between its coldest and
+ * hottest pixel, upscales it with a separable fixed point bilinear filter and
+ * writes it into the framebuffer with a 4x4 ordered dither. Hot pixels are
+ * drawn black. Whole framebuffer bytes are written, no per-pixel calls.
+ *
+ */
+void heatmap_render(const int16_t *frame, uint8_t size, uint8_t *fb, uint16_t stride,
+                    uint16_t x0, uint16_t y0)
+{
+  uint8_t idx[HEATMAP_MAX_SIZE];
+  uint8_t weight[HEATMAP_MAX_SIZE];
+  uint8_t level[HEATMAP_SRC_SIZE * HEATMAP_SRC_SIZE];
+  uint8_t rows[HEATMAP_SRC_SIZE][HEATMAP_MAX_SIZE]; /* Horizontal pass */
+  int32_t min = frame[0], max = frame[0];
+  uint32_t scale;
+
+  if (size > HEATMAP_MAX_SIZE || size < HEATMAP_SRC_SIZE || (size % HEATMAP_SRC_SIZE) != 0) {
+      return;
+  }
+
+  for (int i = 1; i < HEATMAP_SRC_SIZE * HEATMAP_SRC_SIZE; i++) {
+      if (frame[i] < min) {
+          min = frame[i];
+      }
+      if (frame[i] > max) {
+          max = frame[i];
+      }
+  }
+
+  /* One divide per frame, a 1 degC span at least so sensor noise on a
+   * uniform scene is not stretched into full contrast */
+  if (max - min < 256) {
+      max = min + 256;
+  }
+  scale = (255U << 16) / (uint32_t)(max - min);
+
+  for (int i = 0; i < HEATMAP_SRC_SIZE * HEATMAP_SRC_SIZE; i++) {
+      level[i] = (uint8_t)(((uint32_t)(frame[i] - min) * scale) >> 16);
+  }
+
+  heatmap_taps(size, idx, weight);
+
+  for (int r = 0; r < HEATMAP_SRC_SIZE; r++) {
+      const uint8_t *src = &level[r * HEATMAP_SRC_SIZE];
+
+      for (int x = 0; x < size; x++) {
+          int32_t a = src[idx[x]];
+          int32_t b = src[(idx[x] < HEATMAP_SRC_SIZE - 1) ? idx[x] + 1 : idx[x]];
+
+          rows[r][x] = (uint8_t)(a + (((b - a) * weight[x]) >> 8));
+      }
+  }
+
+  /* Vertical pass, dithered and packed 8 pixels per framebuffer byte */
+  for (int y = 0; y < size; y++) {
+      const uint8_t *top = rows[idx[y]];
+      const uint8_t *bottom = rows[(idx[y] < HEATMAP_SRC_SIZE - 1) ? idx[y] + 1 : idx[y]];
+      const uint8_t *threshold = bayer4[(y0 + y) & 3];
+      int32_t wy = weight[y];
+      uint8_t *dst = fb + (uint32_t)(y0 + y) * stride + (x0 >> 3);
+
+      for (int x = 0; x < size; x += 8) {
+          uint8_t byte = 0;
+
+          for (int bit = 0; bit < 8; bit++) {
+              int32_t a = top[x + bit];
+              int32_t v = a + (((bottom[x + bit] - a) * wy) >> 8);
+
+              /* Set bits are white, so only pixels below the threshold */
+              if (v < threshold[bit & 3]) {
+                  byte |= (uint8_t)(1U << bit);
+              }
+          }
+
+          *dst++ = byte;
+      }
+  }
+}
@@ -0,0 +1,40 @@
+/*
+* File Name: heatmap.h
+* File Description: This file contains the declarations for the Grid-EYE heat
+* map renderer in heatmap.c
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#ifndef SRC_HEATMAP_H_
+#define SRC_HEATMAP_H_
+
+#include <stdint.h>
+
+#define HEATMAP_SRC_SIZE 8  /* Grid-EYE frame is 8x8 */
+#define HEATMAP_MAX_SIZE 64 /* Largest rendered edge in pixels */
+
+/*
+ * Function Name: heatmap_render
+ *
+ * Parameters:
+ * const int16_t *frame 64 temperatures in Q8.8 degC, row major
+ * uint8_t size Rendered edge in pixels, a multiple of 8 up to HEATMAP_MAX_SIZE
+ * uint8_t *fb 1 bit per pixel framebuffer, pixel x is bit (x & 7) of byte x / 8
+ * uint16_t stride Framebuffer bytes per row
+ * uint16_t x0 Left edge of the heat map, a multiple of 8
+ * uint16_t y0 Top row of the heat map
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function scales the frame to 0..255 between its coldest and
+ * hottest pixel, upscales it with a separable fixed point bilinear filter and
+ * writes it into the framebuffer with a 4x4 ordered dither. Hot pixels are
+ * drawn black. Whole framebuffer bytes are written, no per-pixel calls.
+ *
+ */
+void heatmap_render(const int16_t *frame, uint8_t size, uint8_t *fb, uint16_t stride,
+                    uint16_t x0, uint16_t y0);
+
+#endif /* SRC_HEATMAP_H_ */
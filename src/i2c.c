@@ -1,714 +1,634 @@
-///*
-//* File Name: i2c.c
-//* File Description: This file contains the I2C related functions
-//* File Author: Gautama Gandhi
-//* Tools used: Simplicity Studio IDE
-//**/
-//
-//#include <stdio.h>
-//#include "em_chip.h"
-//#include "em_device.h"
-//#include "em_i2c.h"
-//#include "em_gpio.h"
-//#include "sl_i2cspm.h"
-//#include "src/timers.h"
-//#include "src/gpio.h"
-//
-//#define INCLUDE_LOG_DEBUG 1
-//#include "src/log.h"
-//
-//#define BME_680_DEVICE_ADDR 0x76 /* Slave address for BME 280 */
-//#define SI7021_DEVICE_ADDR 0x40 /*Slave address for Si7021 sensor*/
-//#define MAX_17048_DEVICE_ADDR 0x36 /* Slave address for BME 280 */
-////#define AMG8833_DEVICE_ADDR 0x68 /* Slave address for Grid Eye */
-//#define AMG8833_DEVICE_ADDR 0x69 /* Slave address for Grid Eye */
-//#define measure_temp_cmd 0xF3 /* Command for measuring temperature */
-//#define read_pres_cmd1 0x21 /* Reading Pressure 1 for BME280 sensor*/
-//#define read_pres_cmd2 0x20 /* Reading Pressure 2 for BME280 sensor*/
-//#define read_pres_cmd3 0x1F /* Reading Pressure 3 for BME280 sensor*/
-//#define MS_DELAY_80 80000
-//#define MS_DELAY_10_8 10800
-//
-//I2C_TransferReturn_TypeDef transferStatus;
-//I2C_TransferSeq_TypeDef transferSequence;
-//uint8_t cmd_data; /* Send commands to the Si7021 sensor*/
-//uint8_t buffer[2]; /* Read buffer used to store temperature values*/
-//
-//uint8_t new_buffer[3]; /* Read buffer used to store temperature values*/
-//
-///*
-// * Function Name: i2c_Init
-// *
-// * Parameters:
-// * none
-// *
-// * Returns:
-// * none
-// *
-// * Brief: This function initializes the I2C peripheral.
-// *
-// */
-//static void i2c_Init(void)
-//{
-//  /* Initialize the I2C hardware using I2CSPM_Init_TypeDef*/
-//  I2CSPM_Init_TypeDef I2C_Config = {
-//    .port = I2C0,
-//    .sclPort = gpioPortC,
-//    .sclPin = 10,
-//    .sdaPort = gpioPortC,
-//    .sdaPin = 11,
-//    .portLocationScl = 14,
-//    .portLocationSda = 16,
-//    .i2cRefFreq = 0,
-////    .i2cMaxFreq = I2C_FREQ_STANDARD_MAX,
-//    .i2cMaxFreq = I2C_FREQ_FAST_MAX,
-//    .i2cClhr = i2cClockHLRStandard
-//  };
-//
-//  I2CSPM_Init(&I2C_Config);
-//}
-//
-///*
-// * Function Name: I2C_Read_ID
-// *
-// * Parameters:
-// * none
-// *
-// * Returns:
-// * none
-// *
-// * Brief: This function writes a value (command/data) to the I2C slave device based on
-// * transferSequence structure values.
-// *
-// */
-//void I2C_Read_ID(void)
-//{
-//  cmd_data = 0xD0;
-////  uint8_t data = 0xB6;
-//  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-//  transferSequence.flags = I2C_FLAG_WRITE_READ;
-//  transferSequence.buf[0].data = &cmd_data;
-//  transferSequence.buf[0].len = sizeof(cmd_data);
-//  transferSequence.buf[1].data = new_buffer;
-//  transferSequence.buf[1].len = sizeof(new_buffer);
-//  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//  if (transferStatus != i2cTransferDone) {
-//      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-//  }
-//}
-//
-///*
-// * Function Name: I2C_Write
-// *
-// * Parameters:
-// * none
-// *
-// * Returns:
-// * none
-// *
-// * Brief: This function writes a value (command/data) to the I2C slave device based on
-// * transferSequence structure values.
-// *
-// */
-//static void I2C_Write_Reset(void)
-//{
-//  cmd_data = 0xE0;
-//  uint8_t data = 0xB6;
-//  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-//  transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-//  transferSequence.buf[0].data = &cmd_data;
-//  transferSequence.buf[0].len = sizeof(cmd_data);
-//  transferSequence.buf[1].data = &data;
-//  transferSequence.buf[1].len = 1;
-//  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//  if (transferStatus != i2cTransferDone) {
-//      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-//  }
-//}
-//
-///* Function to set BME280 in forced mode*/
-//static void I2C_Set_Mode(void)
-//{
-//  cmd_data = 0x74; /* Control Meas register*/
-//  uint8_t data = 0x06;
-//  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-//  transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-//  transferSequence.buf[0].data = &cmd_data;
-//  transferSequence.buf[0].len = sizeof(cmd_data);
-//  transferSequence.buf[1].data = &data;
-//  transferSequence.buf[1].len = 1;
-//  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//  if (transferStatus != i2cTransferDone) {
-//      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-//  }
-//}
-//
-//
-///* Function to set config for BME280*/
-//static void I2C_Set_Config(void)
-//{
-//  cmd_data = 0x75; /* Config register */
-//  uint8_t data = 0x10; /**/
-//  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-//  transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-//  transferSequence.buf[0].data = &cmd_data;
-//  transferSequence.buf[0].len = sizeof(cmd_data);
-//  transferSequence.buf[1].data = &data;
-//  transferSequence.buf[1].len = 1;
-//  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//  if (transferStatus != i2cTransferDone) {
-//      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-//  }
-//}
-//
-///* Function to read pressure from BME280*/
-//static void I2C_Read_Pressure1(void)
-//{
-//  cmd_data = read_pres_cmd1;
-//  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-//  transferSequence.flags = I2C_FLAG_WRITE_READ;
-//  transferSequence.buf[0].data = &cmd_data;
-//  transferSequence.buf[0].len = 1;
-//  transferSequence.buf[1].data = new_buffer;
-//  transferSequence.buf[1].len = sizeof(new_buffer);
-//  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//  if (transferStatus != i2cTransferDone) {
-//       LOG_ERROR ("I2CSPM_Transfer: I2C bus read with error code: %d\n\r", transferStatus);
-//  }
-//}
-//
-///* Function to read version*/
-//static void MAX_17048_huami(void)
-//{
-//  cmd_data = 0x08; /* Control Meas register*/
-//  transferSequence.addr = 0x36 << 1;
-//  transferSequence.flags = I2C_FLAG_WRITE_READ;
-//  transferSequence.buf[0].data = &cmd_data;
-//  transferSequence.buf[0].len = sizeof(cmd_data);
-//  transferSequence.buf[1].data = buffer;
-//  transferSequence.buf[1].len = sizeof(buffer);
-//  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//  if (transferStatus != i2cTransferDone) {
-//      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-//  }
-//}
-//
-/////* Function to read version*/
-////static void MAX_17048_huami(void)
-////{
-////  cmd_data = 0x08; /* Control Meas register*/
-////  transferSequence.addr = (0x6C) << 1;
-////  transferSequence.flags = I2C_FLAG_WRITE_READ;
-////  transferSequence.buf[0].data = &cmd_data;
-////  transferSequence.buf[0].len = sizeof(cmd_data);
-////  transferSequence.buf[1].data = buffer;
-////  transferSequence.buf[1].len = sizeof(buffer);
-////  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-////  if (transferStatus != i2cTransferDone) {
-////      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-////  }
-////}
-////
-/////* Function to read version*/
-////static void MAX_17048_huami(void)
-////{
-////  cmd_data = 0x08; /* Control Meas register*/
-////  transferSequence.addr = (0x36) << 1;
-////  transferSequence.flags = I2C_FLAG_WRITE_READ;
-////  transferSequence.buf[0].data = &cmd_data;
-////  transferSequence.buf[0].len = sizeof(cmd_data);
-////  transferSequence.buf[1].data = buffer;
-////  transferSequence.buf[1].len = sizeof(buffer);
-////  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-////  if (transferStatus != i2cTransferDone) {
-////      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-////  }
-////}
-//
-///* Temperature compensation enum*/
-//enum temperature_comp {dig_T1_LSB, dig_T1_MSB, dig_T2_LSB, dig_T2_MSB, dig_T3_LSB, dig_T3_MSB};
-//
-///* Pressure compensation enum */
-//enum pressue_comp {dig_P1_LSB = 6, dig_P1_MSB, dig_P2_LSB, dig_P2_MSB, dig_P3_LSB, dig_P3_MSB,
-//  dig_P4_LSB, dig_P4_MSB, dig_P5_LSB, dig_P5_MSB, dig_P6_LSB, dig_P6_MSB,
-//  dig_P7_LSB, dig_P7_MSB, dig_P8_LSB, dig_P8_MSB, dig_P9_LSB, dig_P9_MSB};
-//
-//uint8_t compensation_buffer[24]; /* Compensation buffer */
-//
-///* Function to set temperature mode*/
-//static void set_temperature_mode(void)
-//{
-//  cmd_data = 0x74; /* Ctrl meas register */
-//  uint8_t data = 0x21; /*Extracting single value for temperature*/
-//  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-//  transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-//  transferSequence.buf[0].data = &cmd_data;
-//  transferSequence.buf[0].len = sizeof(cmd_data);
-//  transferSequence.buf[1].data = &data;
-//  transferSequence.buf[1].len = 1;
-//  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//  if (transferStatus != i2cTransferDone) {
-//      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-//  }
-//}
-//
-//static uint32_t temperature_raw;
-//
-///* Function to retrieve temperature value*/
-//static void get_temperature_value(void)
-//{
-//  cmd_data = 0xFA; /* Temperature register*/
-//  uint8_t temp_buffer[3];
-//  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-//  transferSequence.flags = I2C_FLAG_WRITE_READ;
-//  transferSequence.buf[0].data = &cmd_data;
-//  transferSequence.buf[0].len = sizeof(cmd_data);
-//  transferSequence.buf[1].data = temp_buffer;
-//  transferSequence.buf[1].len = sizeof(temp_buffer);
-//  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//  if (transferStatus != i2cTransferDone) {
-//      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-//  }
-//
-//  temperature_raw = (temp_buffer[0] << 12) | (temp_buffer[1] << 4) | ((temp_buffer[2] & 0xF0) >> 4);
-//}
-//
-//uint16_t dig_T1_val;
-//int16_t dig_T2_val, dig_T3_val;
-//uint16_t dig_P1_val;
-//int16_t dig_P2_val, dig_P3_val, dig_P4_val, dig_P5_val, dig_P6_val, dig_P7_val, dig_P8_val, dig_P9_val;
-//
-//static int32_t t_fine;
-//
-//int32_t var1;
-//int32_t var2;
-//int32_t var3;
-//int32_t var4;
-//uint32_t var5;
-//uint32_t pressure;
-//uint32_t pressure_min = 30000;
-//uint32_t pressure_max = 110000;
-//
-///* Compensation formula adapted from Bosch library*/
-//static void get_sensor_compensation_values(void)
-//{
-//  cmd_data = 0x88;
-//  transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-//  transferSequence.flags = I2C_FLAG_WRITE_READ;
-//  transferSequence.buf[0].data = &cmd_data;
-//  transferSequence.buf[0].len = 1;
-//  transferSequence.buf[1].data = compensation_buffer;
-//  transferSequence.buf[1].len = sizeof(compensation_buffer);
-//  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//  if (transferStatus != i2cTransferDone) {
-//       LOG_ERROR ("I2CSPM_Transfer: I2C bus read with error code: %d\n\r", transferStatus);
-//  }
-//
-//  dig_T1_val = (compensation_buffer[dig_T1_MSB] << 8) | (compensation_buffer[dig_T1_LSB]);
-//  dig_T2_val = (compensation_buffer[dig_T2_MSB] << 8) | (compensation_buffer[dig_T2_LSB]);
-//  dig_T3_val = (compensation_buffer[dig_T3_MSB] << 8) | (compensation_buffer[dig_T3_LSB]);
-//  dig_P1_val = (compensation_buffer[dig_P1_MSB] << 8) | (compensation_buffer[dig_P1_LSB]);
-//  dig_P2_val = (compensation_buffer[dig_P2_MSB] << 8) | (compensation_buffer[dig_P2_LSB]);
-//  dig_P3_val = (compensation_buffer[dig_P3_MSB] << 8) | (compensation_buffer[dig_P3_LSB]);
-//  dig_P4_val = (compensation_buffer[dig_P4_MSB] << 8) | (compensation_buffer[dig_P4_LSB]);
-//  dig_P5_val = (compensation_buffer[dig_P5_MSB] << 8) | (compensation_buffer[dig_P5_LSB]);
-//  dig_P6_val = (compensation_buffer[dig_P6_MSB] << 8) | (compensation_buffer[dig_P6_LSB]);
-//  dig_P7_val = (compensation_buffer[dig_P7_MSB] << 8) | (compensation_buffer[dig_P7_LSB]);
-//  dig_P8_val = (compensation_buffer[dig_P8_MSB] << 8) | (compensation_buffer[dig_P8_LSB]);
-//  dig_P9_val = (compensation_buffer[dig_P9_MSB] << 8) | (compensation_buffer[dig_P9_LSB]);
-//
-//  int32_t tvar1 = ((int32_t)((temperature_raw >> 3) - ((int32_t)dig_T1_val << 1)))*((int32_t)dig_T2_val) >> 11;
-//  int32_t tvar2 = ((((int32_t)((temperature_raw >> 4) - (int32_t)dig_T1_val))*((int32_t)((temperature_raw >> 4) - (int32_t)dig_T1_val)) >> 12) * (((int32_t)dig_T3_val))) >> 14;
-//
-//  t_fine = tvar1 + tvar2;
-//}
-//
-///* Function to convert pressure in uint32_t format from raw pressure readings*/
-//static uint32_t compute_pressure(void)
-//{
-//  uint32_t pressure_raw = (buffer[0] << 12) | (buffer[1] << 4) | ((buffer[2] & 0xF0) >> 4);
-//  uint32_t pressure_final;
-//  var1 = (((int32_t)t_fine) / 2) - (int32_t)64000;
-//  var2 = (((var1 / 4) * (var1 / 4)) / 2048) * ((int32_t)dig_P6_val);
-//  var2 = var2 + ((var1 * ((int32_t)dig_P5_val)) * 2);
-//  var2 = (var2 / 4) + (((int32_t)dig_P4_val) * 65536);
-//  var3 = (dig_P3_val * (((var1 / 4) * (var1 / 4)) / 8192)) / 8;
-//  var4 = (((int32_t)dig_P2_val) * var1) / 2;
-//  var1 = (var3 + var4) / 262144;
-//  var1 = (((32768 + var1)) * ((int32_t)dig_P1_val)) / 32768;
-//  /* avoid exception caused by division by zero */
-//  if (var1)
-//  {
-//      var5 = (uint32_t)((uint32_t)1048576) - pressure_raw;
-//      pressure_final = ((uint32_t)(var5 - (uint32_t)(var2 / 4096))) * 3125;
-//
-//      if (pressure_final < 0x80000000)
-//      {
-//          pressure_final = (pressure_final << 1) / ((uint32_t)var1);
-//      }
-//      else
-//      {
-//          pressure_final = (pressure_final / (uint32_t)var1) * 2;
-//      }
-//
-//      var1 = (((int32_t)dig_P9_val) * ((int32_t)(((pressure_final / 8) * (pressure_final / 8)) / 8192))) / 4096;
-//      var2 = ((((int32_t)(pressure_final / 4)) * ((int32_t)dig_P8_val))) / 8192;
-//      pressure = (uint32_t)((int32_t)pressure_final + ((var1 + var2 + dig_P7_val) / 16));
-//
-//      if (pressure_final < pressure_min)
-//      {
-//          pressure_final = pressure_min;
-//      }
-//      else if (pressure_final > pressure_max)
-//      {
-//          pressure_final = pressure_max;
-//      }
-//  }
-//  else
-//  {
-//      pressure_final = pressure_min;
-//  }
-//
-//  return pressure_final;
-//}
-//
-///* Calibration initialization function for BME280*/
-//void BME280_calib_init(void)
-//{
-//  i2c_Init();
-//  I2C_Write_Reset();
-//  timerWaitUs(10000);
-//  set_temperature_mode();
-//  timerWaitUs(10000);
-//  get_temperature_value();
-//  get_sensor_compensation_values();
-//}
-//
-//
-///*
-// * Function Name: read_pressure_BME280
-// *
-// * Parameters:
-// * none
-// *
-// * Returns:
-// * none
-// *
-// * Brief: This function is used to read and measure the pressure in hecto
-// * Pascals from the BME280 sensor.
-// *
-// */
-//uint32_t read_pressure_BME280(void)
-//{
-//  /* The below sequence is written based on the datasheet sequence and considerations for BME280*/
-//  I2C_Write_Reset();
-//  timerWaitUs(10000);
-//  I2C_Set_Mode();
-//  I2C_Set_Config();
-//
-//  timerWaitUs(5000);
-//  I2C_Read_Pressure1();
-//
-//  uint32_t pressure = compute_pressure();
-//
-//  return (pressure/100);
-//}
-//
-//
-///*
-// * Function Name: I2C_Write
-// *
-// * Parameters:
-// * none
-// *
-// * Returns:
-// * none
-// *
-// * Brief: This function writes a value (command/data) to the I2C slave device based on
-// * transferSequence structure values.
-// *
-// */
-//static void I2C_Write(void)
-//{
-//  cmd_data = measure_temp_cmd;
-//  transferSequence.addr = SI7021_DEVICE_ADDR << 1;
-//  transferSequence.flags = I2C_FLAG_WRITE;
-//  transferSequence.buf[0].data = &cmd_data;
-//  transferSequence.buf[0].len = sizeof(cmd_data);
-//  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//  if (transferStatus != i2cTransferDone) {
-//      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-//  }
-//}
-//
-///*
-// * Function Name: I2C_Read
-// *
-// * Parameters:
-// * none
-// *
-// * Returns:
-// * none
-// *
-// * Brief: This function reads a value from the I2C slave device based on
-// * transferSequence structure values and stores it in buffer.
-// *
-// */
-//static void I2C_Read(void)
-//{
-//  transferSequence.addr = SI7021_DEVICE_ADDR << 1;
-//  transferSequence.flags = I2C_FLAG_READ;
-//  transferSequence.buf[0].data = buffer;
-//  transferSequence.buf[0].len = sizeof(buffer);
-//  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//  if (transferStatus != i2cTransferDone) {
-//       LOG_ERROR ("I2CSPM_Transfer: I2C bus read with error code: %d\n\r", transferStatus);
-//  }
-//}
-//
-//// Setting the oversampling value for the humidity
-//static void set_humidity_oversampling(void)
-//{
-//    cmd_data = 0x72; /* Ctrl hum register */
-//    uint8_t data = 0x01; /*Extracting single value for temperature*/
-//    transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-//    transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-//    transferSequence.buf[0].data = &cmd_data;
-//    transferSequence.buf[0].len = sizeof(cmd_data);
-//    transferSequence.buf[1].data = &data;
-//    transferSequence.buf[1].len = 1;
-//    transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//    if (transferStatus != i2cTransferDone) {
-//        LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-//    }
-//}
-//
-//// Setting the oversampling value for the temperature and pressure
-//static void set_temp_pres_oversampling(void)
-//{
-//    cmd_data = 0x72; /* Ctrl meas register */
-//    uint8_t data = (0x02 << 5) | (0x05 << 2); // Setting oversampling for temperature and pressure
-//    transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-//    transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-//    transferSequence.buf[0].data = &cmd_data;
-//    transferSequence.buf[0].len = sizeof(cmd_data);
-//    transferSequence.buf[1].data = &data;
-//    transferSequence.buf[1].len = 1;
-//    transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//    if (transferStatus != i2cTransferDone) {
-//        LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-//    }
-//}
-//
-//// Setting the measurement for forced mode
-//static void set_forced_mode(void)
-//{
-//    cmd_data = 0x72; /* Ctrl meas register */
-//    uint8_t data = (0x02 << 5) | (0x05 << 2) | (0x01);
-//    transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-//    transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-//    transferSequence.buf[0].data = &cmd_data;
-//    transferSequence.buf[0].len = sizeof(cmd_data);
-//    transferSequence.buf[1].data = &data;
-//    transferSequence.buf[1].len = 1;
-//    transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//    if (transferStatus != i2cTransferDone) {
-//        LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-//    }
-//}
-//
-//// Setting the measurement for forced mode
-//static void set_iir_filter(void)
-//{
-//    cmd_data = 0x75; /* Config register */
-//    uint8_t data = (0x01 << 2);
-//    transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-//    transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-//    transferSequence.buf[0].data = &cmd_data;
-//    transferSequence.buf[0].len = sizeof(cmd_data);
-//    transferSequence.buf[1].data = &data;
-//    transferSequence.buf[1].len = 1;
-//    transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//    if (transferStatus != i2cTransferDone) {
-//        LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-//    }
-//}
-//
-//static void set_gas_wait0(void)
-//{
-//    cmd_data = 0x64; /* Gas Wait register */
-//    uint8_t data = 0x59;
-//    transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-//    transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-//    transferSequence.buf[0].data = &cmd_data;
-//    transferSequence.buf[0].len = sizeof(cmd_data);
-//    transferSequence.buf[1].data = &data;
-//    transferSequence.buf[1].len = 1;
-//    transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//    if (transferStatus != i2cTransferDone) {
-//        LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-//    }
-//}
-//
-//static void compute_res_heat0(void)
-//{
-//    cmd_data = 0x64; /* Gas Wait register */
-//    uint8_t data = 0x59;
-//    transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-//    transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-//    transferSequence.buf[0].data = &cmd_data;
-//    transferSequence.buf[0].len = sizeof(cmd_data);
-//    transferSequence.buf[1].data = &data;
-//    transferSequence.buf[1].len = 1;
-//    transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//    if (transferStatus != i2cTransferDone) {
-//        LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-//    }
-//}
-//
-//static void set_res_heat0(void)
-//{
-//    cmd_data = 0x64; /* Gas Wait register */
-//    uint8_t data = 0x59;
-//    transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-//    transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-//    transferSequence.buf[0].data = &cmd_data;
-//    transferSequence.buf[0].len = sizeof(cmd_data);
-//    transferSequence.buf[1].data = &data;
-//    transferSequence.buf[1].len = 1;
-//    transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//    if (transferStatus != i2cTransferDone) {
-//        LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-//    }
-//}
-//
-//static void set_nb_conv(void)
-//{
-//    cmd_data = 0x71; /* CTRL GAS 1 register */
-//    uint8_t data = 0x59;
-//    transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-//    transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-//    transferSequence.buf[0].data = &cmd_data;
-//    transferSequence.buf[0].len = sizeof(cmd_data);
-//    transferSequence.buf[1].data = &data;
-//    transferSequence.buf[1].len = 1;
-//    transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//    if (transferStatus != i2cTransferDone) {
-//        LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-//    }
-//}
-//
-//static void set_run_gas_l(void)
-//{
-//    cmd_data = 0x71; /* CTRL GAS 1 register */
-//    uint8_t data = 0x59;
-//    transferSequence.addr = BME_680_DEVICE_ADDR << 1;
-//    transferSequence.flags = I2C_FLAG_WRITE_WRITE;
-//    transferSequence.buf[0].data = &cmd_data;
-//    transferSequence.buf[0].len = sizeof(cmd_data);
-//    transferSequence.buf[1].data = &data;
-//    transferSequence.buf[1].len = 1;
-//    transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//    if (transferStatus != i2cTransferDone) {
-//        LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-//    }
-//}
-//
-//uint16_t thermistor_value_grideye = 0xFFFF;
-//uint8_t thermistor_buffer[2];
-//
-//static void grid_eye_test(void)
-//{
-//
-//  thermistor_buffer[0] = 0xFF;
-//  thermistor_buffer[1] = 0xFF;
-//
-//  cmd_data = 0x0E; // TTHL
-////    uint8_t data = 0x59;
-//  transferSequence.addr = AMG8833_DEVICE_ADDR << 1;
-//  transferSequence.flags = I2C_FLAG_WRITE_READ;
-//  transferSequence.buf[0].data = &cmd_data;
-//  transferSequence.buf[0].len = sizeof(cmd_data);
-//  transferSequence.buf[1].data = &thermistor_buffer[0];
-//  transferSequence.buf[1].len = 2;
-//  transferStatus = I2CSPM_Transfer(I2C0, &transferSequence);
-//  if (transferStatus != i2cTransferDone) {
-//      LOG_ERROR ("I2CSPM_Transfer: I2C bus write of cmd = %02X with error code: %d\n\r", cmd_data, transferStatus);
-//  }
-//}
-//
-//void read_grid_eye(void)
-//{
-//  Si7021Enable();
-//
-//  grid_eye_test();
-//
-//  uint16_t temp = ((uint16_t)thermistor_buffer[1] << 8 | (uint16_t)thermistor_buffer[0]);
-//  float temperature = (float)temp*0.0625;
-//
-//  LOG_INFO("Grid Eye (0x%2X) thermistor val is 0x%02X (0x0F), 0x%02X (0x0E) the temperature is %0.2f C\n\n\n\r", AMG8833_DEVICE_ADDR, thermistor_buffer[1], thermistor_buffer[0], temperature);
-//}
-//
-//
-//
-//
-//int32_t read_temperature_BME680(void)
-//{
-//  int32_t temperature = 0;
-//
-//  int32_t var1 = 5;
-//
-//
-//  return temperature;
-//}
-//
-///*
-// * Function Name: read_temperature_Si7021
-// *
-// * Parameters:
-// * none
-// *
-// * Returns:
-// * none
-// *
-// * Brief: This function is used to read and measure the temperature in degrees
-// * Celsius from the Si7021 sensor. The temperature values are logged onto UART.
-// *
-// */
-////void read_BME680(void)
-////{
-////  /* The below sequence is written based on the datasheet sequence and considerations for Si7021*/
-////  Si7021Enable();
-////  /* The below sequence is written based on the datasheet sequence and considerations for BME280*/
-////  I2C_Write_Reset();
-////  timerWaitUs(MS_DELAY_80);
-////  i2c_Init();
-//////  I2C_Write();
-//////  timerWaitUs(MS_DELAY_10_8);
-//////  I2C_Read();
-//////  Si7021Disable();
-////  /* Temperature formula taken from Si7021-A20 datasheet */
-//////  uint32_t temp = ((175*((buffer[0]<<8)+buffer[1]))/65536)-47;
-////
-////  I2C_Read_ID();
-////
-////  LOG_INFO("BME680 (0x%2X) Chip ID registor (0x%D0) is 0x%02X\n\r", BME_680_DEVICE_ADDR, new_buffer[0]);
-////}
-//
-//void read_max_17048(void)
-//{
-//  Si7021Enable();
-//  i2c_Init();
-//
-//  timerWaitUs(MS_DELAY_80);
-//
-//  MAX_17048_huami();
-//
-//
-////  Si7021Disable();
-//
-//  uint16_t ID = (buffer[0] << 8) | (buffer[1]);
-//
-//  LOG_INFO("MAX17048 (0x%2X) IC version register (0x08) is: 0x%02X\n\r", MAX_17048_DEVICE_ADDR, ID);
-//
-//}
+/*
+* File Name: i2c.c
+* File Description: This file contains the I2C0 bus manager. It owns the I2C0
+* peripheral and runs queued per device transactions from the I2C0 interrupt.
+* Large register reads are received by the LDMA instead of byte by byte.
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#include <stdio.h>
+#include "em_device.h"
+#include "em_core.h"
+#include "em_i2c.h"
+#include "em_gpio.h"
+#include "sl_i2cspm.h"
+#include "sl_power_manager.h"
+#include "src/power.h"
+#include "src/energy.h"
+#include "dmadrv.h"
+#include "src/scheduler.h"
+#include "src/i2c.h"
+#include "src/timers.h"
+
+#define INCLUDE_LOG_DEBUG 1
+#define LOG_MODULE LOG_MOD_I2C
+#include "src/log.h"
+
+/* 7 bit slave addresses indexed by i2c_device_t */
+static const uint8_t deviceAddr[I2C_DEV_COUNT] = {
+  [I2C_DEV_BME680]   = BME680_I2C_ADDR,
+  [I2C_DEV_GRID_EYE] = AMG8833_I2C_ADDR,
+  [I2C_DEV_MAX17048] = MAX17048_I2C_ADDR,
+};
+
+static i2c_device_stats_t deviceStats[I2C_DEV_COUNT];
+
+/* States of an LDMA register read (write register address, read into buffer) */
+typedef enum {
+  i2cDmaIdle,
+  i2cDmaAddrWFAckNack,  /* START + address (write) sent */
+  i2cDmaRegWFAckNack,   /* Register address sent */
+  i2cDmaRAddrWFAckNack, /* Repeated START + address (read) sent */
+  i2cDmaData,           /* LDMA receiving all but the last byte */
+  i2cDmaLastByte,       /* Last byte, NACKed by software */
+  i2cDmaWFStopSent,
+} i2c_dma_state_t;
+
+static unsigned int dmaChannel;
+static bool dmaAvailable = false;
+static volatile i2c_dma_state_t dmaState = i2cDmaIdle;
+static I2C_TransferReturn_TypeDef dmaResult;
+static I2C_TransferSeq_TypeDef *dmaSeq;
+
+/* Request queue; queue[queueHead] is the transfer currently on the bus */
+static i2c_request_t *queue[I2C_QUEUE_SIZE];
+static uint32_t queueHead = 0;
+static volatile uint32_t queueCount = 0;
+
+/*
+ * Function Name: i2c_Init
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function initializes the I2C0 peripheral and the bus manager.
+ *
+ */
+void i2c_Init(void)
+{
+  /* Initialize the I2C hardware using I2CSPM_Init_TypeDef*/
+  I2CSPM_Init_TypeDef I2C_Config = {
+    .port = I2C0,
+    .sclPort = gpioPortC,
+    .sclPin = 10,
+    .sdaPort = gpioPortC,
+    .sdaPin = 11,
+    .portLocationScl = 14,
+    .portLocationSda = 16,
+    .i2cRefFreq = 0,
+//    .i2cMaxFreq = I2C_FREQ_STANDARD_MAX,
+    .i2cMaxFreq = I2C_FREQ_FAST_MAX,
+    .i2cClhr = i2cClockHLRStandard
+  };
+
+  I2CSPM_Init(&I2C_Config);
+
+  /* DMADRV may already have been initialized by another driver */
+  Ecode_t ecode = DMADRV_Init();
+  if (ecode == ECODE_EMDRV_DMADRV_OK || ecode == ECODE_EMDRV_DMADRV_ALREADY_INITIALIZED) {
+      dmaAvailable = (DMADRV_AllocateChannel(&dmaChannel, NULL) == ECODE_EMDRV_DMADRV_OK);
+  }
+
+  NVIC_ClearPendingIRQ(I2C0_IRQn);
+  NVIC_EnableIRQ(I2C0_IRQn);
+}
+
+/*
+ * Function Name: i2c_dma_rx_done
+ *
+ * Parameters:
+ * unsigned int channel LDMA channel
+ * unsigned int sequenceNo DMADRV sequence number
+ * void *userParam unused
+ *
+ * Returns:
+ * bool true (DMADRV ignores the return value for single transfers)
+ *
+ * Brief: DMADRV callback, called from the LDMA IRQ once all but the last byte
+ * of an LDMA read have been received. Automatic ACK is turned off and a NACK is
+ * queued for the last byte, which is read by the I2C0 IRQ.
+ *
+ */
+static bool i2c_dma_rx_done(unsigned int channel, unsigned int sequenceNo, void *userParam)
+{
+  (void) channel;
+  (void) sequenceNo;
+  (void) userParam;
+
+  /* If the last byte already arrived before AUTOACK was cleared it has been
+   * ACKed and the slave is sending one more byte; the NACK then applies to
+   * that byte and the extra data is dropped when the next transfer starts */
+  I2C0->CTRL &= ~I2C_CTRL_AUTOACK;
+  I2C0->CMD = I2C_CMD_NACK;
+  dmaState = i2cDmaLastByte;
+  I2C_IntEnable(I2C0, I2C_IEN_RXDATAV);
+
+  return true;
+}
+
+/*
+ * Function Name: i2c_dma_eligible
+ *
+ * Parameters:
+ * const I2C_TransferSeq_TypeDef *seq Transfer descriptor
+ *
+ * Returns:
+ * bool true if the transfer should be received by the LDMA
+ *
+ * Brief: This function selects the LDMA path for register reads (one address
+ * byte followed by a read) of at least I2C_DMA_MIN_LEN bytes.
+ *
+ */
+static bool i2c_dma_eligible(const I2C_TransferSeq_TypeDef *seq)
+{
+  return dmaAvailable
+      && (seq->flags == I2C_FLAG_WRITE_READ)
+      && (seq->buf[0].len == 1)
+      && (seq->buf[1].len >= I2C_DMA_MIN_LEN);
+}
+
+/*
+ * Function Name: i2c_dma_start
+ *
+ * Parameters:
+ * I2C_TransferSeq_TypeDef *seq Transfer descriptor
+ *
+ * Returns:
+ * I2C_TransferReturn_TypeDef i2cTransferInProgress
+ *
+ * Brief: This function starts an LDMA register read by sending START and the
+ * slave address. The remaining steps are run by i2c_dma_step() from the I2C0 IRQ.
+ *
+ */
+static I2C_TransferReturn_TypeDef i2c_dma_start(I2C_TransferSeq_TypeDef *seq)
+{
+  if (I2C0->STATE & I2C_STATE_BUSY) {
+      I2C0->CMD = I2C_CMD_ABORT;
+  }
+
+  /* Ensure buffers are empty and no stale ACK setting is left over */
+  I2C0->CTRL &= ~I2C_CTRL_AUTOACK;
+  I2C0->CMD = I2C_CMD_CLEARPC | I2C_CMD_CLEARTX;
+  while (I2C0->STATUS & I2C_STATUS_RXDATAV) {
+      (void) I2C0->RXDATA;
+  }
+  I2C_IntClear(I2C0, _I2C_IF_MASK);
+
+  dmaSeq = seq;
+  dmaResult = i2cTransferInProgress;
+  dmaState = i2cDmaAddrWFAckNack;
+
+  I2C_IntEnable(I2C0, I2C_IEN_ACK | I2C_IEN_NACK | I2C_IEN_MSTOP
+                      | I2C_IEN_ARBLOST | I2C_IEN_BUSERR);
+
+  I2C0->TXDATA = seq->addr & 0xFE; /* Data not transmitted until the START is sent */
+  I2C0->CMD = I2C_CMD_START;
+
+  return i2cTransferInProgress;
+}
+
+/*
+ * Function Name: i2c_dma_nack
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function ends an LDMA read on a NACK from the slave.
+ *
+ */
+static void i2c_dma_nack(void)
+{
+  I2C_IntClear(I2C0, I2C_IF_NACK);
+  DMADRV_StopTransfer(dmaChannel);
+  I2C0->CTRL &= ~I2C_CTRL_AUTOACK;
+  dmaResult = i2cTransferNack;
+  dmaState = i2cDmaWFStopSent;
+  I2C0->CMD = I2C_CMD_STOP;
+}
+
+/*
+ * Function Name: i2c_dma_step
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * I2C_TransferReturn_TypeDef i2cTransferInProgress until the read is done
+ *
+ * Brief: This function advances an LDMA register read from the I2C0 IRQ. Only
+ * the address phase, the last byte and the STOP are handled by the CPU; the
+ * data bytes are ACKed by hardware (AUTOACK) and moved by the LDMA.
+ *
+ */
+static I2C_TransferReturn_TypeDef i2c_dma_step(void)
+{
+  uint32_t pending = I2C_IntGetEnabled(I2C0);
+
+  if (pending & (I2C_IF_ARBLOST | I2C_IF_BUSERR)) {
+      DMADRV_StopTransfer(dmaChannel);
+      I2C0->CTRL &= ~I2C_CTRL_AUTOACK;
+      I2C0->CMD = I2C_CMD_ABORT;
+      I2C0->IEN = 0;
+      I2C_IntClear(I2C0, _I2C_IF_MASK);
+      dmaState = i2cDmaIdle;
+      return (pending & I2C_IF_ARBLOST) ? i2cTransferArbLost : i2cTransferBusErr;
+  }
+
+  switch (dmaState) {
+    case i2cDmaAddrWFAckNack:
+      if (pending & I2C_IF_NACK) {
+          i2c_dma_nack();
+      }
+      else if (pending & I2C_IF_ACK) {
+          I2C_IntClear(I2C0, I2C_IF_ACK);
+          dmaState = i2cDmaRegWFAckNack;
+          I2C0->TXDATA = dmaSeq->buf[0].data[0];
+      }
+      break;
+
+    case i2cDmaRegWFAckNack:
+      if (pending & I2C_IF_NACK) {
+          i2c_dma_nack();
+      }
+      else if (pending & I2C_IF_ACK) {
+          I2C_IntClear(I2C0, I2C_IF_ACK);
+
+          /* Arm the LDMA on RXDATAV before the read starts, all but the last
+           * byte are ACKed by hardware */
+          DMADRV_PeripheralMemory(dmaChannel, dmadrvPeripheralSignal_I2C0_RXDATAV,
+                                  dmaSeq->buf[1].data, (void *) &I2C0->RXDATA, true,
+                                  dmaSeq->buf[1].len - 1, dmadrvDataSize1,
+                                  i2c_dma_rx_done, NULL);
+          I2C0->CTRL |= I2C_CTRL_AUTOACK;
+
+          dmaState = i2cDmaRAddrWFAckNack;
+          /* START first since this is a repeated start, otherwise data would be sent */
+          I2C0->CMD = I2C_CMD_START;
+          I2C0->TXDATA = (dmaSeq->addr & 0xFE) | 1;
+      }
+      break;
+
+    case i2cDmaRAddrWFAckNack:
+      if (pending & I2C_IF_NACK) {
+          i2c_dma_nack();
+      }
+      else if (pending & I2C_IF_ACK) {
+          I2C_IntClear(I2C0, I2C_IF_ACK);
+          /* i2c_dma_rx_done() may already have moved on to the last byte */
+          if (dmaState == i2cDmaRAddrWFAckNack) {
+              dmaState = i2cDmaData;
+          }
+      }
+      break;
+
+    case i2cDmaLastByte:
+      if (pending & I2C_IF_RXDATAV) {
+          I2C_IntDisable(I2C0, I2C_IEN_RXDATAV);
+          dmaSeq->buf[1].data[dmaSeq->buf[1].len - 1] = (uint8_t) I2C0->RXDATA;
+          dmaState = i2cDmaWFStopSent;
+          I2C0->CMD = I2C_CMD_STOP;
+      }
+      break;
+
+    case i2cDmaWFStopSent:
+      if (pending & I2C_IF_MSTOP) {
+          I2C_IntClear(I2C0, I2C_IF_MSTOP);
+          I2C0->IEN = 0;
+          dmaState = i2cDmaIdle;
+          return (dmaResult == i2cTransferInProgress) ? i2cTransferDone : dmaResult;
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  return i2cTransferInProgress;
+}
+
+/*
+ * Function Name: i2c_bus_complete
+ *
+ * Parameters:
+ * i2c_request_t *req Request that finished
+ * I2C_TransferReturn_TypeDef status Result of the transfer
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function updates the device counters and notifies the owner of
+ * the request. Called with interrupts masked or from the I2C0 IRQ.
+ *
+ */
+static void i2c_bus_complete(i2c_request_t *req, I2C_TransferReturn_TypeDef status)
+{
+  i2c_device_stats_t *stats = &deviceStats[req->device];
+  uint32_t latency = (uint32_t)timerNowUs() - req->submit_us;
+  int bucket = (latency >> I2C_LATENCY_BUCKET0_LOG2) ? 32 - __builtin_clz(latency >> I2C_LATENCY_BUCKET0_LOG2) : 0;
+
+  stats->transfers++;
+  stats->last_latency = latency;
+  stats->total_latency += latency;
+  if (latency > stats->max_latency) {
+      stats->max_latency = latency;
+  }
+  stats->latency_hist[(bucket < I2C_LATENCY_BUCKETS) ? bucket : I2C_LATENCY_BUCKETS - 1]++;
+  if (status != i2cTransferDone) {
+      stats->errors++;
+      stats->last_error = status;
+      LOG_WARN_LIMITED("I2C device %d transfer failed with error code: %d\n\r", req->device, status);
+  }
+
+  req->status = status;
+
+  if (req->callback) {
+      req->callback(status, req->arg);
+  }
+  else {
+      schedulerSetEventI2CDone((uint32_t)req);
+  }
+}
+
+/*
+ * Function Name: i2c_bus_start_next
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function starts the request at the head of the queue. Requests
+ * that fail to start are completed right away and the next one is tried.
+ * The EM1 requirement is released once the queue has drained. Called with
+ * interrupts masked or from the I2C0 IRQ.
+ *
+ */
+static void i2c_bus_start_next(void)
+{
+  while (queueCount) {
+      i2c_request_t *req = queue[queueHead];
+      I2C_TransferReturn_TypeDef status;
+
+      if (i2c_dma_eligible(&req->seq)) {
+          status = i2c_dma_start(&req->seq);
+      }
+      else {
+          status = I2C_TransferInit(I2C0, &req->seq);
+      }
+
+      if (status == i2cTransferInProgress) {
+          return; /* Rest of the transfer is run by the I2C0 IRQ */
+      }
+
+      queueHead = (queueHead + 1) % I2C_QUEUE_SIZE;
+      queueCount--;
+      i2c_bus_complete(req, status);
+  }
+
+  powerRelease(powerReasonI2C);
+  energyEnd(energySubI2C);
+}
+
+/*
+ * Function Name: i2c_bus_submit
+ *
+ * Parameters:
+ * i2c_request_t *req Transaction descriptor
+ *
+ * Returns:
+ * bool true if the request was queued, false if the queue is full
+ *
+ * Brief: This function queues a transaction for its device and returns right
+ * away. Requests are run in submission order; the next one is started from the
+ * I2C0 IRQ as soon as the previous one completes, so the app does not have to
+ * re-arm anything between transactions of different devices.
+ *
+ */
+bool i2c_bus_submit(i2c_request_t *req)
+{
+  if (req->device >= I2C_DEV_COUNT) {
+      return false;
+  }
+
+  req->seq.addr = deviceAddr[req->device] << 1;
+  req->status = i2cTransferInProgress;
+  req->submit_us = (uint32_t)timerNowUs();
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+
+  if (queueCount == I2C_QUEUE_SIZE) {
+      deviceStats[req->device].queue_full++;
+      CORE_EXIT_CRITICAL();
+      return false;
+  }
+
+  queue[(queueHead + queueCount) % I2C_QUEUE_SIZE] = req;
+  queueCount++;
+
+  if (queueCount == 1) { /* Bus was idle, I2C0 needs HFPERCLK so stay in EM1 */
+      powerRequire(powerReasonI2C);
+      energyBegin(energySubI2C);
+      i2c_bus_start_next();
+  }
+
+  CORE_EXIT_CRITICAL();
+
+  return true;
+}
+
+/*
+ * Function Name: i2c_bus_transfer_done
+ *
+ * Parameters:
+ * I2C_TransferReturn_TypeDef status Result of the transfer
+ * void *arg unused
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function is the completion callback of blocking transfers. The
+ * request is on the caller's stack and gone by the time the event is handled,
+ * so the event carries no request. It is still posted: a pending event keeps
+ * app_is_ok_to_sleep from putting the waiting caller to sleep after the
+ * transfer has already completed.
+ *
+ */
+static void i2c_bus_transfer_done(I2C_TransferReturn_TypeDef status, void *arg)
+{
+  (void) status;
+  (void) arg;
+
+  schedulerSetEventI2CDone(0);
+}
+
+/*
+ * Function Name: i2c_bus_transfer
+ *
+ * Parameters:
+ * i2c_request_t *req Transaction descriptor
+ *
+ * Returns:
+ * I2C_TransferReturn_TypeDef Result of the transfer
+ *
+ * Brief: This function queues a transaction and sleeps in EM1 until it has
+ * completed. The callback of req is replaced by a private one, so req may be
+ * on the caller's stack.
+ *
+ */
+I2C_TransferReturn_TypeDef i2c_bus_transfer(i2c_request_t *req)
+{
+  req->callback = i2c_bus_transfer_done;
+  req->arg = NULL;
+
+  if (!i2c_bus_submit(req)) {
+      return i2cTransferUsageFault;
+  }
+
+  while (req->status == i2cTransferInProgress) {
+      sl_power_manager_sleep(); /* EM1 requirement is held until the queue drains */
+  }
+
+  return req->status;
+}
+
+/*
+ * Function Name: i2c_bus_write_reg
+ *
+ * Parameters:
+ * i2c_device_t device Device on the bus
+ * uint8_t reg Register address
+ * uint8_t data Register value
+ *
+ * Returns:
+ * I2C_TransferReturn_TypeDef Result of the transfer
+ *
+ * Brief: This function writes one register of a device, sleeping in EM1 until
+ * the write has completed.
+ *
+ */
+I2C_TransferReturn_TypeDef i2c_bus_write_reg(i2c_device_t device, uint8_t reg, uint8_t data)
+{
+  i2c_request_t req = {
+    .device = device,
+    .seq.flags = I2C_FLAG_WRITE_WRITE,
+    .seq.buf[0].data = &reg,
+    .seq.buf[0].len = sizeof(reg),
+    .seq.buf[1].data = &data,
+    .seq.buf[1].len = sizeof(data),
+  };
+
+  return i2c_bus_transfer(&req);
+}
+
+/*
+ * Function Name: i2c_bus_read_regs
+ *
+ * Parameters:
+ * i2c_device_t device Device on the bus
+ * uint8_t reg First register address
+ * uint8_t *buf Read buffer
+ * uint16_t len Number of bytes to read
+ *
+ * Returns:
+ * I2C_TransferReturn_TypeDef Result of the transfer
+ *
+ * Brief: This function reads len consecutive registers of a device, sleeping in
+ * EM1 until the read has completed.
+ *
+ */
+I2C_TransferReturn_TypeDef i2c_bus_read_regs(i2c_device_t device, uint8_t reg, uint8_t *buf, uint16_t len)
+{
+  i2c_request_t req = {
+    .device = device,
+    .seq.flags = I2C_FLAG_WRITE_READ,
+    .seq.buf[0].data = &reg,
+    .seq.buf[0].len = sizeof(reg),
+    .seq.buf[1].data = buf,
+    .seq.buf[1].len = len,
+  };
+
+  return i2c_bus_transfer(&req);
+}
+
+/*
+ * Function Name: i2c_bus_idle
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * bool true when no transfer is running or queued
+ *
+ * Brief: This function returns whether the bus manager is idle.
+ *
+ */
+bool i2c_bus_idle(void)
+{
+  return (queueCount == 0);
+}
+
+/*
+ * Function Name: i2c_bus_get_stats
+ *
+ * Parameters:
+ * i2c_device_t device Device on the bus
+ *
+ * Returns:
+ * const i2c_device_stats_t * Statistics for the device, NULL for an invalid device
+ *
+ * Brief: This function returns the per device transfer, error and latency counters.
+ *
+ */
+const i2c_device_stats_t *i2c_bus_get_stats(i2c_device_t device)
+{
+  if (device >= I2C_DEV_COUNT) {
+      return NULL;
+  }
+  return &deviceStats[device];
+}
+
+/*
+ * Function Name: I2C0_IRQHandler
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: Interrupt handler for I2C0. Advances the em_i2c transfer state
+ * machine (or the LDMA read) for the request at the head of the queue and,
+ * once it is done, completes it and starts the next queued request.
+ *
+ */
+void I2C0_IRQHandler(void)
+{
+  I2C_TransferReturn_TypeDef status;
+
+  if (dmaState != i2cDmaIdle) {
+      status = i2c_dma_step();
+  }
+  else {
+      status = I2C_Transfer(I2C0);
+  }
+
+  if (status == i2cTransferInProgress || queueCount == 0) {
+      return;
+  }
+
+  i2c_request_t *req = queue[queueHead];
+  queueHead = (queueHead + 1) % I2C_QUEUE_SIZE;
+  queueCount--;
+
+  i2c_bus_complete(req, status);
+  i2c_bus_start_next();
+}
@@ -8,8 +8,61 @@
 #ifndef SRC_I2C_H_
 #define SRC_I2C_H_
 
+#include <stdint.h>
+#include <stdbool.h>
+#include "em_i2c.h"
+
+#define BME680_I2C_ADDR   0x76 /* Slave address for BME680 (SDO low) */
+#define AMG8833_I2C_ADDR  0x68 /* Slave address for Grid Eye (AD_SELECT low), 0x69 if high */
+#define MAX17048_I2C_ADDR 0x36 /* Slave address for MAX17048 fuel gauge */
+
+#define I2C_QUEUE_SIZE 8 /* Maximum number of queued bus requests */
+#define I2C_DMA_MIN_LEN 16 /* Register reads of at least this many bytes are received by the LDMA */
+
+/* Devices sharing the I2C0 bus */
+typedef enum {
+  I2C_DEV_BME680,
+  I2C_DEV_GRID_EYE,
+  I2C_DEV_MAX17048,
+  I2C_DEV_COUNT
+} i2c_device_t;
+
+/* Completion callback, called from the I2C0 IRQ */
+typedef void (*i2c_callback_t)(I2C_TransferReturn_TypeDef status, void *arg);
+
+/*
+ * Per device transaction descriptor. The caller owns the storage, which must
+ * stay valid until status is no longer i2cTransferInProgress. The slave
+ * address in seq is filled in by the bus manager from the device.
+ */
+typedef struct {
+  i2c_device_t device;
+  I2C_TransferSeq_TypeDef seq;
+  i2c_callback_t callback; /* NULL: set evtI2C0_Transfer_Done instead */
+  void *arg;
+  volatile I2C_TransferReturn_TypeDef status;
+  uint32_t submit_us; /* Set by the bus manager for latency accounting */
+} i2c_request_t;
+
+/* Latency histogram: bucket 0 is below 128 us, each further bucket doubles,
+ * the last one collects everything from 32.768 ms up */
+#define I2C_LATENCY_BUCKETS     10
+#define I2C_LATENCY_BUCKET0_LOG2 7
+
+/* Per device bus statistics, latency is submit to completion in microseconds */
+typedef struct {
+  uint32_t transfers;
+  uint32_t errors;
+  uint32_t queue_full;
+  I2C_TransferReturn_TypeDef last_error;
+  uint32_t last_latency;
+  uint32_t max_latency;
+  uint32_t total_latency;
+  uint32_t latency_hist[I2C_LATENCY_BUCKETS];
+} i2c_device_stats_t;
+
 /*
- * Function Name: read_temperature_Si7021
+ * Function Name: i2c_Init
  *
  * Parameters:
  * none
@@ -17,14 +70,107 @@
  * Returns:
  * none
  *
- * Brief: This function is used to read and measure the temperature in degrees
- * Celsius from the Si7021 sensor. The temperature values are logged onto UART.
+ * Brief: This function initializes the I2C0 peripheral and the bus manager.
+ *
+ */
+void i2c_Init(void);
+
+/*
+ * Function Name: i2c_bus_submit
+ *
+ * Parameters:
+ * i2c_request_t *req Transaction descriptor
+ *
+ * Returns:
+ * bool true if the request was queued, false if the queue is full
+ *
+ * Brief: This function queues a transaction for its device and returns right
+ * away. Requests are run in submission order; the next one is started from the
+ * I2C0 IRQ as soon as the previous one completes, so the app does not have to
+ * re-arm anything between transactions of different devices. Register reads
+ * of I2C_DMA_MIN_LEN bytes or more are received by the LDMA, so the CPU only
+ * wakes for the address phase, the last byte and the completion.
  *
  */
-//void read_BME680(void);
+bool i2c_bus_submit(i2c_request_t *req);
 
-void read_max_17048(void);
+/*
+ * Function Name: i2c_bus_transfer
+ *
+ * Parameters:
+ * i2c_request_t *req Transaction descriptor
+ *
+ * Returns:
+ * I2C_TransferReturn_TypeDef Result of the transfer
+ *
+ * Brief: This function queues a transaction and sleeps in EM1 until it has
+ * completed. The callback of req is replaced by a private one, so req may be
+ * on the caller's stack.
+ *
+ */
+I2C_TransferReturn_TypeDef i2c_bus_transfer(i2c_request_t *req);
 
-void read_grid_eye(void);
+/*
+ * Function Name: i2c_bus_write_reg
+ *
+ * Parameters:
+ * i2c_device_t device Device on the bus
+ * uint8_t reg Register address
+ * uint8_t data Register value
+ *
+ * Returns:
+ * I2C_TransferReturn_TypeDef Result of the transfer
+ *
+ * Brief: This function writes one register of a device, sleeping in EM1 until
+ * the write has completed.
+ *
+ */
+I2C_TransferReturn_TypeDef i2c_bus_write_reg(i2c_device_t device, uint8_t reg, uint8_t data);
+
+/*
+ * Function Name: i2c_bus_read_regs
+ *
+ * Parameters:
+ * i2c_device_t device Device on the bus
+ * uint8_t reg First register address
+ * uint8_t *buf Read buffer
+ * uint16_t len Number of bytes to read
+ *
+ * Returns:
+ * I2C_TransferReturn_TypeDef Result of the transfer
+ *
+ * Brief: This function reads len consecutive registers of a device, sleeping in
+ * EM1 until the read has completed.
+ *
+ */
+I2C_TransferReturn_TypeDef i2c_bus_read_regs(i2c_device_t device, uint8_t reg, uint8_t *buf, uint16_t len);
+
+/*
+ * Function Name: i2c_bus_idle
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * bool true when no transfer is running or queued
+ *
+ * Brief: This function returns whether the bus manager is idle.
+ *
+ */
+bool i2c_bus_idle(void);
+
+/*
+ * Function Name: i2c_bus_get_stats
+ *
+ * Parameters:
+ * i2c_device_t device Device on the bus
+ *
+ * Returns:
+ * const i2c_device_stats_t * Statistics for the device, NULL for an invalid device
+ *
+ * Brief: This function returns the per device transfer, error and latency counters.
+ *
+ */
+const i2c_device_stats_t *i2c_bus_get_stats(i2c_device_t device);
 
 #endif /* SRC_I2C_H_ */
@@ -7,9 +7,11 @@
 
 #include "em_device.h"
 #include "em_letimer.h"
+#include "em_gpio.h"
 #include "src/gpio.h"
 #include <stdint.h>
 #include "src/scheduler.h"
+#include "src/timers.h"
 
 /*
  * Function Name: letimer0_irq_init
@@ -47,10 +49,59 @@ void LETIMER0_IRQHandler(void)
 {
   /* Storing and clearing current LETIMER0 interrupt flags*/
   uint32_t flags = LETIMER_IntGetEnabled(LETIMER0);
+  if (flags & LETIMER_IF_UF) { /* Counted before the UF flag is cleared for the time base */
+      timerCountUnderflow();
+  }
   LETIMER_IntClear(LETIMER0, flags);
 
   if (flags & LETIMER_IF_UF) { /* Call schedulerSetEventUF for UF interrupt */
       schedulerSetEventUF();
   }
 
+  timerServiceIrq(flags); /* Software timers on UF and COMP1 */
+
+}
+
+/*
+ * Function Name: gpio_irq_init
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function enables the even GPIO interrupt line used by the
+ * Grid-EYE INT pin.
+ *
+ */
+void gpio_irq_init(void)
+{
+  GPIO_IntClear(1 << GRID_EYE_INT_pin);
+  NVIC_ClearPendingIRQ(GPIO_EVEN_IRQn);
+  NVIC_EnableIRQ(GPIO_EVEN_IRQn);
+}
+
+/*
+ * Function Name: GPIO_EVEN_IRQHandler
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This is the IRQ handler for even numbered GPIO interrupts. A falling
+ * edge on the Grid-EYE INT pin sets evtGridEye_Int.
+ *
+ */
+void GPIO_EVEN_IRQHandler(void)
+{
+  /* Storing and clearing current even GPIO interrupt flags*/
+  uint32_t flags = GPIO_IntGetEnabled() & 0x55555555;
+  GPIO_IntClear(flags);
+
+  if (flags & (1 << GRID_EYE_INT_pin)) {
+      schedulerSetEventGridEyeInt();
+  }
 }
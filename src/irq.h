@@ -21,4 +21,19 @@
  */
 void letimer0_irq_init(void);
 
+/*
+ * Function Name: gpio_irq_init
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function enables the even GPIO interrupt line used by the
+ * Grid-EYE INT pin.
+ *
+ */
+void gpio_irq_init(void);
+
 #endif /* SRC_IRQ_H_ */
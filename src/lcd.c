@@ -57,13 +57,18 @@
 
 #include "glib.h" // the low-level graphics driver/library
 #include "dmd.h"  // the dot matrix display driver
+#include "sl_memlcd.h"
+#include "sl_memlcd_display.h"
 
 
 #include "lcd.h"
+#include "heatmap.h"
+#include "lcd_dma.h"
 
 
 // Include logging specifically for this .c file
 #define INCLUDE_LOG_DEBUG 1
+#define LOG_MODULE LOG_MOD_LCD
 #include "log.h"
 
 
@@ -138,6 +143,8 @@ void displayPrintf(enum display_row row, const char *format, ...)
    size_t                 strLen;
    char                   strToDisplay[DISPLAY_ROW_LEN+1]; // +1 for null terminator
    char                   strToErase[DISPLAY_ROW_LEN+1];   // +1 for null terminator
+   uint16_t               lineY;      // first pixel row of the text row
+   uint16_t               lineHeight; // pixel rows of the text row
 
    // Range check the row number
    if (row >= DISPLAY_NUMBER_OF_ROWS) {
@@ -176,12 +183,15 @@ void displayPrintf(enum display_row row, const char *format, ...)
      if ((strLen-1) > DISPLAY_ROW_LEN) {
          // For feedback to the user, we don't count the null terminator char, so
          // DISPLAY_ROW_LEN and not DISPLAY_ROW_LEN+1
-         LOG_WARN("Your formatted string for row=%d was truncated to (%d) characters", row, DISPLAY_ROW_LEN);
-         LOG_WARN("  The truncated string is: %s", strToDisplay);
+         LOG_WARN_NOW("Your formatted string for row=%d was truncated to (%d) characters", row, DISPLAY_ROW_LEN);
+         LOG_WARN_NOW("  The truncated string is: %s", strToDisplay);
      } // if
    } // else
 
 
+   // The LDMA may still be sending the framebuffer of the previous update
+   lcdDmaWait();
+
    // We always erase the whole line first, then draw the new string. This way
    // we don't leave any pixels set from the previous characters.
    for (int i=0; i<DISPLAY_ROW_LEN; i++) {
@@ -215,10 +225,15 @@ void displayPrintf(enum display_row row, const char *format, ...)
    }
 
 
-   // Update the data the LCD is displaying
-   status = DMD_updateDisplay();
-   if (status != DMD_OK) {
-       LOG_ERROR("DMD_updateDisplay() returned non-zero error code=0x%04x", (unsigned int) status);
+   // Update the data the LCD is displaying, only the pixel rows of this text row
+   // are sent
+   lineHeight = display->glibContext.font.fontHeight + display->glibContext.font.lineSpacing;
+   lineY      = row * lineHeight;
+   if (lineY + lineHeight > SL_MEMLCD_DISPLAY_HEIGHT) {
+       lineHeight = SL_MEMLCD_DISPLAY_HEIGHT - lineY;
+   }
+   if (!lcdDmaDraw(lineY, lineHeight)) {
+       LOG_ERROR("lcdDmaDraw() failed for row=%d", (int) row);
    }
 
 } // displayPrintf()
@@ -226,6 +241,39 @@ void displayPrintf(enum display_row row, const char *format, ...)
 
 
 
+/**
+ * Draws an 8x8 Grid-EYE frame (Q8.8 degC) as a dithered heat map.
+ * The heat map is rendered straight into the DMD framebuffer bytes instead of
+ * through GLIB_drawPixel(), so a frame costs one pass over the pixels. The DMD
+ * dirty row flags are private to the driver, so the heat map rows are sent to
+ * the LCD here with a single lcdDmaDraw() call.
+ */
+void displayHeatmap(const int16_t *frame)
+{
+  EMSTATUS       status;
+  uint8_t        *fb;
+  const uint16_t stride = (SL_MEMLCD_DISPLAY_WIDTH * SL_MEMLCD_DISPLAY_BPP) / 8;
+
+  status = DMD_getFrameBuffer((void **) &fb);
+  if (status != DMD_OK) {
+      LOG_ERROR("DMD_getFrameBuffer() returned non-zero error code=0x%04x", (unsigned int) status);
+      return;
+  }
+
+  // The LDMA may still be sending the framebuffer of the previous update
+  lcdDmaWait();
+
+  heatmap_render(frame, DISPLAY_HEATMAP_SIZE, fb, stride, DISPLAY_HEATMAP_X, DISPLAY_HEATMAP_Y);
+
+  if (!lcdDmaDraw(DISPLAY_HEATMAP_Y, DISPLAY_HEATMAP_SIZE)) {
+      LOG_ERROR("lcdDmaDraw() failed for the heat map rows");
+  }
+
+} // displayHeatmap()
+
+
+
+
 /**
  * Initialize the LCD display.
  * This also starts a BT stack soft timer, don't call this until after the boot event.
@@ -263,6 +311,9 @@ void displayInit()
         LOG_ERROR("DMD_init() returned non-zero error code=0x%04x", (unsigned int) status);
     }
 
+    // Build the LDMA descriptor chain over the DMD framebuffer
+    lcdDmaInit();
+
 
     // Initialize the glib context
     status = GLIB_contextInit(&display->glibContext);
@@ -288,9 +339,8 @@ void displayInit()
     }
 
 
-    status = DMD_updateDisplay();
-    if (status != DMD_OK) {
-        LOG_ERROR("DMD_updateDisplay() returned non-zero error code=0x%04x", (unsigned int) status);
+    if (!lcdDmaDraw(0, SL_MEMLCD_DISPLAY_HEIGHT)) {
+        LOG_ERROR("lcdDmaDraw() failed for the whole display");
     }
 
 
@@ -26,6 +26,8 @@
 #ifndef SRC_LCD_H_
 #define SRC_LCD_H_
 
+#include <stdint.h>
+
 
 
 
@@ -54,6 +56,12 @@ enum display_row {
 // The number of characters per row
 #define DISPLAY_ROW_LEN      20
 
+// Grid-EYE heat map, centered along the bottom edge below DISPLAY_ROW_TEMPVALUE.
+// Text rows 8 and up are drawn over by the heat map.
+#define DISPLAY_HEATMAP_SIZE 48
+#define DISPLAY_HEATMAP_X    ((128 - DISPLAY_HEATMAP_SIZE) / 2)
+#define DISPLAY_HEATMAP_Y    (128 - DISPLAY_HEATMAP_SIZE)
+
 
 
 // function prototypes
@@ -61,6 +69,7 @@ enum display_row {
 void displayInit();
 void displayUpdate();
 void displayPrintf(enum display_row row, const char *format, ...);
+void displayHeatmap(const int16_t *frame);
 
 
 
@@ -0,0 +1,276 @@
+/*
+* File Name: lcd_dma.c
+* File Description: This file contains the LDMA refresh path of the Sharp
+* memory LCD (USART1). The update command, the dummy/address bytes of every row,
+* the framebuffer rows and the trailer are one descriptor chain built once over
+* the DMD framebuffer; a refresh patches where the chain starts and ends and
+* kicks it, so the core sleeps in EM1 while the rows are shifted out instead of
+* feeding USART1 byte by byte.
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#include <stdint.h>
+#include "em_device.h"
+#include "em_core.h"
+#include "em_gpio.h"
+#include "em_usart.h"
+#include "em_ldma.h"
+#include "dmadrv.h"
+#include "dmd.h"
+#include "sl_memlcd.h"
+#include "sl_memlcd_display.h"
+#include "sl_memlcd_usart_config.h"
+#include "sl_power_manager.h"
+#include "sl_udelay.h"
+#include "src/power.h"
+#include "src/energy.h"
+#include "src/lcd_dma.h"
+
+/* The LDMA request signal is that of the USART in sl_memlcd_usart_config.h */
+#define LCD_TX_SIGNAL  ldmaPeripheralSignal_USART1_TXBL
+
+#define LCD_ROWS       SL_MEMLCD_DISPLAY_HEIGHT
+#define LCD_ROW_BYTES  ((SL_MEMLCD_DISPLAY_WIDTH * SL_MEMLCD_DISPLAY_BPP) / 8)
+#define LCD_CMD_UPDATE 0x01 /* Same as CMD_UPDATE in sl_memlcd.c */
+
+/* Sent low byte first, as sl_memlcd_draw does */
+static uint16_t rowHeader[LCD_ROWS];        /* Dummy byte, then the gate line of the next row */
+static uint16_t startHeader;                /* Update command, then the gate line of the first row */
+static const uint16_t trailer = 0xFFFF;     /* 16 dummy bits end the update */
+
+static LDMA_Descriptor_t startDesc;
+static LDMA_Descriptor_t rowDesc[LCD_ROWS];     /* Framebuffer bytes of a row */
+static LDMA_Descriptor_t headerDesc[LCD_ROWS];  /* rowHeader[r], ahead of rowDesc[r] */
+static LDMA_Descriptor_t trailerDesc;
+static LDMA_TransferCfg_t txCfg = LDMA_TRANSFER_CFG_PERIPHERAL(LCD_TX_SIGNAL);
+
+static uint16_t lastRow = LCD_ROWS - 1;     /* Row whose descriptor links to the trailer */
+static volatile bool busy = false;          /* Refresh running, powerReasonLcd held */
+static bool dmaAvailable = false;
+
+static unsigned int lcdChannel;
+static const sl_memlcd_t *memlcd;
+static uint8_t *framebuffer;
+
+/*
+ * Function Name: lcd_dma_link
+ *
+ * Parameters:
+ * LDMA_Descriptor_t *desc Descriptor to change
+ * LDMA_Descriptor_t *next Descriptor the LDMA loads after desc
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function sets the absolute link address of a descriptor. The
+ * LDMA takes it without the two low bits, descriptors are word aligned.
+ *
+ */
+static void lcd_dma_link(LDMA_Descriptor_t *desc, LDMA_Descriptor_t *next)
+{
+  desc->xfer.linkAddr = (uint32_t) next >> 2;
+}
+
+/*
+ * Function Name: lcd_dma_done
+ *
+ * Parameters:
+ * unsigned int channel LDMA channel
+ * unsigned int sequenceNo DMADRV sequence number
+ * void *userParam unused
+ *
+ * Returns:
+ * bool true (DMADRV ignores the return value for single transfers)
+ *
+ * Brief: DMADRV callback, called from the LDMA IRQ once the trailer is in the
+ * USART1 TX buffer. The last two bytes are waited out before SCS is released,
+ * about 15 us at the memory LCD bit rate, then the EM1 requirement is dropped.
+ *
+ */
+static bool lcd_dma_done(unsigned int channel, unsigned int sequenceNo, void *userParam)
+{
+  (void) channel;
+  (void) sequenceNo;
+  (void) userParam;
+
+  while (!(SL_MEMLCD_SPI_PERIPHERAL->STATUS & USART_STATUS_TXC)) {
+  }
+  sl_udelay_wait(memlcd->hold_us);
+  GPIO_PinOutClear(SL_MEMLCD_SPI_CS_PORT, SL_MEMLCD_SPI_CS_PIN);
+
+  busy = false;
+  energyEnd(energySubLcd);
+  powerRelease(powerReasonLcd);
+
+  return true;
+}
+
+/*
+ * Function Name: lcd_dma_idle
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * bool true when no refresh is running
+ *
+ * Brief: This function is the wake condition of lcdDmaWait.
+ *
+ */
+static bool lcd_dma_idle(void)
+{
+  return !busy;
+}
+
+/*
+ * Function Name: lcdDmaInit
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function builds the LDMA descriptor chain over the DMD
+ * framebuffer: for every row a descriptor for its dummy/address bytes linked to
+ * one for its framebuffer bytes, linked to the next row. It must be called
+ * after DMD_init. Without a free LDMA channel lcdDmaDraw falls back to
+ * sl_memlcd_draw.
+ *
+ */
+void lcdDmaInit(void)
+{
+  volatile uint32_t *txData = &SL_MEMLCD_SPI_PERIPHERAL->TXDATA;
+
+  memlcd = sl_memlcd_get();
+  if (memlcd == NULL || DMD_getFrameBuffer((void **) &framebuffer) != DMD_OK) {
+      memlcd = NULL;
+      return;
+  }
+
+  /* DMADRV may already have been initialized by another driver */
+  Ecode_t ecode = DMADRV_Init();
+  if (ecode != ECODE_EMDRV_DMADRV_OK && ecode != ECODE_EMDRV_DMADRV_ALREADY_INITIALIZED) {
+      return;
+  }
+  if (DMADRV_AllocateChannel(&lcdChannel, NULL) != ECODE_EMDRV_DMADRV_OK) {
+      return;
+  }
+
+  /* Each row is its header linked to its framebuffer bytes, linked to the
+   * header of the next row; the last row ends on the trailer */
+  for (uint16_t r = 0; r < LCD_ROWS; r++) {
+      rowHeader[r] = 0xFF | ((r + 1) << 8);
+
+      headerDesc[r] = (LDMA_Descriptor_t)
+          LDMA_DESCRIPTOR_LINKABS_M2P_BYTE(&rowHeader[r], txData, sizeof(rowHeader[r]));
+      rowDesc[r] = (LDMA_Descriptor_t)
+          LDMA_DESCRIPTOR_LINKABS_M2P_BYTE(framebuffer + r * LCD_ROW_BYTES, txData, LCD_ROW_BYTES);
+  }
+  for (uint16_t r = 0; r < LCD_ROWS; r++) {
+      lcd_dma_link(&headerDesc[r], &rowDesc[r]);
+      lcd_dma_link(&rowDesc[r], (r + 1 < LCD_ROWS) ? &headerDesc[r + 1] : &trailerDesc);
+  }
+
+  startDesc = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_LINKABS_M2P_BYTE(&startHeader, txData, sizeof(startHeader));
+  trailerDesc = (LDMA_Descriptor_t)
+      LDMA_DESCRIPTOR_SINGLE_M2P_BYTE(&trailer, txData, sizeof(trailer));
+  lastRow = LCD_ROWS - 1;
+
+  dmaAvailable = true;
+}
+
+/*
+ * Function Name: lcdDmaDraw
+ *
+ * Parameters:
+ * uint16_t row_start First framebuffer row to send
+ * uint16_t row_count Number of rows
+ *
+ * Returns:
+ * bool false if the rows are outside the display
+ *
+ * Brief: This function sends framebuffer rows to the memory LCD with one LDMA
+ * kick and returns; the core sleeps in EM1 while USART1 shifts the rows out
+ * and SCS is released from the completion interrupt. A refresh still running
+ * is waited for first. If the LDMA transfer cannot be started the rows are
+ * sent with sl_memlcd_draw instead.
+ *
+ */
+bool lcdDmaDraw(uint16_t row_start, uint16_t row_count)
+{
+  uint16_t last = row_start + row_count - 1;
+
+  if (memlcd == NULL || row_count == 0 || row_start + row_count > LCD_ROWS) {
+      return false;
+  }
+
+  lcdDmaWait();
+
+  if (!dmaAvailable) {
+      energyBegin(energySubLcd);
+      sl_memlcd_draw(memlcd, framebuffer + row_start * LCD_ROW_BYTES, row_start, row_count);
+      energyEnd(energySubLcd);
+      return true;
+  }
+
+  /* Move the end of the chain: the previous last row links on to the next
+   * row again and the new one links to the trailer */
+  if (lastRow + 1 < LCD_ROWS) {
+      lcd_dma_link(&rowDesc[lastRow], &headerDesc[lastRow + 1]);
+  }
+  lcd_dma_link(&rowDesc[last], &trailerDesc);
+  lastRow = last;
+
+  /* The update command carries the first row's address, so the chain enters
+   * at its framebuffer bytes rather than at its header */
+  startHeader = LCD_CMD_UPDATE | ((row_start + 1) << 8);
+  lcd_dma_link(&startDesc, &rowDesc[row_start]);
+
+  busy = true;
+  powerRequire(powerReasonLcd);
+  energyBegin(energySubLcd);
+
+  GPIO_PinOutSet(SL_MEMLCD_SPI_CS_PORT, SL_MEMLCD_SPI_CS_PIN);
+  sl_udelay_wait(memlcd->setup_us);
+
+  if (DMADRV_LdmaStartTransfer(lcdChannel, &txCfg, &startDesc, lcd_dma_done, NULL) != ECODE_EMDRV_DMADRV_OK) {
+      /* Nothing was sent, undo the refresh and send the rows by polling */
+      GPIO_PinOutClear(SL_MEMLCD_SPI_CS_PORT, SL_MEMLCD_SPI_CS_PIN);
+      busy = false;
+      powerRelease(powerReasonLcd);
+
+      sl_memlcd_draw(memlcd, framebuffer + row_start * LCD_ROW_BYTES, row_start, row_count);
+      energyEnd(energySubLcd);
+  }
+
+  return true;
+}
+
+/*
+ * Function Name: lcdDmaWait
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function sleeps in EM1 until the running refresh is done. It
+ * must be called before the framebuffer is drawn into, so rows are not
+ * changed while the LDMA reads them.
+ *
+ */
+/*
+ * lcd_dma_done can clear busy between the check and the WFI, so the wait goes
+ * through powerSleepUntil, which app_is_ok_to_sleep checks with interrupts
+ * disabled.
+ */
+void lcdDmaWait(void)
+{
+  if (busy) {
+      powerSleepUntil(lcd_dma_idle);
+  }
+}
@@ -0,0 +1,68 @@
+/*
+* File Name: lcd_dma.h
+* File Description: This file contains the declarations for the LDMA memory
+* LCD refresh in lcd_dma.c
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#ifndef SRC_LCD_DMA_H_
+#define SRC_LCD_DMA_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Function Name: lcdDmaInit
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function builds the LDMA descriptor chain over the DMD
+ * framebuffer: for every row a descriptor for its dummy/address bytes linked to
+ * one for its framebuffer bytes, linked to the next row. It must be called
+ * after DMD_init. Without a free LDMA channel lcdDmaDraw falls back to
+ * sl_memlcd_draw.
+ *
+ */
+void lcdDmaInit(void);
+
+/*
+ * Function Name: lcdDmaDraw
+ *
+ * Parameters:
+ * uint16_t row_start First framebuffer row to send
+ * uint16_t row_count Number of rows
+ *
+ * Returns:
+ * bool false if the rows are outside the display
+ *
+ * Brief: This function sends framebuffer rows to the memory LCD with one LDMA
+ * kick and returns; the core sleeps in EM1 while USART1 shifts the rows out
+ * and SCS is released from the completion interrupt. A refresh still running
+ * is waited for first. If the LDMA transfer cannot be started the rows are
+ * sent with sl_memlcd_draw instead.
+ *
+ */
+bool lcdDmaDraw(uint16_t row_start, uint16_t row_count);
+
+/*
+ * Function Name: lcdDmaWait
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function sleeps in EM1 until the running refresh is done. It
+ * must be called before the framebuffer is drawn into, so rows are not
+ * changed while the LDMA reads them.
+ *
+ */
+void lcdDmaWait(void);
+
+#endif /* SRC_LCD_DMA_H_ */
@@ -15,10 +15,235 @@
 
 
 #include <stdbool.h>
+#include <stdarg.h>
+#include "em_device.h"
+#include "em_core.h"
 
 // Include logging for this file
 #define INCLUDE_LOG_DEBUG 1
 #include "log.h"
+#include "timers.h"
+#include "sl_iostream.h"
+
+
+
+#define LOG_RING_LEN  32 /* Messages held until the next drain, a power of 2 */
+#define LOG_RING_MASK (LOG_RING_LEN - 1)
+
+#if (LOG_RING_LEN & LOG_RING_MASK) != 0
+#error "LOG_RING_LEN must be a power of 2"
+#endif
+
+#define LOG_FRAME_SYNC0 0xFF /* Binary frames start with bytes that are never in text */
+#define LOG_FRAME_SYNC1 0xA5
+
+// One deferred message
+typedef struct {
+  const log_msg_t *msg;
+  uint32_t timestamp;
+  uint32_t nargs;
+  uint32_t args[LOG_MAX_ARGS];
+} log_record_t;
+
+// Multiple producers reserve a slot by advancing head with LDREX/STREX, fill
+// it and mark it ready, as the scheduler queues do; only logDrain() reads.
+static log_record_t ring[LOG_RING_LEN];
+static volatile uint8_t ready[LOG_RING_LEN];
+static volatile uint32_t head; /* Next slot to reserve */
+static volatile uint32_t tail; /* Next slot to drain */
+static volatile uint32_t dropped; /* Messages lost to a full ring since the last drain */
+
+volatile uint8_t logMask[LOG_MOD_COUNT] = {
+  [LOG_MOD_APP]       = LOG_MASK_ALL,
+  [LOG_MOD_SCHEDULER] = LOG_MASK_ALL,
+  [LOG_MOD_I2C]       = LOG_MASK_ALL,
+  [LOG_MOD_BME680]    = LOG_MASK_ALL,
+  [LOG_MOD_GRID_EYE]  = LOG_MASK_ALL,
+  [LOG_MOD_LCD]       = LOG_MASK_ALL,
+  [LOG_MOD_BLE]       = LOG_MASK_ALL,
+};
+
+
+
+/**
+ * Set the runtime mask of enabled levels of a module, LOG_BIT() per level.
+ * Unknown modules are ignored.
+ */
+void logSetMask(uint32_t module, uint8_t mask)
+{
+  if (module < LOG_MOD_COUNT) {
+      logMask[module] = mask & LOG_MASK_ALL;
+  }
+}
+
+
+
+/**
+ * @return the runtime mask of enabled levels of a module, 0 for unknown modules
+ */
+uint8_t logGetMask(uint32_t module)
+{
+  return (module < LOG_MOD_COUNT) ? logMask[module] : 0;
+}
+
+
+
+/**
+ * Token bucket of a rate limited call site. Refills one token per
+ * LOG_LIMIT_PERIOD_MS up to LOG_LIMIT_BURST and takes one if there is one.
+ * @return true if the message may be logged; *suppressed is then set to the
+ * number of messages dropped since the previous one passed
+ */
+bool logLimitTake(log_limit_t *limit, uint32_t *suppressed)
+{
+  uint32_t now, earned;
+  bool pass;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+
+  now = loggerGetTimestamp();
+  earned = (now - limit->stamp) / LOG_LIMIT_PERIOD_MS;
+  if (earned) {
+      limit->tokens += earned;
+      limit->stamp += earned * LOG_LIMIT_PERIOD_MS;
+  }
+  if (limit->tokens >= LOG_LIMIT_BURST) {
+      limit->tokens = LOG_LIMIT_BURST;
+      limit->stamp = now; /* A full bucket does not keep earning */
+  }
+
+  pass = (limit->tokens > 0);
+  if (pass) {
+      limit->tokens--;
+      *suppressed = limit->suppressed;
+      limit->suppressed = 0;
+  }
+  else {
+      limit->suppressed++;
+  }
+
+  CORE_EXIT_CRITICAL();
+
+  return pass;
+}
+
+
+
+void logDeferred(const log_msg_t *msg, uint32_t nargs, ...)
+{
+  uint32_t slot, index;
+  va_list ap;
+
+  do {
+      slot = __LDREXW(&head);
+      if (slot - tail >= LOG_RING_LEN) {
+          __CLREX();
+          while (__STREXW(__LDREXW(&dropped) + 1, &dropped)) {
+          }
+          return;
+      }
+  } while (__STREXW(slot + 1, &head));
+
+  index = slot & LOG_RING_MASK;
+  ring[index].msg = msg;
+  ring[index].timestamp = loggerGetTimestamp();
+  ring[index].nargs = (nargs > LOG_MAX_ARGS) ? LOG_MAX_ARGS : nargs;
+
+  va_start(ap, nargs);
+  for (uint32_t i = 0; i < ring[index].nargs; i++) {
+      ring[index].args[i] = va_arg(ap, uint32_t);
+  }
+  va_end(ap);
+
+  __DMB(); /* Record before the ready flag */
+  ready[index] = 1;
+}
+
+
+
+bool logPending(void)
+{
+  return (tail != head) || (dropped != 0);
+}
+
+
+
+/**
+ * Write one record. Arguments are passed on as 32 bit words, which is what
+ * every conversion other than 64 bit integers and doubles consumes on the
+ * Cortex-M.
+ */
+static void log_write(const log_record_t *rec)
+{
+#if LOG_BINARY
+  uint8_t frame[2 + 1 + 4 + 4 + 4 * LOG_MAX_ARGS];
+  uint32_t words[2 + LOG_MAX_ARGS];
+  uint32_t len = 0;
+
+  words[0] = (uint32_t)(uintptr_t)rec->msg;
+  words[1] = rec->timestamp;
+  for (uint32_t i = 0; i < rec->nargs; i++) {
+      words[2 + i] = rec->args[i];
+  }
+
+  frame[len++] = LOG_FRAME_SYNC0;
+  frame[len++] = LOG_FRAME_SYNC1;
+  frame[len++] = (uint8_t)rec->nargs;
+  for (uint32_t i = 0; i < 2 + rec->nargs; i++) { /* Little endian */
+      frame[len++] = (uint8_t)words[i];
+      frame[len++] = (uint8_t)(words[i] >> 8);
+      frame[len++] = (uint8_t)(words[i] >> 16);
+      frame[len++] = (uint8_t)(words[i] >> 24);
+  }
+
+  sl_iostream_write(app_log_iostream, frame, len);
+#else
+  const uint32_t *a = rec->args;
+
+  app_log("%5"PRIu32":%s:%s: ", rec->timestamp, rec->msg->level, rec->msg->func);
+  app_log_append(rec->msg->format, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8], a[9]);
+  app_log_append("\n");
+#endif
+}
+
+
+
+/**
+ * Format and write every deferred message. Called from the super-loop once
+ * all events are handled, never from an interrupt.
+ */
+void logDrain(void)
+{
+  log_record_t rec;
+  uint32_t lost;
+
+  for (;;) {
+      uint32_t index = tail & LOG_RING_MASK;
+
+      /* A reserved slot that is not ready yet belongs to an interrupted
+       * producer, it is written on the next drain */
+      if (tail == head || !ready[index]) {
+          break;
+      }
+
+      __DMB(); /* Ready flag before the record */
+      rec = ring[index];
+      ready[index] = 0;
+      __DMB(); /* Record copied before the slot is released */
+      tail = tail + 1;
+
+      log_write(&rec);
+  }
+
+  do {
+      lost = __LDREXW(&dropped);
+  } while (__STREXW(0, &dropped));
+
+  if (lost) {
+      LOG_WARN_NOW("%lu log messages dropped, ring full", (unsigned long)lost);
+  }
+}
 
 
 
@@ -39,14 +264,11 @@ uint32_t loggerGetTimestamp()
 	   return getSysTicks();
 	   
     #else
-    
-       // Students: You will eventually develop this function letimerMilliseconds()
-       //           and not return 0. This will be the function to call for your graded
-       //           assignments. Put the letimerMilliseconds() function in your irq.c/.h files.
-       
-       //return letimerMilliseconds();
-	   return (0);
-	   
+
+       // Milliseconds from the LETIMER0 time base, lock free so it can be
+       // called from interrupts
+       return timerNowMs();
+
     #endif
 
 } // loggerGetTimestamp
@@ -75,7 +297,7 @@ void printSLErrorString(sl_status_t status) {
   //   that only when this returned value is strictly positive and less than
   //   buffer_length, the status string has been completely written in the buffer.
   if ((result > 0) && (result < 128)) {
-      LOG_ERROR("Error code 0x%04x is %s", (unsigned int) status, &buffer[0] );
+      LOG_ERROR_NOW("Error code 0x%04x is %s", (unsigned int) status, &buffer[0] );
   } else {
       LOG_ERROR("Unable to convert error code 0x%04x into a string", (unsigned int) status);
   }
@@ -84,5 +306,18 @@ void printSLErrorString(sl_status_t status) {
 
 
 
+#if defined(DEBUG_EFM_USER)
+/**
+ * emlib assert handler, used when the build defines DEBUG_EFM_USER. The VCOM
+ * is switched to blocking writes first, so the message is out before the
+ * watchdog or the debugger resets the board.
+ */
+void assertEFM(const char *file, int line)
+{
+  vcomSetBlocking(true);
+  LOG_ERROR_NOW("EFM_ASSERT failed at %s:%d", file, line);
 
-
+  while (true) {
+  }
+} // assertEFM()
+#endif
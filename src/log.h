@@ -16,45 +16,260 @@
 #define SRC_LOG_H_
 #include "stdio.h"
 #include <inttypes.h>
+#include <stdbool.h>
 
 #include "app_log.h"   // for LOG_INFO() / printf() / app_log() output the VCOM port
 #include "sl_status.h" // for sl_status_print()
+#include "vcom.h"      // for vcomFlush() behind LOG_ERROR_NOW()
 
 
-#ifndef LOG_ERROR
-#define LOG_ERROR(message,...) \
-	LOG_DO(message,"Error", ##__VA_ARGS__)
+// Deferred logging: a call site only stores a pointer to its message
+// descriptor, the timestamp and its arguments as 32 bit words in a lock-free
+// ring, which is safe from interrupts. The ring is formatted and written to
+// the VCOM port by logDrain() when the super-loop has run out of events.
+// Every argument must fit in 32 bits; a %s argument must point to a string
+// that outlives the call, use the _NOW variants for stack buffers.
+#ifndef LOG_DEFERRED
+#define LOG_DEFERRED 1
 #endif
 
-#ifndef LOG_WARN
-#define LOG_WARN(message,...) \
-	LOG_DO(message,"Warn ", ##__VA_ARGS__)
+// With LOG_BINARY the ring is written as binary frames instead of text and
+// rebuilt on the host by tools/log_decode.py from the .axf. This removes the
+// vsnprintf from the device entirely.
+#ifndef LOG_BINARY
+#define LOG_BINARY 0
 #endif
 
-#ifndef LOG_INFO
-#define LOG_INFO(message,...) \
-	LOG_DO(message,"Info ", ##__VA_ARGS__)
+#define LOG_MAX_ARGS 10 /* Argument words per message */
+
+// Message descriptor, placed in flash by each call site. Its address is the
+// message ID.
+typedef struct {
+  const char *level;
+  const char *func;
+  const char *format;
+} log_msg_t;
+
+void logDeferred(const log_msg_t *msg, uint32_t nargs, ...);
+void logDrain(void);
+bool logPending(void);
+
+// Argument count, 0..LOG_MAX_ARGS
+#define LOG_NARGS(...) LOG_NARGS_(0, ##__VA_ARGS__, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, N, ...) N
+
+// Each argument as one 32 bit word
+#define LOG_W(x) ((uint32_t)(uintptr_t)(x))
+#define LOG_ARGS_0()
+#define LOG_ARGS_1(a)                            , LOG_W(a)
+#define LOG_ARGS_2(a, b)                         LOG_ARGS_1(a) LOG_ARGS_1(b)
+#define LOG_ARGS_3(a, b, c)                      LOG_ARGS_1(a) LOG_ARGS_2(b, c)
+#define LOG_ARGS_4(a, b, c, d)                   LOG_ARGS_1(a) LOG_ARGS_3(b, c, d)
+#define LOG_ARGS_5(a, b, c, d, e)                LOG_ARGS_1(a) LOG_ARGS_4(b, c, d, e)
+#define LOG_ARGS_6(a, b, c, d, e, f)             LOG_ARGS_1(a) LOG_ARGS_5(b, c, d, e, f)
+#define LOG_ARGS_7(a, b, c, d, e, f, g)          LOG_ARGS_1(a) LOG_ARGS_6(b, c, d, e, f, g)
+#define LOG_ARGS_8(a, b, c, d, e, f, g, h)       LOG_ARGS_1(a) LOG_ARGS_7(b, c, d, e, f, g, h)
+#define LOG_ARGS_9(a, b, c, d, e, f, g, h, i)    LOG_ARGS_1(a) LOG_ARGS_8(b, c, d, e, f, g, h, i)
+#define LOG_ARGS_10(a, b, c, d, e, f, g, h, i, j) LOG_ARGS_1(a) LOG_ARGS_9(b, c, d, e, f, g, h, i, j)
+#define LOG_CAT(a, b)  LOG_CAT_(a, b)
+#define LOG_CAT_(a, b) a##b
+
+
+// Levels. Each module has a compile time level, calls above it compile to
+// nothing and their format strings are not in the image. Below it a runtime
+// mask per module, one bit per level, turns levels off and on again.
+#define LOG_LEVEL_OFF   0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+
+#define LOG_BIT(level)  (1u << (level))
+#define LOG_MASK_ALL    (LOG_BIT(LOG_LEVEL_ERROR) | LOG_BIT(LOG_LEVEL_WARN) | LOG_BIT(LOG_LEVEL_INFO))
+
+// Modules; a .c file selects its module by defining LOG_MODULE before it
+// includes this file, files that do not are logged as LOG_MOD_APP
+#define LOG_MOD_APP       0
+#define LOG_MOD_SCHEDULER 1
+#define LOG_MOD_I2C       2
+#define LOG_MOD_BME680    3
+#define LOG_MOD_GRID_EYE  4
+#define LOG_MOD_LCD       5
+#define LOG_MOD_BLE       6
+#define LOG_MOD_COUNT     7
+
+// Release builds keep errors and warnings only
+#ifndef LOG_LEVEL_DEFAULT
+#ifdef NDEBUG
+#define LOG_LEVEL_DEFAULT LOG_LEVEL_WARN
+#else
+#define LOG_LEVEL_DEFAULT LOG_LEVEL_INFO
 #endif
+#endif
+
+#ifndef LOG_LEVEL_APP
+#define LOG_LEVEL_APP       LOG_LEVEL_DEFAULT
+#endif
+#ifndef LOG_LEVEL_SCHEDULER
+#define LOG_LEVEL_SCHEDULER LOG_LEVEL_DEFAULT
+#endif
+#ifndef LOG_LEVEL_I2C
+#define LOG_LEVEL_I2C       LOG_LEVEL_DEFAULT
+#endif
+#ifndef LOG_LEVEL_BME680
+#define LOG_LEVEL_BME680    LOG_LEVEL_DEFAULT
+#endif
+#ifndef LOG_LEVEL_GRID_EYE
+#define LOG_LEVEL_GRID_EYE  LOG_LEVEL_DEFAULT
+#endif
+#ifndef LOG_LEVEL_LCD
+#define LOG_LEVEL_LCD       LOG_LEVEL_DEFAULT
+#endif
+#ifndef LOG_LEVEL_BLE
+#define LOG_LEVEL_BLE       LOG_LEVEL_DEFAULT
+#endif
+
+#ifndef LOG_MODULE
+#define LOG_MODULE LOG_MOD_APP
+#endif
+
+#if LOG_MODULE == LOG_MOD_SCHEDULER
+#define LOG_MODULE_LEVEL LOG_LEVEL_SCHEDULER
+#elif LOG_MODULE == LOG_MOD_I2C
+#define LOG_MODULE_LEVEL LOG_LEVEL_I2C
+#elif LOG_MODULE == LOG_MOD_BME680
+#define LOG_MODULE_LEVEL LOG_LEVEL_BME680
+#elif LOG_MODULE == LOG_MOD_GRID_EYE
+#define LOG_MODULE_LEVEL LOG_LEVEL_GRID_EYE
+#elif LOG_MODULE == LOG_MOD_LCD
+#define LOG_MODULE_LEVEL LOG_LEVEL_LCD
+#elif LOG_MODULE == LOG_MOD_BLE
+#define LOG_MODULE_LEVEL LOG_LEVEL_BLE
+#else
+#define LOG_MODULE_LEVEL LOG_LEVEL_APP
+#endif
+
+// Runtime mask of enabled levels per module, read by every call site. It
+// starts as LOG_MASK_ALL; levels compiled out stay off whatever it holds.
+extern volatile uint8_t logMask[LOG_MOD_COUNT];
+
+void    logSetMask(uint32_t module, uint8_t mask);
+uint8_t logGetMask(uint32_t module);
 
+#define LOG_IF(level, ...) \
+  do { if (logMask[LOG_MODULE] & LOG_BIT(level)) { __VA_ARGS__; } } while (0)
+
+// Rate limiting for error paths that can repeat at the event rate, such as a
+// sensor that stopped answering. Each _LIMITED call site has a token bucket:
+// LOG_LIMIT_BURST messages pass back to back, then one per
+// LOG_LIMIT_PERIOD_MS. The repeats dropped in between are reported as one
+// "suppressed N repeats" line ahead of the next message that passes. Only the
+// failing path pays for the bucket.
+#define LOG_LIMIT_BURST     3
+#define LOG_LIMIT_PERIOD_MS 1000
+
+typedef struct {
+  uint32_t stamp;      /* Time the bucket was last refilled, ms */
+  uint32_t tokens;     /* Messages that may pass now */
+  uint32_t suppressed; /* Messages dropped since the last one passed */
+} log_limit_t;
+
+#define LOG_LIMIT_INIT { 0, LOG_LIMIT_BURST, 0 }
+
+bool logLimitTake(log_limit_t *limit, uint32_t *suppressed);
+
+#define LOG_LIMITED(lvl, level, message, ...)                                   \
+  do {                                                                          \
+    static log_limit_t logLimit = LOG_LIMIT_INIT;                               \
+    uint32_t logRepeats;                                                        \
+    if ((logMask[LOG_MODULE] & LOG_BIT(lvl)) &&                                 \
+        logLimitTake(&logLimit, &logRepeats)) {                                 \
+        if (logRepeats) {                                                       \
+            LOG_DO("suppressed %lu repeats\n\r", level, (unsigned long)logRepeats); \
+        }                                                                       \
+        LOG_DO(message, level, ##__VA_ARGS__);                                  \
+    }                                                                           \
+  } while (0)
 
 
 // File by file logging control
 #if INCLUDE_LOG_DEBUG
 
-#define LOG_DO(message,level, ...) \
+#define LOG_DO_NOW(message,level, ...) \
   app_log( "%5"PRIu32":%s:%s: " message "\n", loggerGetTimestamp(), level, __func__, ##__VA_ARGS__ )
+
+#if LOG_DEFERRED
+#define LOG_DO(message,level, ...)                                              \
+  do {                                                                          \
+    static const log_msg_t logMsg = { level, __func__, message };               \
+    logDeferred(&logMsg, LOG_NARGS(__VA_ARGS__)                                 \
+                LOG_CAT(LOG_ARGS_, LOG_NARGS(__VA_ARGS__))(__VA_ARGS__));       \
+  } while (0)
+#else
+#define LOG_DO(message,level, ...) LOG_DO_NOW(message, level, ##__VA_ARGS__)
+#endif
+
 uint32_t loggerGetTimestamp (void);
 void     printSLErrorString (sl_status_t status);
 
 #else
 
+#undef  LOG_MODULE_LEVEL
+#define LOG_MODULE_LEVEL LOG_LEVEL_OFF
+
+#endif // #else
+
+
 /*
- * Remove all logging related code where logging is not enabled
+ * Remove the logging code of levels that are not compiled in, with their
+ * format strings and arguments. Arguments must not have side effects.
  */
-//#define LOG_DO(message,level, ...)
-static inline void LOG_DO() {}
+#define LOG_NOP(...) do { } while (0)
 
-#endif // #else
+#ifndef LOG_ERROR
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(message,...) \
+	LOG_IF(LOG_LEVEL_ERROR, LOG_DO(message,"Error", ##__VA_ARGS__))
+// Written out before the call returns, for arguments that do not outlive it.
+// The VCOM is flushed too, so the message has left the board before a reset.
+#define LOG_ERROR_NOW(message,...) \
+	LOG_IF(LOG_LEVEL_ERROR, LOG_DO_NOW(message,"Error", ##__VA_ARGS__); vcomFlush())
+// Rate limited per call site
+#define LOG_ERROR_LIMITED(message,...) \
+	LOG_LIMITED(LOG_LEVEL_ERROR, "Error", message, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(message,...)     LOG_NOP(__VA_ARGS__)
+#define LOG_ERROR_NOW(message,...) LOG_NOP(__VA_ARGS__)
+#define LOG_ERROR_LIMITED(message,...) LOG_NOP(__VA_ARGS__)
+#endif
+#endif
+
+#ifndef LOG_WARN
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(message,...) \
+	LOG_IF(LOG_LEVEL_WARN, LOG_DO(message,"Warn ", ##__VA_ARGS__))
+#define LOG_WARN_NOW(message,...) \
+	LOG_IF(LOG_LEVEL_WARN, LOG_DO_NOW(message,"Warn ", ##__VA_ARGS__))
+// Rate limited per call site
+#define LOG_WARN_LIMITED(message,...) \
+	LOG_LIMITED(LOG_LEVEL_WARN, "Warn ", message, ##__VA_ARGS__)
+#else
+#define LOG_WARN(message,...)     LOG_NOP(__VA_ARGS__)
+#define LOG_WARN_NOW(message,...) LOG_NOP(__VA_ARGS__)
+#define LOG_WARN_LIMITED(message,...) LOG_NOP(__VA_ARGS__)
+#endif
+#endif
+
+#ifndef LOG_INFO
+#if LOG_MODULE_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(message,...) \
+	LOG_IF(LOG_LEVEL_INFO, LOG_DO(message,"Info ", ##__VA_ARGS__))
+#define LOG_INFO_NOW(message,...) \
+	LOG_IF(LOG_LEVEL_INFO, LOG_DO_NOW(message,"Info ", ##__VA_ARGS__))
+#else
+#define LOG_INFO(message,...)     LOG_NOP(__VA_ARGS__)
+#define LOG_INFO_NOW(message,...) LOG_NOP(__VA_ARGS__)
+#endif
+#endif
 
 
 #endif /* SRC_LOG_H_ */
@@ -0,0 +1,169 @@
+/*
+* File Name: occupancy.c
+* File Description: This file contains the Grid-EYE background model and the
+* occupancy detection. It is plain C with no heap or hardware access, so it
+* also builds on a host.
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#include <string.h>
+#include "src/occupancy.h"
+
+#define PIXEL_BIT(p) ((uint64_t)1 << (p))
+
+/*
+ * Function Name: occupancy_reset
+ *
+ * Parameters:
+ * occupancy_model_t *model Background model
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function clears the background model. The next
+ * OCC_LEARN_FRAMES frames are learnt as background.
+ *
+ */
+void occupancy_reset(occupancy_model_t *model)
+{
+  memset(model, 0, sizeof(*model));
+}
+
+/*
+ * Function Name: occupancy_label
+ *
+ * Parameters:
+ * const int16_t *frame 64 pixel temperatures in Q8.8 degC
+ * occupancy_result_t *result fg_mask in, blobs and count out
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function labels 8-connected foreground blobs with a flood fill
+ * on a fixed stack. Every pixel is pushed at most once, so 64 entries are
+ * always enough.
+ *
+ */
+static void occupancy_label(const int16_t *frame, occupancy_result_t *result)
+{
+  uint8_t stack[GRID_EYE_PIXELS];
+  uint64_t remaining = result->fg_mask;
+
+  result->count = 0;
+
+  while (remaining) {
+      uint8_t seed = (uint8_t)__builtin_ctzll(remaining);
+      uint8_t sp = 0;
+      uint32_t n = 0, sum_x = 0, sum_y = 0;
+      int16_t peak = INT16_MIN;
+
+      remaining &= ~PIXEL_BIT(seed);
+      stack[sp++] = seed;
+
+      while (sp) {
+          uint8_t p = stack[--sp];
+          int8_t row = p / OCC_GRID_SIZE;
+          int8_t col = p % OCC_GRID_SIZE;
+
+          n++;
+          sum_x += col;
+          sum_y += row;
+          if (frame[p] > peak) {
+              peak = frame[p];
+          }
+
+          for (int8_t dy = -1; dy <= 1; dy++) {
+              for (int8_t dx = -1; dx <= 1; dx++) {
+                  int8_t r = row + dy, c = col + dx;
+
+                  if (r < 0 || r >= OCC_GRID_SIZE || c < 0 || c >= OCC_GRID_SIZE) {
+                      continue;
+                  }
+
+                  uint8_t q = (uint8_t)(r * OCC_GRID_SIZE + c);
+                  if (remaining & PIXEL_BIT(q)) {
+                      remaining &= ~PIXEL_BIT(q);
+                      stack[sp++] = q;
+                  }
+              }
+          }
+      }
+
+      if (n >= OCC_MIN_BLOB_SIZE && result->count < OCC_MAX_BLOBS) {
+          occupancy_blob_t *blob = &result->blobs[result->count++];
+
+          blob->pixels = (uint8_t)n;
+          blob->x = (uint16_t)((sum_x * 256 + n / 2) / n);
+          blob->y = (uint16_t)((sum_y * 256 + n / 2) / n);
+          blob->peak = peak;
+      }
+  }
+}
+
+/*
+ * Function Name: occupancy_update
+ *
+ * Parameters:
+ * occupancy_model_t *model Background model
+ * const int16_t *frame 64 pixel temperatures in Q8.8 degC
+ * occupancy_result_t *result Foreground, blob count and centroids
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function classifies each pixel against its running mean and
+ * variance, labels 8-connected foreground blobs and then updates the model
+ * with the background pixels only. Pixels cooler than the model are
+ * background, so a scene learnt with someone in it recovers. It uses a fixed
+ * stack and no heap; every pixel is visited a bounded number of times, so
+ * the run time is the same for every frame.
+ *
+ */
+void occupancy_update(occupancy_model_t *model, const int16_t *frame, occupancy_result_t *result)
+{
+  bool learning = model->frames < OCC_LEARN_FRAMES;
+
+  result->fg_mask = 0;
+  result->fg_pixels = 0;
+
+  for (uint8_t p = 0; p < GRID_EYE_PIXELS; p++) {
+      if (model->frames == 0) {
+          model->mean[p] = (int32_t)frame[p] << 8; /* Seed with the first frame */
+          model->var[p] = 0;
+      }
+
+      int32_t d = frame[p] - (model->mean[p] >> 8); /* Q8.8 */
+      uint32_t ad = (uint32_t)((d < 0) ? -d : d);
+
+      if (ad > 0xFFFF) {
+          ad = 0xFFFF; /* Keeps the square within 32 bits */
+      }
+
+      uint32_t ad2 = ad * ad; /* Q16.16 */
+
+      /* Compare d^2 / K^2 with the variance instead of taking a square root.
+       * Only pixels warmer than the background are people; a cooler pixel is
+       * learnt, so an occupant learnt as background fades once they leave */
+      if (!learning && d > OCC_MIN_DELTA && ad2 / (OCC_K_SIGMA * OCC_K_SIGMA) > model->var[p]) {
+          result->fg_mask |= PIXEL_BIT(p);
+          result->fg_pixels++;
+          continue; /* Foreground does not leak into the background */
+      }
+
+      model->mean[p] += (((int32_t)frame[p] << 8) - model->mean[p]) >> OCC_ALPHA_SHIFT;
+
+      if (ad2 >= model->var[p]) {
+          model->var[p] += (ad2 - model->var[p]) >> OCC_ALPHA_SHIFT;
+      }
+      else {
+          model->var[p] -= (model->var[p] - ad2) >> OCC_ALPHA_SHIFT;
+      }
+  }
+
+  if (model->frames < UINT16_MAX) {
+      model->frames++;
+  }
+
+  occupancy_label(frame, result);
+}
@@ -0,0 +1,83 @@
+/*
+* File Name: occupancy.h
+* File Description: This file contains the declarations for the Grid-EYE
+* background model and occupancy detection in occupancy.c
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#ifndef SRC_OCCUPANCY_H_
+#define SRC_OCCUPANCY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "src/grid_eye_frame.h"
+
+#define OCC_GRID_SIZE     8   /* 8x8 pixel grid */
+#define OCC_MAX_BLOBS     8   /* Blobs reported per frame */
+#define OCC_MIN_BLOB_SIZE 2   /* Smaller blobs are treated as noise */
+#define OCC_LEARN_FRAMES  16  /* Frames that update every pixel after a reset */
+#define OCC_ALPHA_SHIFT   4   /* Background EMA weight 1/16 */
+#define OCC_K_SIGMA       3   /* Foreground when x - mean > K * sigma ... */
+#define OCC_MIN_DELTA     (2 * 256) /* ... and more than 2 degC warmer, Q8.8 */
+
+/* Background model, one mean and variance per pixel */
+typedef struct {
+  int32_t mean[GRID_EYE_PIXELS];  /* Q8.16 degC */
+  uint32_t var[GRID_EYE_PIXELS];  /* Q16.16 degC^2 */
+  uint16_t frames;                /* Frames seen since the reset */
+} occupancy_model_t;
+
+/* Connected blob of foreground pixels */
+typedef struct {
+  uint8_t pixels;  /* Number of pixels in the blob */
+  uint16_t x;      /* Centroid column in Q8.8 pixels */
+  uint16_t y;      /* Centroid row in Q8.8 pixels */
+  int16_t peak;    /* Hottest pixel in Q8.8 degC */
+} occupancy_blob_t;
+
+/* Result for one frame */
+typedef struct {
+  uint8_t count;      /* Blobs found, the occupancy */
+  uint8_t fg_pixels;  /* Foreground pixels including noise */
+  uint64_t fg_mask;   /* Bit n set for foreground pixel n */
+  occupancy_blob_t blobs[OCC_MAX_BLOBS];
+} occupancy_result_t;
+
+/*
+ * Function Name: occupancy_reset
+ *
+ * Parameters:
+ * occupancy_model_t *model Background model
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function clears the background model. The next
+ * OCC_LEARN_FRAMES frames are learnt as background.
+ *
+ */
+void occupancy_reset(occupancy_model_t *model);
+
+/*
+ * Function Name: occupancy_update
+ *
+ * Parameters:
+ * occupancy_model_t *model Background model
+ * const int16_t *frame 64 pixel temperatures in Q8.8 degC
+ * occupancy_result_t *result Foreground, blob count and centroids
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function classifies each pixel against its running mean and
+ * variance, labels 8-connected foreground blobs and then updates the model
+ * with the background pixels only. Pixels cooler than the model are
+ * background, so a scene learnt with someone in it recovers. It uses a fixed
+ * stack and no heap; every pixel is visited a bounded number of times, so
+ * the run time is the same for every frame.
+ *
+ */
+void occupancy_update(occupancy_model_t *model, const int16_t *frame, occupancy_result_t *result);
+
+#endif /* SRC_OCCUPANCY_H_ */
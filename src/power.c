@@ -0,0 +1,321 @@
+/*
+* File Name: power.c
+* File Description: This file contains the energy mode governor. Drivers
+* require and release a reason around each operation that keeps the device
+* awake; the governor holds exactly one power manager requirement, for the
+* shallowest mode any operation in flight needs, so the device always sleeps
+* as deep as the current workload allows.
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#include <stdbool.h>
+#include "em_core.h"
+#include "app.h"
+#include "src/power.h"
+#include "src/timers.h"
+
+/* The power manager cannot hold EM0, app_is_ok_to_sleep keeps the core awake */
+#if LOWEST_ENERGY_MODE < 1
+#define POWER_BUILD_EM SL_POWER_MANAGER_EM1
+#elif LOWEST_ENERGY_MODE > 3
+#define POWER_BUILD_EM SL_POWER_MANAGER_EM3
+#else
+#define POWER_BUILD_EM ((sl_power_manager_em_t)LOWEST_ENERGY_MODE)
+#endif
+
+/* Deepest energy mode each reason allows */
+static const sl_power_manager_em_t reasonEm[powerNumberOfReasons] = {
+  [powerReasonBuild]        = POWER_BUILD_EM,
+  [powerReasonI2C]          = SL_POWER_MANAGER_EM1, /* I2C0 runs from HFPERCLK */
+  [powerReasonBleConnected] = SL_POWER_MANAGER_EM2, /* Radio timing runs from the LFXO */
+  [powerReasonVcomTx]       = SL_POWER_MANAGER_EM1, /* USART0 runs from HFPERCLK */
+  [powerReasonLcd]          = SL_POWER_MANAGER_EM1, /* USART1 runs from HFPERCLK */
+};
+
+static uint16_t inFlight[powerNumberOfReasons]; /* Operations in flight per reason */
+
+static sl_power_manager_em_t held = SL_POWER_MANAGER_EM3; /* EM3: no requirement held */
+
+static power_stats_t stats;
+
+static sl_power_manager_em_transition_event_handle_t transitionHandle;
+
+static bool (*volatile waitDone)(void); /* Wake condition of the blocking wait, NULL if none */
+
+static void power_on_transition(sl_power_manager_em_t from, sl_power_manager_em_t to);
+
+static const sl_power_manager_em_transition_event_info_t transitionInfo = {
+  .event_mask = SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM0 |
+                SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM1 |
+                SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM2 |
+                SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM3,
+  .on_event = power_on_transition,
+};
+
+/*
+ * Function Name: power_on_transition
+ *
+ * Parameters:
+ * sl_power_manager_em_t from Energy mode being left
+ * sl_power_manager_em_t to Energy mode being entered
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function is called by the power manager around every sleep. It
+ * counts the transition and charges the time since the previous one to the
+ * mode being left.
+ *
+ */
+static void power_on_transition(sl_power_manager_em_t from, sl_power_manager_em_t to)
+{
+  uint64_t now = timerNowUs();
+
+  if (from < POWER_EM_COUNT) {
+      stats.residency_us[from] += now - stats.last_transition_us;
+  }
+  if (to < POWER_EM_COUNT) {
+      stats.entries[to]++;
+  }
+
+  stats.last_transition_us = now;
+  stats.current_em = to;
+}
+
+/*
+ * Function Name: power_update
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function moves the held power manager requirement to the
+ * shallowest mode required by the reasons in flight. The new requirement is
+ * added before the old one is removed, so the device never sleeps deeper than
+ * allowed in between. Called with interrupts disabled.
+ *
+ */
+static void power_update(void)
+{
+  sl_power_manager_em_t deepest = SL_POWER_MANAGER_EM3;
+
+  for (int r = 0; r < powerNumberOfReasons; r++) {
+      if (inFlight[r] && reasonEm[r] < deepest) {
+          deepest = reasonEm[r];
+      }
+  }
+
+  if (deepest == held) {
+      return;
+  }
+
+  if (deepest < SL_POWER_MANAGER_EM3) {
+      sl_power_manager_add_em_requirement(deepest);
+  }
+  if (held < SL_POWER_MANAGER_EM3) {
+      sl_power_manager_remove_em_requirement(held);
+  }
+
+  held = deepest;
+}
+
+/*
+ * Function Name: powerInit
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function subscribes to energy mode transitions and applies the
+ * LOWEST_ENERGY_MODE floor of the build. It must be called after
+ * low_energy_timerInit, before any reason is required.
+ *
+ */
+void powerInit(void)
+{
+  stats.last_transition_us = timerNowUs();
+  stats.current_em = SL_POWER_MANAGER_EM0;
+  sl_power_manager_subscribe_em_transition_event(&transitionHandle, &transitionInfo);
+
+  if (POWER_BUILD_EM < SL_POWER_MANAGER_EM3) {
+      powerRequire(powerReasonBuild);
+  }
+}
+
+/*
+ * Function Name: powerRequire
+ *
+ * Parameters:
+ * power_reason_t reason Operation that starts
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function counts one more operation of the reason in flight and
+ * raises the power manager requirement if the reason needs a shallower mode
+ * than the current workload. It may be called from interrupt context.
+ *
+ */
+void powerRequire(power_reason_t reason)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if (reason >= powerNumberOfReasons) {
+      return;
+  }
+
+  CORE_ENTER_CRITICAL();
+  stats.requires[reason]++;
+  if (inFlight[reason]++ == 0) {
+      power_update();
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/*
+ * Function Name: powerRelease
+ *
+ * Parameters:
+ * power_reason_t reason Operation that ended
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function ends one operation of the reason and lets the device
+ * sleep as deep as the remaining operations allow. It may be called from
+ * interrupt context.
+ *
+ */
+void powerRelease(power_reason_t reason)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  if (reason >= powerNumberOfReasons) {
+      return;
+  }
+
+  CORE_ENTER_CRITICAL();
+  if (inFlight[reason] && --inFlight[reason] == 0) {
+      power_update();
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/*
+ * Function Name: powerDeepestAllowed
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * sl_power_manager_em_t Deepest energy mode the current workload allows
+ *
+ * Brief: This function returns the mode the governor currently lets the
+ * power manager sleep in.
+ *
+ */
+sl_power_manager_em_t powerDeepestAllowed(void)
+{
+  return held;
+}
+
+/*
+ * Function Name: powerGetStats
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * const power_stats_t* Energy mode statistics
+ *
+ * Brief: This function returns the transition counts and residency per
+ * energy mode.
+ *
+ */
+const power_stats_t *powerGetStats(void)
+{
+  return &stats;
+}
+
+/*
+ * Function Name: powerSleepUntil
+ *
+ * Parameters:
+ * bool (*done)(void) Wake condition, made true by an interrupt
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function blocks in the deepest allowed energy mode until done
+ * returns true. Scheduler events posted meanwhile are served after it
+ * returns. In interrupt context it polls done instead of sleeping.
+ *
+ */
+/*
+ * The interrupt that makes done true can come between the check in the loop
+ * and the WFI. sl_power_manager_sleep asks app_is_ok_to_sleep with interrupts
+ * disabled, and that checks done again through powerWaitDone, so the core
+ * does not sleep on a wait that has already ended. A wait nested in another,
+ * such as a flush of VCOM from a log made while waiting, restores the outer
+ * condition when it ends.
+ */
+void powerSleepUntil(bool (*done)(void))
+{
+  bool (*outer)(void) = waitDone;
+
+  /* The power manager sleeps from thread mode only */
+  if (CORE_InIrqContext()) {
+      while (!done()) {
+      }
+      return;
+  }
+
+  waitDone = done;
+  while (!done()) {
+      sl_power_manager_sleep();
+  }
+  waitDone = outer;
+}
+
+/*
+ * Function Name: powerWaiting
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * bool true while powerSleepUntil is blocking
+ *
+ * Brief: This function tells app_is_ok_to_sleep that the core sleeps for a
+ * blocking wait rather than for the scheduler.
+ *
+ */
+bool powerWaiting(void)
+{
+  return waitDone != NULL;
+}
+
+/*
+ * Function Name: powerWaitDone
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * bool true if the wake condition of the blocking wait holds
+ *
+ * Brief: This function evaluates the wake condition of powerSleepUntil for
+ * app_is_ok_to_sleep.
+ *
+ */
+bool powerWaitDone(void)
+{
+  bool (*done)(void) = waitDone;
+
+  return done != NULL && done();
+}
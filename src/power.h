@@ -0,0 +1,163 @@
+/*
+* File Name: power.h
+* File Description: This file contains the declarations for the energy mode
+* governor in power.c
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#ifndef SRC_POWER_H_
+#define SRC_POWER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sl_power_manager.h"
+
+/* Why the device has to stay awake; each reason maps to the deepest energy
+ * mode it allows in the table in power.c. Work that is not listed, such as
+ * waiting on a sensor conversion, allows EM3. */
+typedef enum {
+  powerReasonBuild = 0,    /* LOWEST_ENERGY_MODE in app.h is above EM3 */
+  powerReasonI2C,          /* I2C0 transfer in flight */
+  powerReasonBleConnected, /* BLE connection open */
+  powerReasonVcomTx,       /* LDMA writing out the VCOM TX ring */
+  powerReasonLcd,          /* LDMA refreshing the memory LCD */
+  powerNumberOfReasons
+} power_reason_t;
+
+#define POWER_EM_COUNT (SL_POWER_MANAGER_EM3 + 1) /* EM0..EM3 */
+
+/* Energy mode statistics from the power manager transition events */
+typedef struct {
+  uint32_t entries[POWER_EM_COUNT];         /* Transitions into each EM */
+  uint64_t residency_us[POWER_EM_COUNT];    /* Time spent in each EM, up to the last transition */
+  uint32_t requires[powerNumberOfReasons];  /* powerRequire calls per reason */
+  uint64_t last_transition_us;              /* timerNowUs of the last transition */
+  sl_power_manager_em_t current_em;         /* EM entered by the last transition */
+} power_stats_t;
+
+/*
+ * Function Name: powerInit
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function subscribes to energy mode transitions and applies the
+ * LOWEST_ENERGY_MODE floor of the build. It must be called after
+ * low_energy_timerInit, before any reason is required.
+ *
+ */
+void powerInit(void);
+
+/*
+ * Function Name: powerRequire
+ *
+ * Parameters:
+ * power_reason_t reason Operation that starts
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function counts one more operation of the reason in flight and
+ * raises the power manager requirement if the reason needs a shallower mode
+ * than the current workload. It may be called from interrupt context.
+ *
+ */
+void powerRequire(power_reason_t reason);
+
+/*
+ * Function Name: powerRelease
+ *
+ * Parameters:
+ * power_reason_t reason Operation that ended
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function ends one operation of the reason and lets the device
+ * sleep as deep as the remaining operations allow. It may be called from
+ * interrupt context.
+ *
+ */
+void powerRelease(power_reason_t reason);
+
+/*
+ * Function Name: powerDeepestAllowed
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * sl_power_manager_em_t Deepest energy mode the current workload allows
+ *
+ * Brief: This function returns the mode the governor currently lets the
+ * power manager sleep in.
+ *
+ */
+sl_power_manager_em_t powerDeepestAllowed(void);
+
+/*
+ * Function Name: powerGetStats
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * const power_stats_t* Energy mode statistics
+ *
+ * Brief: This function returns the transition counts and residency per
+ * energy mode.
+ *
+ */
+const power_stats_t *powerGetStats(void);
+
+/*
+ * Function Name: powerSleepUntil
+ *
+ * Parameters:
+ * bool (*done)(void) Wake condition, made true by an interrupt
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function blocks in the deepest allowed energy mode until done
+ * returns true. Scheduler events posted meanwhile are served after it
+ * returns. In interrupt context it polls done instead of sleeping.
+ *
+ */
+void powerSleepUntil(bool (*done)(void));
+
+/*
+ * Function Name: powerWaiting
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * bool true while powerSleepUntil is blocking
+ *
+ * Brief: This function tells app_is_ok_to_sleep that the core sleeps for a
+ * blocking wait rather than for the scheduler.
+ *
+ */
+bool powerWaiting(void);
+
+/*
+ * Function Name: powerWaitDone
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * bool true if the wake condition of the blocking wait holds
+ *
+ * Brief: This function evaluates the wake condition of powerSleepUntil for
+ * app_is_ok_to_sleep.
+ *
+ */
+bool powerWaitDone(void);
+
+#endif /* SRC_POWER_H_ */
@@ -0,0 +1,79 @@
+/*
+* File Name: pt.h
+* File Description: This file contains stackless protothreads. A protothread
+* is a function that returns whenever it has to wait and continues where it
+* left off the next time it is called, so multi-step driver sequences can be
+* written top to bottom without an RTOS and on the one main stack.
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+* Reference: A. Dunkels, Protothreads, local continuations based on switch
+*
+* Restrictions that come with the switch based local continuations:
+* - Local variables are not kept across a wait, use static variables.
+* - A protothread must not contain a switch statement of its own.
+* Resume points are numbered with __COUNTER__ rather than __LINE__, so one
+* macro may contain several waits.
+**/
+
+#ifndef SRC_PT_H_
+#define SRC_PT_H_
+
+#include <stdint.h>
+
+/* Protothread state, the line to continue from */
+typedef struct {
+  uint16_t lc;
+} pt_t;
+
+/* Return values of a protothread */
+#define PT_WAITING 0 /* Blocked on a condition */
+#define PT_YIELDED 1 /* Gave up the CPU, ready to continue */
+#define PT_EXITED  2 /* Left with PT_EXIT */
+#define PT_ENDED   3 /* Ran to PT_END */
+
+#define PT_INIT(pt) ((pt)->lc = 0)
+
+/* Resume points are case labels reached by falling through */
+#define PT_FALLTHROUGH __attribute__((fallthrough))
+
+#define PT_BEGIN(pt) { char PT_YIELD_FLAG = 1; (void)PT_YIELD_FLAG; switch ((pt)->lc) { case 0:
+
+#define PT_END(pt) } PT_YIELD_FLAG = 0; PT_INIT(pt); return PT_ENDED; }
+
+/* Block until cond is true, cond is checked again on every call */
+#define PT_WAIT_UNTIL(pt, cond) PT_WAIT_UNTIL_AT((pt), (cond), __COUNTER__ + 1)
+
+#define PT_WAIT_UNTIL_AT(pt, cond, n)            \
+  do {                                           \
+      (pt)->lc = (n); PT_FALLTHROUGH; case (n):  \
+      if (!(cond))                               \
+        return PT_WAITING;                       \
+  } while (0)
+
+#define PT_WAIT_WHILE(pt, cond) PT_WAIT_UNTIL((pt), !(cond))
+
+/* Return once, continue on the next call */
+#define PT_YIELD(pt) PT_YIELD_AT((pt), __COUNTER__ + 1)
+
+#define PT_YIELD_AT(pt, n)                       \
+  do {                                           \
+      PT_YIELD_FLAG = 0;                         \
+      (pt)->lc = (n); PT_FALLTHROUGH; case (n):  \
+      if (PT_YIELD_FLAG == 0)                    \
+        return PT_YIELDED;                       \
+  } while (0)
+
+#define PT_EXIT(pt)     do { PT_INIT(pt); return PT_EXITED; } while (0)
+#define PT_RESTART(pt)  do { PT_INIT(pt); return PT_WAITING; } while (0)
+
+/* True while a protothread call has not exited or ended */
+#define PT_SCHEDULE(f) ((f) < PT_EXITED)
+
+/* Run a child protothread to completion */
+#define PT_SPAWN(pt, child, thread)              \
+  do {                                           \
+      PT_INIT(child);                            \
+      PT_WAIT_WHILE((pt), PT_SCHEDULE(thread));  \
+  } while (0)
+
+#endif /* SRC_PT_H_ */
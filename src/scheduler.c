@@ -1,6 +1,9 @@
 /*
 * File Name: scheduler.c
-* File Description: This file contains the scheduler related functions
+* File Description: This file contains the scheduler related functions.
+* Events are kept in one queue per priority level. Interrupts post events
+* with exclusive load/store (LDREX/STREX) instead of critical sections, and
+* the main loop removes them without locking.
 * File Author: Gautama Gandhi
 * Tools used: Simplicity Studio IDE
 **/
@@ -10,9 +13,163 @@
 #include "em_chip.h"
 #include "app.h"
 #include "src/scheduler.h"
+#include "src/timers.h"
 #include <stdint.h>
 
-uint32_t currentEvent = evtNoEvent; /* Global variable for currentEvent*/
+#define INCLUDE_LOG_DEBUG 1
+#define LOG_MODULE LOG_MOD_SCHEDULER
+#include "src/log.h"
+
+#define SCHED_QUEUE_MASK (SCHED_QUEUE_LEN - 1)
+
+#if (SCHED_QUEUE_LEN & SCHED_QUEUE_MASK) != 0
+#error "SCHED_QUEUE_LEN must be a power of 2"
+#endif
+
+/*
+ * One queue per priority. Producers reserve a slot by advancing head with
+ * LDREX/STREX, so nested interrupts posting to the same queue each get their
+ * own slot, then fill it and mark it ready. Only the main loop reads slots
+ * and advances tail.
+ */
+typedef struct {
+  sched_event_t slot[SCHED_QUEUE_LEN];
+  volatile uint8_t ready[SCHED_QUEUE_LEN];
+  volatile uint32_t head; /* Next slot to reserve */
+  volatile uint32_t tail; /* Next slot to read */
+} sched_queue_t;
+
+/* Priority and coalescing of each event */
+typedef struct {
+  sched_priority_t priority;
+  bool coalesce; /* Only one instance is queued, repeats carry no new data */
+} sched_event_info_t;
+
+static const sched_event_info_t eventInfo[evtNumberOfEvents] = {
+  [evtLETIMER0_UF]        = { schedPriorityLow,    true  },
+  [evtI2C0_Transfer_Done] = { schedPriorityHigh,   true  }, /* Waiters check their request status */
+  [evtTask_Timer]         = { schedPriorityNormal, false }, /* One per sleeping task */
+  [evtGridEye_Int]        = { schedPriorityNormal, true  },
+};
+
+/* evtI2C0_Transfer_Done is the only high priority event and it coalesces, so
+ * the high queue never holds more than one event and a completion is never
+ * dropped; a task waiting on the bus would not wake up again otherwise */
+static sched_queue_t queues[schedNumberOfPriorities];
+
+static volatile uint8_t queued[evtNumberOfEvents]; /* Coalescing events in a queue */
+
+static sched_stats_t stats;
+
+/*
+ * Function Name: atomic_add
+ *
+ * Parameters:
+ * volatile uint32_t *counter Counter to increment
+ * uint32_t value Amount to add
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function adds to a statistics counter that nested interrupts
+ * may update at the same time.
+ *
+ */
+static void atomic_add(volatile uint32_t *counter, uint32_t value)
+{
+  while (__STREXW(__LDREXW(counter) + value, counter)) {
+  }
+}
+
+/*
+ * Function Name: atomic_max
+ *
+ * Parameters:
+ * volatile uint32_t *counter High water mark
+ * uint32_t value New sample
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function raises a high water mark to value if it is lower.
+ *
+ */
+static void atomic_max(volatile uint32_t *counter, uint32_t value)
+{
+  uint32_t current;
+
+  do {
+      current = __LDREXW(counter);
+      if (current >= value) {
+          __CLREX();
+          return;
+      }
+  } while (__STREXW(value, counter));
+}
+
+/*
+ * Function Name: schedulerPostEvent
+ *
+ * Parameters:
+ * evt_t evt Event to queue
+ * uint32_t payload Event specific data
+ *
+ * Returns:
+ * bool false if the queue for the event's priority was full
+ *
+ * Brief: This routine queues an event on the queue of its priority. It is
+ * lock free and may be called from any interrupt or from thread mode.
+ * Events marked as coalescing are not queued twice; a repeat posted while
+ * one is still queued is counted and dropped.
+ *
+ */
+bool schedulerPostEvent(evt_t evt, uint32_t payload)
+{
+  sched_queue_t *queue;
+  uint32_t head, used, index;
+
+  if (evt <= evtNoEvent || evt >= evtNumberOfEvents) {
+      return false;
+  }
+
+  if (eventInfo[evt].coalesce) {
+      do {
+          if (__LDREXB(&queued[evt])) {
+              __CLREX();
+              atomic_add(&stats.coalesced[evt], 1);
+              return true;
+          }
+      } while (__STREXB(1, &queued[evt]));
+  }
+
+  queue = &queues[eventInfo[evt].priority];
+
+  do {
+      head = __LDREXW(&queue->head);
+      used = head - queue->tail;
+      if (used >= SCHED_QUEUE_LEN) {
+          __CLREX();
+          if (eventInfo[evt].coalesce) {
+              queued[evt] = 0;
+          }
+          atomic_add(&stats.dropped[eventInfo[evt].priority], 1);
+          LOG_WARN_LIMITED("Event %d dropped, priority %d queue is full\n\r", evt, eventInfo[evt].priority);
+          return false;
+      }
+  } while (__STREXW(head + 1, &queue->head));
+
+  index = head & SCHED_QUEUE_MASK;
+  queue->slot[index].id = evt;
+  queue->slot[index].timestamp = (uint32_t)timerNowUs();
+  queue->slot[index].payload = payload;
+  __DMB(); /* Slot contents before the ready flag */
+  queue->ready[index] = 1;
+
+  atomic_add(&stats.posted, 1);
+  atomic_max(&stats.high_water[eventInfo[evt].priority], used + 1);
+
+  return true;
+}
 
 /*
  * Function Name: schedulerSetEventUF
@@ -29,43 +186,128 @@ uint32_t currentEvent = evtNoEvent; /* Global variable for currentEvent*/
  */
 void schedulerSetEventUF(void)
 {
-  CORE_DECLARE_IRQ_STATE;
-  CORE_ENTER_CRITICAL();
-  currentEvent |= evtLETIMER0_UF; /* Set Event evtLETIMER0_UF*/
-  CORE_EXIT_CRITICAL();
+  schedulerPostEvent(evtLETIMER0_UF, 0);
 }
 
 /*
- * Function Name: getNextEvent
+ * Function Name: schedulerSetEventI2CDone
+ *
+ * Parameters:
+ * uint32_t request Address of the completed i2c_request_t
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This routine sets the scheduler event evtI2C0_Transfer_Done upon
+ * completion of an asynchronous I2C0 transfer. The event is coalesced and
+ * never dropped; completions that arrive while one is queued are delivered
+ * with it, so waiters check the status of their own request.
+ *
+ */
+void schedulerSetEventI2CDone(uint32_t request)
+{
+  schedulerPostEvent(evtI2C0_Transfer_Done, request);
+}
+
+/*
+ * Function Name: schedulerSetEventGridEyeInt
  *
  * Parameters:
  * none
  *
  * Returns:
- * uint32_t Return the next event
+ * none
+ *
+ * Brief: This routine sets the scheduler event evtGridEye_Int when the
+ * Grid-EYE INT pin is asserted.
+ *
+ */
+void schedulerSetEventGridEyeInt(void)
+{
+  schedulerPostEvent(evtGridEye_Int, 0);
+}
+
+/*
+ * Function Name: getNextEvent
  *
- * Brief: This routine returns 1 event (the next event) to main()code and
- * clears that event.
+ * Parameters:
+ * sched_event_t *event Filled in with the next event
+ *
+ * Returns:
+ * bool false if no event is queued
+ *
+ * Brief: This routine removes the oldest event of the highest priority
+ * queue that is not empty. It must only be called from thread mode and takes
+ * no critical section.
  *
  */
-uint32_t getNextEvent()
+bool getNextEvent(sched_event_t *event)
 {
-  uint32_t theEvent, tempEvent, clearEvent;
+  for (int p = 0; p < schedNumberOfPriorities; p++) {
+      sched_queue_t *queue = &queues[p];
+      uint32_t tail = queue->tail;
+      uint32_t index = tail & SCHED_QUEUE_MASK;
+
+      /* A reserved slot that is not ready yet belongs to a producer that
+       * was interrupted, it is picked up on a later call */
+      if (tail == queue->head || !queue->ready[index]) {
+          continue;
+      }
 
-  if ((currentEvent & (currentEvent - 1)) == 0) { /* Checking if only 1 event is set */
-      theEvent = currentEvent; /* Assigning the event and equating clearEvent*/
-      clearEvent = evtNoEvent;
+      __DMB(); /* Ready flag before the slot contents */
+      *event = queue->slot[index];
+      queue->ready[index] = 0;
+
+      /* Allow the next instance to be queued before this one is handled */
+      if (eventInfo[event->id].coalesce) {
+          queued[event->id] = 0;
+      }
+
+      __DMB(); /* Slot read before it is released to the producers */
+      queue->tail = tail + 1;
+
+      return true;
   }
-  else { /* Check for multiple events; Event priority is assigned from LSB to MSB with LSB of uint32_t having highest priority*/
-      tempEvent = currentEvent & (currentEvent - 1); /* Clearing the event with highest priority */
-      theEvent = currentEvent ^ tempEvent; /* Setting the nextEvent to be bitwise XOR between tempEvent and currentEvent*/
-      clearEvent = tempEvent; /* clearEvent set to the remaining events */
+
+  return false;
+}
+
+/*
+ * Function Name: schedulerEventsPending
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * bool true if any event is queued
+ *
+ * Brief: This routine is used to keep the MCU awake while events are queued.
+ *
+ */
+bool schedulerEventsPending(void)
+{
+  for (int p = 0; p < schedNumberOfPriorities; p++) {
+      if (queues[p].tail != queues[p].head) {
+          return true;
+      }
   }
 
-  CORE_DECLARE_IRQ_STATE;
-  CORE_ENTER_CRITICAL();
-  currentEvent = clearEvent;
-  CORE_EXIT_CRITICAL();
+  return false;
+}
 
-  return (theEvent);
+/*
+ * Function Name: schedulerGetStats
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * const sched_stats_t* Queue statistics
+ *
+ * Brief: This routine returns the dropped and coalesced event counters.
+ *
+ */
+const sched_stats_t *schedulerGetStats(void)
+{
+  return &stats;
 }
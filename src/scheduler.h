@@ -8,15 +8,63 @@
 #ifndef SRC_SCHEDULER_H_
 #define SRC_SCHEDULER_H_
 
-/*Macro to set event number whenever a new event is added; each event is a multiple of 2 starting from (2^0) = 1*/
-#define event_number_set(x) (1<<((x)-1))
+#include <stdint.h>
+#include <stdbool.h>
 
-/* Enum for events; each new event is added with event_number_set(event number)*/
+/* Enum for events; each new event is added before evtNumberOfEvents and given
+ * a priority and coalescing flag in the table in scheduler.c */
 typedef enum {
   evtNoEvent = 0,
-  evtLETIMER0_UF = event_number_set(1),
+  evtLETIMER0_UF,
+  evtI2C0_Transfer_Done,
+  evtTask_Timer,        /* Payload: the task_t whose TASK_SLEEP_MS expired */
+  evtGridEye_Int,
+  evtNumberOfEvents
 } evt_t;
 
+/* Priority levels, each with its own queue; lower values are drained first */
+typedef enum {
+  schedPriorityHigh = 0,
+  schedPriorityNormal,
+  schedPriorityLow,
+  schedNumberOfPriorities
+} sched_priority_t;
+
+#define SCHED_QUEUE_LEN 8 /* Events per priority queue, a power of 2 */
+
+/* One queued event */
+typedef struct {
+  evt_t    id;
+  uint32_t timestamp; /* Low 32 bits of timerNowUs() when the event was posted */
+  uint32_t payload;   /* Event specific data */
+} sched_event_t;
+
+/* Queue statistics used to size the queues under load */
+typedef struct {
+  uint32_t posted;                             /* Events queued */
+  uint32_t dropped[schedNumberOfPriorities];   /* Events lost to a full queue */
+  uint32_t coalesced[evtNumberOfEvents];       /* Events merged into one already queued */
+  uint32_t high_water[schedNumberOfPriorities]; /* Most events queued at once */
+} sched_stats_t;
+
+/*
+ * Function Name: schedulerPostEvent
+ *
+ * Parameters:
+ * evt_t evt Event to queue
+ * uint32_t payload Event specific data
+ *
+ * Returns:
+ * bool false if the queue for the event's priority was full
+ *
+ * Brief: This routine queues an event on the queue of its priority. It is
+ * lock free and may be called from any interrupt or from thread mode.
+ * Events marked as coalescing are not queued twice; a repeat posted while
+ * one is still queued is counted and dropped.
+ *
+ */
+bool schedulerPostEvent(evt_t evt, uint32_t payload);
+
 /*
  * Function Name: schedulerSetEventUF
  *
@@ -32,19 +80,80 @@ typedef enum {
  */
 void schedulerSetEventUF(void);
 
+/*
+ * Function Name: schedulerSetEventI2CDone
+ *
+ * Parameters:
+ * uint32_t request Address of the completed i2c_request_t
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This routine sets the scheduler event evtI2C0_Transfer_Done upon
+ * completion of an asynchronous I2C0 transfer. The event is coalesced and
+ * never dropped; completions that arrive while one is queued are delivered
+ * with it, so waiters check the status of their own request.
+ *
+ */
+void schedulerSetEventI2CDone(uint32_t request);
+
+/*
+ * Function Name: schedulerSetEventGridEyeInt
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This routine sets the scheduler event evtGridEye_Int when the
+ * Grid-EYE INT pin is asserted.
+ *
+ */
+void schedulerSetEventGridEyeInt(void);
+
 /*
  * Function Name: getNextEvent
  *
  * Parameters:
+ * sched_event_t *event Filled in with the next event
+ *
+ * Returns:
+ * bool false if no event is queued
+ *
+ * Brief: This routine removes the oldest event of the highest priority
+ * queue that is not empty. It must only be called from thread mode and takes
+ * no critical section.
+ *
+ */
+bool getNextEvent(sched_event_t *event);
+
+/*
+ * Function Name: schedulerEventsPending
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * bool true if any event is queued
+ *
+ * Brief: This routine is used to keep the MCU awake while events are queued.
+ *
+ */
+bool schedulerEventsPending(void);
+
+/*
+ * Function Name: schedulerGetStats
+ *
+ * Parameters:
  * none
  *
  * Returns:
- * uint32_t Return the next event
+ * const sched_stats_t* Queue statistics
  *
- * Brief: This routine returns 1 event (the next event) to main()code and
- * clears that event.
+ * Brief: This routine returns the dropped and coalesced event counters.
  *
  */
-uint32_t getNextEvent();
+const sched_stats_t *schedulerGetStats(void);
 
 #endif /* SRC_SCHEDULER_H_ */
@@ -0,0 +1,110 @@
+/*
+* File Name: task.c
+* File Description: This file contains the cooperative task dispatcher. Each
+* task is a protothread that waits for a scheduler event; the main loop hands
+* every event to the tasks waiting for it and sleeps when none is queued.
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#include <stddef.h>
+#include "src/task.h"
+
+#define INCLUDE_LOG_DEBUG 1
+#include "src/log.h"
+
+static task_t *tasks; /* Started tasks, in start order */
+
+/*
+ * Function Name: task_resume
+ *
+ * Parameters:
+ * task_t *task Task to run
+ * const sched_event_t *evt Event that woke it, NULL on the first run
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function runs a task until it waits again or finishes.
+ *
+ */
+static void task_resume(task_t *task, const sched_event_t *evt)
+{
+  task->evt = evt;
+
+  if (!PT_SCHEDULE(task->run(task))) {
+      task->running = false;
+      LOG_INFO("Task %s finished\n\r", task->name);
+  }
+
+  task->evt = NULL;
+}
+
+/*
+ * Function Name: taskStart
+ *
+ * Parameters:
+ * task_t *task Task storage, static
+ * task_fn_t run Task body
+ * const char *name Name used in log messages
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function registers a task and runs it up to its first wait.
+ *
+ */
+void taskStart(task_t *task, task_fn_t run, const char *name)
+{
+  task_t **link = &tasks;
+
+  PT_INIT(&task->pt);
+  task->run = run;
+  task->name = name;
+  task->evt = NULL;
+  task->wait_evt = evtNoEvent;
+  task->running = true;
+
+  while (*link && *link != task) {
+      link = &(*link)->next;
+  }
+  if (*link == NULL) {
+      task->next = NULL;
+      *link = task;
+  }
+
+  task_resume(task, NULL);
+}
+
+/*
+ * Function Name: taskDispatch
+ *
+ * Parameters:
+ * const sched_event_t *evt Event from getNextEvent
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function resumes every running task that waits for this event,
+ * in the order they were started.
+ *
+ */
+void taskDispatch(const sched_event_t *evt)
+{
+  for (task_t *task = tasks; task; task = task->next) {
+      if (!task->running) {
+          continue;
+      }
+
+      if (task->wait_evt != evtNoEvent) {
+          if (evt->id != task->wait_evt) {
+              continue;
+          }
+          if (!task->wait_any_payload && evt->payload != task->wait_payload) {
+              continue;
+          }
+      }
+
+      task_resume(task, evt);
+  }
+}
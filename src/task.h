@@ -0,0 +1,116 @@
+/*
+* File Name: task.h
+* File Description: This file contains the declarations for the cooperative
+* task dispatcher in task.c and the wait macros used inside tasks
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#ifndef SRC_TASK_H_
+#define SRC_TASK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "src/pt.h"
+#include "src/scheduler.h"
+#include "src/timers.h"
+#include "src/timer_wheel.h"
+#include "src/i2c.h"
+
+struct task;
+
+/* Task body, a protothread returning PT_WAITING .. PT_ENDED */
+typedef char (*task_fn_t)(struct task *task);
+
+/* Cooperative task, resumed by the scheduler event it waits for */
+typedef struct task {
+  pt_t pt;
+  task_fn_t run;
+  const char *name;
+  const sched_event_t *evt; /* Event being delivered, NULL once consumed */
+  evt_t wait_evt;           /* Event the task is blocked on, evtNoEvent: every event */
+  uint32_t wait_payload;
+  bool wait_any_payload;
+  bool running;
+  sw_timer_t timer;         /* Used by TASK_SLEEP_MS */
+  struct task *next;
+} task_t;
+
+/* Block until the event id is posted with the given payload */
+#define TASK_WAIT_EVENT_PAYLOAD(task, id, data)                          \
+  do {                                                                   \
+      (task)->evt = NULL;                                                \
+      (task)->wait_evt = (id);                                           \
+      (task)->wait_payload = (uint32_t)(data);                           \
+      (task)->wait_any_payload = false;                                  \
+      PT_WAIT_UNTIL(&(task)->pt, (task)->evt != NULL);                   \
+      (task)->wait_evt = evtNoEvent;                                     \
+  } while (0)
+
+/* Block until the event id is posted, whatever its payload */
+#define TASK_WAIT_EVENT(task, id)                                        \
+  do {                                                                   \
+      (task)->evt = NULL;                                                \
+      (task)->wait_evt = (id);                                           \
+      (task)->wait_any_payload = true;                                   \
+      PT_WAIT_UNTIL(&(task)->pt, (task)->evt != NULL);                   \
+      (task)->wait_evt = evtNoEvent;                                     \
+  } while (0)
+
+/* Block until a queued i2c_request_t with a NULL callback has completed.
+ * evtI2C0_Transfer_Done is coalesced, so the request status is checked on
+ * every one rather than the payload; a request already done does not wait */
+#define TASK_WAIT_I2C(task, req)                                         \
+  do {                                                                   \
+      (task)->evt = NULL;                                                \
+      (task)->wait_evt = evtI2C0_Transfer_Done;                          \
+      (task)->wait_any_payload = true;                                   \
+      PT_WAIT_UNTIL(&(task)->pt, (req)->status != i2cTransferInProgress); \
+      (task)->wait_evt = evtNoEvent;                                     \
+  } while (0)
+
+/* Sleep for ms on the timer wheel, the core sleeps unless other work is ready.
+ * If the timer cannot be started the task still yields, until the next
+ * LETIMER0 underflow, so retry loops around it do not spin */
+#define TASK_SLEEP_MS(task, ms)                                          \
+  do {                                                                   \
+      if (timerStart(&(task)->timer, (ms), 0, evtTask_Timer, (uint32_t)(task))) { \
+          TASK_WAIT_EVENT_PAYLOAD((task), evtTask_Timer, (task));        \
+      }                                                                  \
+      else {                                                             \
+          TASK_WAIT_EVENT((task), evtLETIMER0_UF);                       \
+      }                                                                  \
+  } while (0)
+
+/*
+ * Function Name: taskStart
+ *
+ * Parameters:
+ * task_t *task Task storage, static
+ * task_fn_t run Task body
+ * const char *name Name used in log messages
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function registers a task and runs it up to its first wait.
+ *
+ */
+void taskStart(task_t *task, task_fn_t run, const char *name);
+
+/*
+ * Function Name: taskDispatch
+ *
+ * Parameters:
+ * const sched_event_t *evt Event from getNextEvent
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function resumes every running task that waits for this event,
+ * in the order they were started.
+ *
+ */
+void taskDispatch(const sched_event_t *evt);
+
+#endif /* SRC_TASK_H_ */
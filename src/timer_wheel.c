@@ -0,0 +1,313 @@
+/*
+* File Name: timer_wheel.c
+* File Description: This file contains a hierarchical timer wheel with O(1)
+* insert and cancel. It has no hardware dependencies; timers.c drives it from
+* the LETIMER0 compare match.
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+* Reference: G. Varghese and T. Lauck, Hashed and Hierarchical Timing Wheels
+**/
+
+#include <stddef.h>
+#include "src/timer_wheel.h"
+
+#define LEVEL_SHIFT(level) ((level) * TIMER_WHEEL_SLOT_BITS)
+#define SLOT_MASK          (TIMER_WHEEL_SLOTS - 1)
+
+/*
+ * Function Name: rotate_right
+ *
+ * Parameters:
+ * uint32_t bits Occupancy bitmap
+ * uint32_t shift Rotation, 0..31
+ *
+ * Returns:
+ * uint32_t Rotated bitmap
+ *
+ * Brief: This function rotates a slot bitmap so the slot after the current
+ * one ends up in bit 0.
+ *
+ */
+static uint32_t rotate_right(uint32_t bits, uint32_t shift)
+{
+  shift &= SLOT_MASK;
+  return shift ? (bits >> shift) | (bits << (32 - shift)) : bits;
+}
+
+/*
+ * Function Name: wheel_link
+ *
+ * Parameters:
+ * timer_wheel_t *wheel Timer wheel
+ * sw_timer_t *timer Timer to link
+ * uint32_t delta Ticks from the wheel time to the expiry, 1..TIMER_WHEEL_MAX_DELAY
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function puts a timer on the finest level that can hold its
+ * delay, in the slot indexed by its expiry on that level.
+ *
+ */
+static void wheel_link(timer_wheel_t *wheel, sw_timer_t *timer, uint32_t delta)
+{
+  uint8_t level = 0;
+
+  while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (1UL << LEVEL_SHIFT(level + 1))) {
+      level++;
+  }
+
+  timer->level = level;
+  timer->slot = (timer->expiry >> LEVEL_SHIFT(level)) & SLOT_MASK;
+  timer->prev = NULL;
+  timer->next = wheel->slots[level][timer->slot];
+  if (timer->next) {
+      timer->next->prev = timer;
+  }
+  wheel->slots[level][timer->slot] = timer;
+  wheel->occupied[level] |= 1UL << timer->slot;
+  timer->armed = true;
+}
+
+/*
+ * Function Name: wheel_take_slot
+ *
+ * Parameters:
+ * timer_wheel_t *wheel Timer wheel
+ * uint8_t level Wheel level
+ * uint32_t slot Slot index
+ *
+ * Returns:
+ * sw_timer_t* Timers that were in the slot, linked through next
+ *
+ * Brief: This function empties one slot.
+ *
+ */
+static sw_timer_t *wheel_take_slot(timer_wheel_t *wheel, uint8_t level, uint32_t slot)
+{
+  sw_timer_t *list = wheel->slots[level][slot];
+
+  wheel->slots[level][slot] = NULL;
+  wheel->occupied[level] &= ~(1UL << slot);
+
+  return list;
+}
+
+/*
+ * Function Name: timer_wheel_init
+ *
+ * Parameters:
+ * timer_wheel_t *wheel Wheel to initialize
+ * uint32_t now Current tick
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function empties the wheel and sets its time.
+ *
+ */
+void timer_wheel_init(timer_wheel_t *wheel, uint32_t now)
+{
+  wheel->now = now;
+
+  for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+      wheel->occupied[level] = 0;
+      for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+          wheel->slots[level][slot] = NULL;
+      }
+  }
+}
+
+/*
+ * Function Name: timer_wheel_add
+ *
+ * Parameters:
+ * timer_wheel_t *wheel Timer wheel
+ * sw_timer_t *timer Timer with expiry set, not armed
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function links a timer into the slot for its expiry in O(1).
+ * An expiry that is already due fires on the next tick. The expiry must be
+ * within TIMER_WHEEL_MAX_DELAY of the wheel time.
+ *
+ */
+void timer_wheel_add(timer_wheel_t *wheel, sw_timer_t *timer)
+{
+  uint32_t delta = timer->expiry - wheel->now;
+
+  if ((int32_t)delta <= 0) {
+      delta = 1;
+  }
+  else if (delta > TIMER_WHEEL_MAX_DELAY) {
+      delta = TIMER_WHEEL_MAX_DELAY;
+  }
+  timer->expiry = wheel->now + delta;
+
+  wheel_link(wheel, timer, delta);
+}
+
+/*
+ * Function Name: timer_wheel_remove
+ *
+ * Parameters:
+ * timer_wheel_t *wheel Timer wheel
+ * sw_timer_t *timer Timer to cancel
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function unlinks an armed timer in O(1); it does nothing if
+ * the timer is not armed.
+ *
+ */
+void timer_wheel_remove(timer_wheel_t *wheel, sw_timer_t *timer)
+{
+  if (!timer->armed) {
+      return;
+  }
+
+  if (timer->prev) {
+      timer->prev->next = timer->next;
+  }
+  else {
+      wheel->slots[timer->level][timer->slot] = timer->next;
+  }
+
+  if (timer->next) {
+      timer->next->prev = timer->prev;
+  }
+
+  if (wheel->slots[timer->level][timer->slot] == NULL) {
+      wheel->occupied[timer->level] &= ~(1UL << timer->slot);
+  }
+
+  timer->next = NULL;
+  timer->prev = NULL;
+  timer->armed = false;
+}
+
+/*
+ * Function Name: timer_wheel_next
+ *
+ * Parameters:
+ * const timer_wheel_t *wheel Timer wheel
+ * uint32_t *when Tick at which the wheel next needs to be advanced
+ *
+ * Returns:
+ * bool false if no timer is armed
+ *
+ * Brief: This function returns the next tick at which a timer expires or a
+ * slot of a coarser level has to be moved down. Empty slots are skipped
+ * using the occupancy bitmaps.
+ *
+ */
+/*
+ * A level n slot is visited when the wheel time enters its window, i.e. when
+ * the level n index becomes the slot and the finer bits are zero. Counting
+ * from the slot after the current index, the first occupied slot at distance
+ * d is visited d + 1 windows after the current one. A slot equal to the
+ * current index holds timers a full rotation out and comes last.
+ */
+bool timer_wheel_next(const timer_wheel_t *wheel, uint32_t *when)
+{
+  bool found = false;
+  uint32_t best = 0;
+
+  for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+      uint32_t window, current, distance, tick;
+
+      if (wheel->occupied[level] == 0) {
+          continue;
+      }
+
+      window = wheel->now >> LEVEL_SHIFT(level);
+      current = window & SLOT_MASK;
+      distance = (uint32_t)__builtin_ctz(rotate_right(wheel->occupied[level], current + 1));
+      tick = (window + distance + 1) << LEVEL_SHIFT(level);
+
+      if (!found || (tick - wheel->now) < (best - wheel->now)) {
+          best = tick;
+          found = true;
+      }
+  }
+
+  if (found) {
+      *when = best;
+  }
+
+  return found;
+}
+
+/*
+ * Function Name: timer_wheel_advance
+ *
+ * Parameters:
+ * timer_wheel_t *wheel Timer wheel
+ * uint32_t now Current tick
+ *
+ * Returns:
+ * sw_timer_t* Expired timers linked through next, no longer armed
+ *
+ * Brief: This function moves the wheel time to now, jumping directly between
+ * the ticks returned by timer_wheel_next, and returns the timers that
+ * expired on the way in expiry order.
+ *
+ */
+sw_timer_t *timer_wheel_advance(timer_wheel_t *wheel, uint32_t now)
+{
+  sw_timer_t *expired = NULL;
+  sw_timer_t **tail = &expired;
+
+  while (wheel->now != now) {
+      uint32_t tick;
+
+      if (!timer_wheel_next(wheel, &tick) || (int32_t)(tick - now) > 0) {
+          wheel->now = now;
+          break;
+      }
+
+      wheel->now = tick;
+
+      /* Move down every coarser slot whose window starts at this tick */
+      for (int level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+          sw_timer_t *list;
+
+          if (tick & ((1UL << LEVEL_SHIFT(level)) - 1)) {
+              continue;
+          }
+
+          list = wheel_take_slot(wheel, (uint8_t)level, (tick >> LEVEL_SHIFT(level)) & SLOT_MASK);
+          while (list) {
+              sw_timer_t *timer = list;
+              list = list->next;
+
+              if (timer->expiry == tick) {
+                  timer->armed = false;
+                  timer->prev = NULL;
+                  timer->next = NULL;
+                  *tail = timer;
+                  tail = &timer->next;
+              }
+              else {
+                  wheel_link(wheel, timer, timer->expiry - tick);
+              }
+          }
+      }
+
+      /* Every timer in the level 0 slot of this tick expires now */
+      for (sw_timer_t *list = wheel_take_slot(wheel, 0, tick & SLOT_MASK); list; ) {
+          sw_timer_t *timer = list;
+          list = list->next;
+
+          timer->armed = false;
+          timer->prev = NULL;
+          timer->next = NULL;
+          *tail = timer;
+          tail = &timer->next;
+      }
+  }
+
+  return expired;
+}
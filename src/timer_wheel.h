@@ -0,0 +1,124 @@
+/*
+* File Name: timer_wheel.h
+* File Description: This file contains the declarations for the hierarchical
+* timer wheel in timer_wheel.c
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#ifndef SRC_TIMER_WHEEL_H_
+#define SRC_TIMER_WHEEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TIMER_WHEEL_LEVELS     4
+#define TIMER_WHEEL_SLOT_BITS  5
+#define TIMER_WHEEL_SLOTS      (1 << TIMER_WHEEL_SLOT_BITS)
+
+/* Longest delay that can be queued, in ticks */
+#define TIMER_WHEEL_MAX_DELAY  ((1UL << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOT_BITS)) - 1)
+
+/* Software timer, owned by the caller and linked into the wheel while armed */
+typedef struct sw_timer {
+  struct sw_timer *next;
+  struct sw_timer *prev;
+  uint32_t expiry;   /* Absolute tick */
+  uint32_t period;   /* Reload in ticks, 0 for a one shot timer */
+  uint16_t evt;      /* Scheduler event posted on expiry */
+  uint32_t payload;  /* Event payload */
+  uint8_t  level;
+  uint8_t  slot;
+  bool     armed;
+} sw_timer_t;
+
+/* Timer wheel: 4 levels of 32 slots, each level 32 times coarser */
+typedef struct {
+  uint32_t now;                      /* Every timer up to this tick has expired */
+  uint32_t occupied[TIMER_WHEEL_LEVELS]; /* Bit n set when slot n is not empty */
+  sw_timer_t *slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+} timer_wheel_t;
+
+/*
+ * Function Name: timer_wheel_init
+ *
+ * Parameters:
+ * timer_wheel_t *wheel Wheel to initialize
+ * uint32_t now Current tick
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function empties the wheel and sets its time.
+ *
+ */
+void timer_wheel_init(timer_wheel_t *wheel, uint32_t now);
+
+/*
+ * Function Name: timer_wheel_add
+ *
+ * Parameters:
+ * timer_wheel_t *wheel Timer wheel
+ * sw_timer_t *timer Timer with expiry set, not armed
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function links a timer into the slot for its expiry in O(1).
+ * An expiry that is already due fires on the next tick. The expiry must be
+ * within TIMER_WHEEL_MAX_DELAY of the wheel time.
+ *
+ */
+void timer_wheel_add(timer_wheel_t *wheel, sw_timer_t *timer);
+
+/*
+ * Function Name: timer_wheel_remove
+ *
+ * Parameters:
+ * timer_wheel_t *wheel Timer wheel
+ * sw_timer_t *timer Timer to cancel
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function unlinks an armed timer in O(1); it does nothing if
+ * the timer is not armed.
+ *
+ */
+void timer_wheel_remove(timer_wheel_t *wheel, sw_timer_t *timer);
+
+/*
+ * Function Name: timer_wheel_next
+ *
+ * Parameters:
+ * const timer_wheel_t *wheel Timer wheel
+ * uint32_t *when Tick at which the wheel next needs to be advanced
+ *
+ * Returns:
+ * bool false if no timer is armed
+ *
+ * Brief: This function returns the next tick at which a timer expires or a
+ * slot of a coarser level has to be moved down. Empty slots are skipped
+ * using the occupancy bitmaps.
+ *
+ */
+bool timer_wheel_next(const timer_wheel_t *wheel, uint32_t *when);
+
+/*
+ * Function Name: timer_wheel_advance
+ *
+ * Parameters:
+ * timer_wheel_t *wheel Timer wheel
+ * uint32_t now Current tick
+ *
+ * Returns:
+ * sw_timer_t* Expired timers linked through next, no longer armed
+ *
+ * Brief: This function moves the wheel time to now, jumping directly between
+ * the ticks returned by timer_wheel_next, and returns the timers that
+ * expired on the way in expiry order.
+ *
+ */
+sw_timer_t *timer_wheel_advance(timer_wheel_t *wheel, uint32_t now);
+
+#endif /* SRC_TIMER_WHEEL_H_ */
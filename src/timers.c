@@ -9,7 +9,13 @@
 #include "em_chip.h"
 #include "em_cmu.h"
 #include "em_letimer.h"
+#include "em_core.h"
+#include "sl_power_manager.h"
 #include "app.h"
+#include "src/timers.h"
+#include "src/timer_wheel.h"
+#include "src/scheduler.h"
+#include "src/power.h"
 #include <stdint.h>
 
 #define INCLUDE_LOG_DEBUG 1
@@ -18,9 +24,32 @@
 #define WAIT_LOWER_LIMIT 62
 #define WAIT_UPPER_LIMIT 3000000
 
+/* Longest timer delay or period; the wheel may lag the clock by one LETIMER0 period */
+#define TIMER_MAX_MS (TIMER_WHEEL_MAX_DELAY - LETIMER_PERIOD_MS)
+
 uint32_t clock_freq;
 uint32_t counter_value;
 
+static timer_wheel_t wheel;            /* Software timers, 1 ms ticks */
+/*
+ * Underflow count as a sequence number: odd while the LETIMER0 interrupt is
+ * counting an underflow, so the underflow count is (underflowSeq + 1) / 2
+ */
+static volatile uint32_t underflowSeq;
+static uint32_t usPerTickQ8;           /* Microseconds per LETIMER0 tick, Q24.8 */
+
+/* The one outstanding microsecond delay, timed in LETIMER0 ticks */
+static struct {
+  volatile bool active;
+  uint32_t deadline;         /* Absolute tick */
+  timer_delay_cb_t callback; /* NULL: post evt instead */
+  void *arg;
+  evt_t evt;
+  uint32_t payload;
+} delay;
+
+static volatile bool waitUsDone;      /* Set when the delay of timerWaitUs ends */
+
 /*
  * Function Name: low_energy_timerInit
  *
@@ -44,7 +73,11 @@ void low_energy_timerInit(void)
 
   LETIMER_Init_TypeDef letimerInit = LETIMER_INIT_DEFAULT;
   letimerInit.enable = false;
-  letimerInit.topValue = counter_value;
+  letimerInit.topValue = counter_value - 1; /* Counts top..0, so one period is counter_value ticks */
+
+  underflowSeq = 0;
+  usPerTickQ8 = (1000000UL << 8) / clock_freq; /* Exact for 16384 Hz and 1000 Hz */
+  timer_wheel_init(&wheel, 0);
 
   /* Initialize and enable LETIMER */
   LETIMER_Init(LETIMER0, &letimerInit);
@@ -52,33 +85,505 @@ void low_energy_timerInit(void)
 }
 
 /*
- * Function Name: timerWaitUs
+ * Function Name: timer_read
  *
  * Parameters:
- * uint32_t us_wait Wait time in microseconds
+ * uint32_t *count Filled in with the LETIMER0 ticks elapsed in the period
  *
  * Returns:
+ * uint32_t LETIMER0 underflows matching that tick count
+ *
+ * Brief: This function reads the underflow count and the live counter
+ * without masking interrupts. The read is retried if the LETIMER0 interrupt
+ * counted an underflow in between. A reader that interrupted the count
+ * itself sees an odd sequence and takes the underflow as counted. An
+ * underflow whose interrupt has not run yet is added when the counter was
+ * read after the reload, i.e. it is still in the upper half of the period.
+ *
+ */
+static uint32_t timer_read(uint32_t *count)
+{
+  uint32_t seq, counter, pending, underflows;
+
+  if (clock_freq == 0) { /* Logging before low_energy_timerInit */
+      *count = 0;
+      return 0;
+  }
+
+  do {
+      seq = underflowSeq;
+      counter = LETIMER_CounterGet(LETIMER0);
+      pending = LETIMER_IntGet(LETIMER0) & LETIMER_IF_UF;
+  } while (seq != underflowSeq);
+
+  underflows = (seq + 1) >> 1;
+  if (!(seq & 1) && pending && counter > counter_value / 2) {
+      underflows++;
+  }
+
+  *count = (counter_value - 1) - counter;
+
+  return underflows;
+}
+
+/*
+ * Function Name: timer_counted
+ *
+ * Parameters:
  * none
  *
- * Brief: This function implements a polling based delay based on the time
- * specified by us_wait parameter. The delay is implemented relative to the
- * current LETIMER counter value with roll around handled.
+ * Returns:
+ * uint32_t Underflows counted by the LETIMER0 interrupt
+ *
+ * Brief: This function is used where the count cannot change, with
+ * interrupts masked or from the LETIMER0 interrupt after counting.
  *
  */
-void timerWaitUs(uint32_t us_wait)
+static uint32_t timer_counted(void)
+{
+  return underflowSeq >> 1;
+}
+
+/*
+ * Function Name: timer_now_ticks
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * uint32_t LETIMER0 ticks since low_energy_timerInit, wrapping
+ *
+ * Brief: This function returns the free running tick count used to time
+ * microsecond delays.
+ *
+ */
+static uint32_t timer_now_ticks(void)
+{
+  uint32_t count;
+  uint32_t underflows = timer_read(&count);
+
+  return underflows * counter_value + count;
+}
+
+/*
+ * Function Name: timerNowTicks
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * uint64_t LETIMER0 ticks since low_energy_timerInit
+ *
+ * Brief: This function returns the monotonic time base in LETIMER0 ticks,
+ * 1/16384 s with LFXO or 1 ms with ULFRCO in EM3. It is lock free and safe
+ * to call from any interrupt.
+ *
+ */
+uint64_t timerNowTicks(void)
+{
+  uint32_t count;
+  uint32_t underflows = timer_read(&count);
+
+  return (uint64_t)underflows * counter_value + count;
+}
+
+/*
+ * Function Name: timerNowUs
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * uint64_t Microseconds since low_energy_timerInit
+ *
+ * Brief: This function returns the monotonic time base in microseconds, at
+ * the resolution of the LETIMER0 clock. It is lock free and safe to call from
+ * any interrupt.
+ *
+ */
+uint64_t timerNowUs(void)
+{
+  uint32_t count;
+  uint32_t underflows = timer_read(&count);
+
+  /* count * usPerTickQ8 < 2^30 for both LETIMER0 clocks */
+  return (uint64_t)underflows * (LETIMER_PERIOD_MS * 1000UL) + ((count * usPerTickQ8) >> 8);
+}
+
+/*
+ * Function Name: timerNowMs
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * uint32_t Milliseconds since low_energy_timerInit, wrapping after 49 days
+ *
+ * Brief: This function returns the low 32 bits of the monotonic time base in
+ * milliseconds. It is lock free and safe to call from any interrupt.
+ *
+ */
+uint32_t timerNowMs(void)
+{
+  uint32_t count;
+  uint32_t underflows = timer_read(&count);
+
+  return underflows * LETIMER_PERIOD_MS + (count * 1000) / clock_freq;
+}
+
+/*
+ * Function Name: timerCountUnderflow
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function counts a LETIMER0 underflow and clears its interrupt
+ * flag. It must be called from the LETIMER0 interrupt before the flag is
+ * cleared anywhere else, so the time base never goes back by a period.
+ *
+ */
+void timerCountUnderflow(void)
 {
+  underflowSeq++; /* Odd: counting */
+  LETIMER_IntClear(LETIMER0, LETIMER_IF_UF);
+  underflowSeq++; /* Even: counted */
+}
+
+/*
+ * Function Name: timer_program_compare
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function points COMP1 at the earlier of the next time the wheel
+ * needs service and the end of the microsecond delay. Deadlines past the
+ * current LETIMER0 period are left to the underflow interrupt, and a deadline
+ * that has already passed raises COMP1 right away. Called with interrupts
+ * masked or from the LETIMER0 interrupt.
+ *
+ */
+static void timer_program_compare(void)
+{
+  uint32_t next, offset, target;
+  bool armed = false;
+
+  target = 0;
+
+  if (timer_wheel_next(&wheel, &next)) {
+      if ((int32_t)(next - timerNowMs()) <= 0) {
+          LETIMER_IntEnable(LETIMER0, LETIMER_IEN_COMP1);
+          LETIMER_IntSet(LETIMER0, LETIMER_IF_COMP1);
+          return;
+      }
+
+      offset = next - timer_counted() * LETIMER_PERIOD_MS;
+      if (offset < LETIMER_PERIOD_MS) {
+          /* Round up so the millisecond has fully elapsed */
+          target = (counter_value - 1) - (offset * clock_freq + 999) / 1000;
+          armed = true;
+      }
+  }
+
+  if (delay.active) {
+      if ((int32_t)(delay.deadline - timer_now_ticks()) <= 0) {
+          LETIMER_IntEnable(LETIMER0, LETIMER_IEN_COMP1);
+          LETIMER_IntSet(LETIMER0, LETIMER_IF_COMP1);
+          return;
+      }
+
+      offset = delay.deadline - timer_counted() * counter_value;
+      if (offset < counter_value) {
+          uint32_t count = (counter_value - 1) - offset;
+
+          /* The counter counts down, so the larger count comes first */
+          if (!armed || count > target) {
+              target = count;
+          }
+          armed = true;
+      }
+  }
+
+  if (!armed) {
+      LETIMER_IntDisable(LETIMER0, LETIMER_IEN_COMP1);
+      return;
+  }
+
+  LETIMER_CompareSet(LETIMER0, 1, target);
+  LETIMER_IntClear(LETIMER0, LETIMER_IF_COMP1);
+  LETIMER_IntEnable(LETIMER0, LETIMER_IEN_COMP1);
+
+  /* The counter may have passed the target while it was written */
+  if (LETIMER_CounterGet(LETIMER0) <= target) {
+      LETIMER_IntSet(LETIMER0, LETIMER_IF_COMP1);
+  }
+}
+
+/*
+ * Function Name: timerStart
+ *
+ * Parameters:
+ * sw_timer_t *timer Timer, restarted if already armed
+ * uint32_t delay_ms Time to the first expiry, about 17 minutes at most
+ * uint32_t period_ms Reload time for a periodic timer, 0 for a one shot
+ * evt_t evt Scheduler event posted on every expiry
+ * uint32_t payload Payload of that event
+ *
+ * Returns:
+ * bool false if the delay or period is out of range
+ *
+ * Brief: This function arms a software timer on the timer wheel in O(1).
+ * LETIMER0 COMP1 is moved only if the timer is the next deadline.
+ *
+ */
+bool timerStart(sw_timer_t *timer, uint32_t delay_ms, uint32_t period_ms, evt_t evt, uint32_t payload)
+{
+  if (delay_ms > TIMER_MAX_MS || period_ms > TIMER_MAX_MS) {
+      LOG_ERROR("Timer delay %lu ms or period %lu ms out of range\n\r",
+                (unsigned long)delay_ms, (unsigned long)period_ms);
+      return false;
+  }
+
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  timer_wheel_remove(&wheel, timer);
+  timer->expiry = timerNowMs() + delay_ms;
+  timer->period = period_ms;
+  timer->evt = (uint16_t)evt;
+  timer->payload = payload;
+  timer_wheel_add(&wheel, timer);
+  timer_program_compare();
+  CORE_EXIT_CRITICAL();
+
+  return true;
+}
+
+/*
+ * Function Name: timerStop
+ *
+ * Parameters:
+ * sw_timer_t *timer Timer to cancel
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function cancels a software timer in O(1).
+ *
+ */
+void timerStop(sw_timer_t *timer)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  timer_wheel_remove(&wheel, timer);
+  timer_program_compare();
+  CORE_EXIT_CRITICAL();
+}
+
+/*
+ * Function Name: timerServiceIrq
+ *
+ * Parameters:
+ * uint32_t flags LETIMER0 interrupt flags
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function is called from the LETIMER0 interrupt after
+ * timerCountUnderflow. It posts the events of the expired timers, reloads
+ * periodic timers and programs COMP1 for the next deadline.
+ *
+ */
+void timerServiceIrq(uint32_t flags)
+{
+  sw_timer_t *expired;
+
+  if (!(flags & (LETIMER_IF_UF | LETIMER_IF_COMP1))) {
+      return;
+  }
+
+  if (delay.active && (int32_t)(delay.deadline - timer_now_ticks()) <= 0) {
+      delay.active = false;
+      if (delay.callback) {
+          delay.callback(delay.arg);
+      }
+      else {
+          schedulerPostEvent(delay.evt, delay.payload);
+      }
+  }
+
+  expired = timer_wheel_advance(&wheel, timerNowMs());
+
+  while (expired) {
+      sw_timer_t *timer = expired;
+      expired = expired->next;
+
+      schedulerPostEvent((evt_t)timer->evt, timer->payload);
+
+      if (timer->period) {
+          timer->expiry += timer->period; /* Keeps the phase, late reloads fire on the next tick */
+          timer_wheel_add(&wheel, timer);
+      }
+  }
+
+  timer_program_compare();
+}
+
+/*
+ * Function Name: timer_delay_start
+ *
+ * Parameters:
+ * uint32_t us_wait Delay in microseconds
+ * timer_delay_cb_t callback Completion callback, NULL to post evt
+ * void *arg Callback argument
+ * evt_t evt Event posted on completion without a callback
+ * uint32_t payload Event payload
+ *
+ * Returns:
+ * bool false if the delay is out of range or one is already running
+ *
+ * Brief: This function converts the delay to LETIMER0 ticks, rounding up,
+ * and arms COMP1 for it.
+ *
+ */
+static bool timer_delay_start(uint32_t us_wait, timer_delay_cb_t callback, void *arg,
+                              evt_t evt, uint32_t payload)
+{
+  uint32_t ms = us_wait / 1000;
+  uint32_t ticks;
+
   /* Range check for input us_wait*/
   if (us_wait < WAIT_LOWER_LIMIT || us_wait > WAIT_UPPER_LIMIT) {
       LOG_ERROR("Error: Wait Time out of range.\n\r");
-      return;
+      return false;
   }
 
-  uint32_t current_count = LETIMER_CounterGet(LETIMER0); /* Retrieve current count*/
-  uint32_t wait_count = ((us_wait)*(clock_freq/1000))/1000; /* Compute count to wait for microseconds*/
+  /* ceil(us_wait * clock_freq / 1e6) in 32 bits, split at the millisecond */
+  ticks = (ms * clock_freq + ((us_wait % 1000) * clock_freq + 999) / 1000 + 999) / 1000;
 
-  /* Computing value to reach for delay with roll around based on topValue*/
-  uint32_t count_difference = (current_count - wait_count + counter_value) % (counter_value);
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if (delay.active) {
+      CORE_EXIT_CRITICAL();
+      LOG_ERROR("Delay already running\n\r");
+      return false;
+  }
+  delay.deadline = timer_now_ticks() + ticks;
+  delay.callback = callback;
+  delay.arg = arg;
+  delay.evt = evt;
+  delay.payload = payload;
+  delay.active = true;
+  timer_program_compare();
+  CORE_EXIT_CRITICAL();
 
-  while (LETIMER_CounterGet(LETIMER0) != (count_difference)); /* Blocking for delay */
+  return true;
+}
+
+/*
+ * Function Name: timerDelayUs
+ *
+ * Parameters:
+ * uint32_t us_wait Delay in microseconds, 62 to 3000000
+ * timer_delay_cb_t callback Called from the LETIMER0 interrupt when the delay ends
+ * void *arg Callback argument
+ *
+ * Returns:
+ * bool false if the delay is out of range or another delay is running
+ *
+ * Brief: This function starts a non-blocking delay. LETIMER0 COMP1 is set
+ * relative to the current count, counting across underflows, and its
+ * interrupt ends the delay. Only one delay can run at a time; use timerStart
+ * for anything longer lived.
+ *
+ */
+bool timerDelayUs(uint32_t us_wait, timer_delay_cb_t callback, void *arg)
+{
+  return timer_delay_start(us_wait, callback, arg, evtNoEvent, 0);
+}
+
+/*
+ * Function Name: timerDelayUsEvent
+ *
+ * Parameters:
+ * uint32_t us_wait Delay in microseconds, 62 to 3000000
+ * evt_t evt Scheduler event posted when the delay ends
+ * uint32_t payload Event payload
+ *
+ * Returns:
+ * bool false if the delay is out of range or another delay is running
+ *
+ * Brief: This function starts a non-blocking delay that ends with a
+ * scheduler event.
+ *
+ */
+bool timerDelayUsEvent(uint32_t us_wait, evt_t evt, uint32_t payload)
+{
+  return timer_delay_start(us_wait, NULL, NULL, evt, payload);
+}
+
+/*
+ * Function Name: timer_wait_done
+ *
+ * Parameters:
+ * void *arg Unused
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function ends a blocking timerWaitUs, from the LETIMER0 COMP1
+ * interrupt.
+ *
+ */
+static void timer_wait_done(void *arg)
+{
+  (void)arg;
+  waitUsDone = true;
+}
+
+/*
+ * Function Name: timer_wait_is_done
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * bool true once the delay of timerWaitUs has ended
+ *
+ * Brief: This function is the wake condition of timerWaitUs.
+ *
+ */
+static bool timer_wait_is_done(void)
+{
+  return waitUsDone;
+}
+
+/*
+ * Function Name: timerWaitUs
+ *
+ * Parameters:
+ * uint32_t us_wait Wait time in microseconds
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function blocks for us_wait microseconds. The delay ends with
+ * a LETIMER0 COMP1 interrupt, so the core sleeps in the lowest allowed
+ * energy mode instead of polling the counter. The wait goes through
+ * powerSleepUntil, so an interrupt just before the sleep is not missed.
+ *
+ */
+void timerWaitUs(uint32_t us_wait)
+{
+  waitUsDone = false;
+
+  if (!timerDelayUs(us_wait, timer_wait_done, NULL)) {
+      return;
+  }
 
+  powerSleepUntil(timer_wait_is_done);
 }
@@ -9,6 +9,9 @@
 #define SRC_TIMERS_H_
 
 #include <stdint.h>
+#include <stdbool.h>
+#include "src/scheduler.h"
+#include "src/timer_wheel.h"
 
 /*
  * Function Name: low_energy_timerInit
@@ -26,6 +29,45 @@
  */
 void low_energy_timerInit(void);
 
+/* Completion callback of timerDelayUs, called from the LETIMER0 interrupt */
+typedef void (*timer_delay_cb_t)(void *arg);
+
+/*
+ * Function Name: timerDelayUs
+ *
+ * Parameters:
+ * uint32_t us_wait Delay in microseconds, 62 to 3000000
+ * timer_delay_cb_t callback Called from the LETIMER0 interrupt when the delay ends
+ * void *arg Callback argument
+ *
+ * Returns:
+ * bool false if the delay is out of range or another delay is running
+ *
+ * Brief: This function starts a non-blocking delay. LETIMER0 COMP1 is set
+ * relative to the current count, counting across underflows, and its
+ * interrupt ends the delay. Only one delay can run at a time; use timerStart
+ * for anything longer lived.
+ *
+ */
+bool timerDelayUs(uint32_t us_wait, timer_delay_cb_t callback, void *arg);
+
+/*
+ * Function Name: timerDelayUsEvent
+ *
+ * Parameters:
+ * uint32_t us_wait Delay in microseconds, 62 to 3000000
+ * evt_t evt Scheduler event posted when the delay ends
+ * uint32_t payload Event payload
+ *
+ * Returns:
+ * bool false if the delay is out of range or another delay is running
+ *
+ * Brief: This function starts a non-blocking delay that ends with a
+ * scheduler event.
+ *
+ */
+bool timerDelayUsEvent(uint32_t us_wait, evt_t evt, uint32_t payload);
+
 /*
  * Function Name: timerWaitUs
  *
@@ -35,11 +77,123 @@ void low_energy_timerInit(void);
  * Returns:
  * none
  *
- * Brief: This function implements a polling based delay based on the time
- * specified by us_wait parameter. The delay is implemented relative to the
- * current LETIMER counter value with roll around handled.
+ * Brief: This function blocks for us_wait microseconds using timerDelayUs.
+ * The core sleeps in the lowest allowed energy mode until the LETIMER0
+ * COMP1 interrupt ends the delay.
  *
  */
 void timerWaitUs(uint32_t us_wait);
 
+/*
+ * Function Name: timerCountUnderflow
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function counts a LETIMER0 underflow and clears its interrupt
+ * flag. It must be called from the LETIMER0 interrupt before the flag is
+ * cleared anywhere else, so the time base never goes back by a period.
+ *
+ */
+void timerCountUnderflow(void);
+
+/*
+ * Function Name: timerNowTicks
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * uint64_t LETIMER0 ticks since low_energy_timerInit
+ *
+ * Brief: This function returns the monotonic time base in LETIMER0 ticks,
+ * 1/16384 s with LFXO or 1 ms with ULFRCO in EM3. It is lock free and safe
+ * to call from any interrupt.
+ *
+ */
+uint64_t timerNowTicks(void);
+
+/*
+ * Function Name: timerNowUs
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * uint64_t Microseconds since low_energy_timerInit
+ *
+ * Brief: This function returns the monotonic time base in microseconds, at
+ * the resolution of the LETIMER0 clock. It is lock free and safe to call from
+ * any interrupt.
+ *
+ */
+uint64_t timerNowUs(void);
+
+/*
+ * Function Name: timerNowMs
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * uint32_t Milliseconds since low_energy_timerInit, wrapping after 49 days
+ *
+ * Brief: This function returns the low 32 bits of the monotonic time base in
+ * milliseconds. It is lock free and safe to call from any interrupt.
+ *
+ */
+uint32_t timerNowMs(void);
+
+/*
+ * Function Name: timerStart
+ *
+ * Parameters:
+ * sw_timer_t *timer Timer, restarted if already armed
+ * uint32_t delay_ms Time to the first expiry, about 17 minutes at most
+ * uint32_t period_ms Reload time for a periodic timer, 0 for a one shot
+ * evt_t evt Scheduler event posted on every expiry
+ * uint32_t payload Payload of that event
+ *
+ * Returns:
+ * bool false if the delay or period is out of range
+ *
+ * Brief: This function arms a software timer on the timer wheel in O(1).
+ * LETIMER0 COMP1 is moved only if the timer is the next deadline.
+ *
+ */
+bool timerStart(sw_timer_t *timer, uint32_t delay_ms, uint32_t period_ms, evt_t evt, uint32_t payload);
+
+/*
+ * Function Name: timerStop
+ *
+ * Parameters:
+ * sw_timer_t *timer Timer to cancel
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function cancels a software timer in O(1).
+ *
+ */
+void timerStop(sw_timer_t *timer);
+
+/*
+ * Function Name: timerServiceIrq
+ *
+ * Parameters:
+ * uint32_t flags LETIMER0 interrupt flags
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function is called from the LETIMER0 interrupt after
+ * timerCountUnderflow. It posts the events of the expired timers, reloads
+ * periodic timers and programs COMP1 for the next deadline.
+ *
+ */
+void timerServiceIrq(uint32_t flags);
+
 #endif /* SRC_TIMERS_H_ */
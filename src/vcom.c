@@ -0,0 +1,355 @@
+/*
+* File Name: vcom.c
+* File Description: This file contains the LDMA driven transmit path of the
+* VCOM iostream (USART0). Writes are copied into a double-buffered TX ring and
+* return; the LDMA writes one half out while the other one fills, so logging
+* no longer keeps the core in EM0 for the length of every line.
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#include <stdint.h>
+#include "em_device.h"
+#include "em_core.h"
+#include "em_usart.h"
+#include "dmadrv.h"
+#include "sl_iostream_uart.h"
+#include "sl_iostream_usart.h"
+#include "sl_iostream_init_usart_instances.h"
+#include "src/power.h"
+#include "src/vcom.h"
+
+/* The LDMA request signals are those of the USART in sl_iostream_usart_vcom_config.h */
+#define VCOM_TX_SIGNAL    dmadrvPeripheralSignal_USART0_TXBL
+#define VCOM_EMPTY_SIGNAL dmadrvPeripheralSignal_USART0_TXEMPTY
+
+static uint8_t txBuf[2][VCOM_TX_BUF_SIZE];
+static volatile uint8_t fill = 0;       /* Half being filled, the other one is on the LDMA */
+static volatile uint16_t fillLen = 0;   /* Bytes in txBuf[fill] */
+static volatile bool txActive = false;  /* LDMA running, powerReasonVcomTx held */
+static bool draining = false;           /* LDMA waiting for the last byte to leave USART0 */
+static volatile bool blocking = false;
+static uint8_t drainByte;
+
+static unsigned int txChannel;
+static USART_TypeDef *usart;
+static sl_status_t (*polledWrite)(void *context, const void *buffer, size_t buffer_length);
+
+static bool vcom_tx_done(unsigned int channel, unsigned int sequenceNo, void *userParam);
+
+/*
+ * Function Name: vcom_start
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function hands the filled half of the ring to the LDMA, which
+ * writes it to USART0 on TXBL, and switches the writers to the other half.
+ * Called with interrupts disabled.
+ *
+ */
+static void vcom_start(void)
+{
+  uint8_t *buf = txBuf[fill];
+  uint16_t len = fillLen;
+
+  fill ^= 1;
+  fillLen = 0;
+  draining = false;
+
+  DMADRV_MemoryPeripheral(txChannel, VCOM_TX_SIGNAL, (void *) &usart->TXDATA, buf, true,
+                          len, dmadrvDataSize1, vcom_tx_done, NULL);
+}
+
+/*
+ * Function Name: vcom_wait_empty
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function arms a one byte memory to memory transfer on TXEMPTY,
+ * which completes once the last byte has left the shift register. USART0 needs
+ * EM1 until then, so the requirement is only released from its callback.
+ * Called with interrupts disabled.
+ *
+ */
+static void vcom_wait_empty(void)
+{
+  draining = true;
+
+  DMADRV_MemoryPeripheral(txChannel, VCOM_EMPTY_SIGNAL, &drainByte, &drainByte, false,
+                          1, dmadrvDataSize1, vcom_tx_done, NULL);
+}
+
+/*
+ * Function Name: vcom_tx_done
+ *
+ * Parameters:
+ * unsigned int channel LDMA channel
+ * unsigned int sequenceNo DMADRV sequence number
+ * void *userParam unused
+ *
+ * Returns:
+ * bool true (DMADRV ignores the return value for single transfers)
+ *
+ * Brief: DMADRV callback, called from the LDMA IRQ when a half of the ring has
+ * been written or USART0 has gone empty. The next half is started if the
+ * writers filled it in the meantime, otherwise the transmitter is waited out
+ * and the EM1 requirement released.
+ *
+ */
+static bool vcom_tx_done(unsigned int channel, unsigned int sequenceNo, void *userParam)
+{
+  (void) channel;
+  (void) sequenceNo;
+  (void) userParam;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  if (fillLen && !blocking) {
+      vcom_start();
+  }
+  else if (!draining && !blocking) {
+      vcom_wait_empty();
+  }
+  else {
+      draining = false;
+      txActive = false;
+      powerRelease(powerReasonVcomTx);
+  }
+  CORE_EXIT_ATOMIC();
+
+  return true;
+}
+
+/*
+ * Function Name: vcom_poll_out
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function finishes the ring without the LDMA interrupt: it waits
+ * for the running transfer, then polls out the half being filled. When the
+ * interrupt can run again the callback finds nothing to chain and lets USART0
+ * drain as usual.
+ *
+ */
+static void vcom_poll_out(void)
+{
+  bool active = true;
+
+  while (active) {
+      DMADRV_TransferActive(txChannel, &active);
+  }
+
+  for (uint16_t i = 0; i < fillLen; i++) {
+      USART_Tx(usart, txBuf[fill][i]);
+  }
+  fillLen = 0;
+}
+
+/*
+ * Function Name: vcom_half_free
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * bool true once the LDMA has taken the filled half, or writes block
+ *
+ * Brief: This function is the wake condition of a writer that found both
+ * halves of the ring full.
+ *
+ */
+static bool vcom_half_free(void)
+{
+  return fillLen <= VCOM_TX_BUF_SIZE - 2 || blocking;
+}
+
+/*
+ * Function Name: vcom_idle
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * bool true when the LDMA has stopped and USART0 is empty
+ *
+ * Brief: This function is the wake condition of vcomFlush.
+ *
+ */
+static bool vcom_idle(void)
+{
+  return !txActive;
+}
+
+/*
+ * Function Name: vcom_write
+ *
+ * Parameters:
+ * void *context UART context of the VCOM iostream
+ * const void *buffer Data to write
+ * size_t buffer_length Bytes in buffer
+ *
+ * Returns:
+ * sl_status_t SL_STATUS_OK
+ *
+ * Brief: iostream write function of the VCOM. The data (with LF to CRLF
+ * conversion if enabled) is copied into the ring and the LDMA started if it
+ * is idle. Only when both halves are full does the writer sleep, until the
+ * LDMA takes the filled one. A write made where the LDMA interrupt cannot
+ * run is polled out after what is already queued; later writes use the ring
+ * again.
+ *
+ */
+static sl_status_t vcom_write(void *context, const void *buffer, size_t buffer_length)
+{
+  sl_iostream_uart_context_t *uart_context = (sl_iostream_uart_context_t *)context;
+  const char *c = (const char *)buffer;
+  bool crlf = uart_context->lf_to_crlf;
+  bool irqBlocked = CORE_IrqIsBlocked(LDMA_IRQn); /* For this write only */
+  CORE_DECLARE_IRQ_STATE;
+
+  while (buffer_length) {
+      if (blocking || irqBlocked) {
+          vcomFlush();
+          return polledWrite(context, c, buffer_length);
+      }
+
+      CORE_ENTER_ATOMIC();
+      while (buffer_length) {
+          uint16_t need = (crlf && *c == '\n') ? 2 : 1;
+
+          if (fillLen + need > VCOM_TX_BUF_SIZE) {
+              break;
+          }
+          if (need == 2) {
+              txBuf[fill][fillLen++] = '\r';
+          }
+          txBuf[fill][fillLen++] = *c++;
+          buffer_length--;
+      }
+      if (!txActive) {
+          txActive = true;
+          powerRequire(powerReasonVcomTx);
+          vcom_start();
+      }
+      CORE_EXIT_ATOMIC();
+
+      if (buffer_length) {
+          /* Both halves are full: sleep until the LDMA takes the filled one */
+          powerSleepUntil(vcom_half_free);
+      }
+  }
+
+  return SL_STATUS_OK;
+}
+
+/*
+ * Function Name: vcomInit
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function moves the writes of the VCOM iostream onto the TX ring.
+ * A write copies into the half being filled and returns; the LDMA feeds the
+ * other half to USART0 while the core sleeps in EM1. It must be called after
+ * the iostream instances are initialized and after powerInit. Without a free
+ * LDMA channel the SDK polled writes are kept.
+ *
+ */
+void vcomInit(void)
+{
+  sl_iostream_uart_t *uart = sl_iostream_uart_vcom_handle;
+
+  if (!VCOM_TX_DMA || uart->stream.write == NULL) {
+      return;
+  }
+
+  /* DMADRV may already have been initialized by another driver */
+  Ecode_t ecode = DMADRV_Init();
+  if (ecode != ECODE_EMDRV_DMADRV_OK && ecode != ECODE_EMDRV_DMADRV_ALREADY_INITIALIZED) {
+      return;
+  }
+  if (DMADRV_AllocateChannel(&txChannel, NULL) != ECODE_EMDRV_DMADRV_OK) {
+      return;
+  }
+
+  usart = ((sl_iostream_usart_context_t *)uart->stream.context)->usart;
+
+  /* The SDK write stays as the blocking path */
+  polledWrite = uart->stream.write;
+  uart->stream.write = vcom_write;
+}
+
+/*
+ * Function Name: vcomFlush
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function sleeps until everything written has left USART0. When
+ * called from a context that blocks the LDMA interrupt the ring is written out
+ * by polling instead.
+ *
+ */
+void vcomFlush(void)
+{
+  if (polledWrite == NULL) {
+      return;
+  }
+
+  if (CORE_IrqIsBlocked(LDMA_IRQn)) {
+      vcom_poll_out();
+      return;
+  }
+
+  powerSleepUntil(vcom_idle);
+
+  /* Blocking was selected while a transfer ran; its callback did not chain
+   * the half being filled */
+  if (blocking && fillLen) {
+      vcom_poll_out();
+  }
+}
+
+/*
+ * Function Name: vcomSetBlocking
+ *
+ * Parameters:
+ * bool on true to poll USART0 on every write
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function selects blocking writes, for output that has to be out
+ * before the caller goes on, such as a panic message before a reset. The ring
+ * is flushed first so the output stays in order.
+ *
+ */
+void vcomSetBlocking(bool on)
+{
+  if (!on) {
+      blocking = false;
+      return;
+  }
+
+  /* Stop the chaining first so that no new half starts behind the flush */
+  blocking = true;
+  vcomFlush();
+}
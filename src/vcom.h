@@ -0,0 +1,70 @@
+/*
+* File Name: vcom.h
+* File Description: This file contains the declarations for the LDMA driven
+* VCOM transmit path in vcom.c
+* File Author: Gautama Gandhi
+* Tools used: Simplicity Studio IDE
+**/
+
+#ifndef SRC_VCOM_H_
+#define SRC_VCOM_H_
+
+#include <stdbool.h>
+
+#ifndef VCOM_TX_DMA
+#define VCOM_TX_DMA 1 /* 0: every write polls USART0 like the SDK does */
+#endif
+
+#define VCOM_TX_BUF_SIZE 256 /* Bytes per half of the double-buffered TX ring */
+
+/*
+ * Function Name: vcomInit
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function moves the writes of the VCOM iostream onto the TX ring.
+ * A write copies into the half being filled and returns; the LDMA feeds the
+ * other half to USART0 while the core sleeps in EM1. It must be called after
+ * the iostream instances are initialized and after powerInit. Without a free
+ * LDMA channel the SDK polled writes are kept.
+ *
+ */
+void vcomInit(void);
+
+/*
+ * Function Name: vcomFlush
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function sleeps until everything written has left USART0. When
+ * called from a context that blocks the LDMA interrupt the ring is written out
+ * by polling instead.
+ *
+ */
+void vcomFlush(void);
+
+/*
+ * Function Name: vcomSetBlocking
+ *
+ * Parameters:
+ * bool on true to poll USART0 on every write
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function selects blocking writes, for output that has to be out
+ * before the caller goes on, such as a panic message before a reset. The ring
+ * is flushed first so the output stays in order.
+ *
+ */
+void vcomSetBlocking(bool on);
+
+#endif /* SRC_VCOM_H_ */
@@ -0,0 +1,40 @@
+/*
+* File Name: test.h
+* File Description: This file contains the check macros shared by the host
+* tests in this directory. A failed check is reported with its location and
+* the test goes on, main() returns the number of failures.
+* File Author: Gautama Gandhi
+* Tools used: gcc on the host
+**/
+
+#ifndef TEST_TEST_H_
+#define TEST_TEST_H_
+
+#include <stdio.h>
+
+static int test_failures = 0;
+
+#define CHECK(cond)                                                           \
+  do {                                                                        \
+    if (!(cond)) {                                                            \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);       \
+        test_failures++;                                                      \
+    }                                                                         \
+  } while (0)
+
+/* Integer comparison, both values are printed on a mismatch */
+#define CHECK_EQ(actual, expected)                                            \
+  do {                                                                        \
+    long long a_ = (long long)(actual), e_ = (long long)(expected);           \
+    if (a_ != e_) {                                                           \
+        printf("%s:%d: %s is %lld, expected %lld\n",                          \
+               __FILE__, __LINE__, #actual, a_, e_);                          \
+        test_failures++;                                                      \
+    }                                                                         \
+  } while (0)
+
+#define TEST_RESULT(name)                                                     \
+  (printf("%s: %s, %d failure(s)\n", name,                                    \
+          test_failures ? "FAIL" : "PASS", test_failures), test_failures)
+
+#endif /* TEST_TEST_H_ */
@@ -0,0 +1,312 @@
+/*
+* File Name: test_bme680_comp.c
+* File Description: This file contains the host test of the BME680 integer
+* compensation in src/bme680_comp.c. Fixed vectors cover temperature,
+* pressure, humidity, gas, res_heat and gas_wait; the temperature and gas
+* paths that were reworked to avoid 64 bit math are also swept against the
+* 64 bit Bosch reference over their whole input range.
+* File Author: Gautama Gandhi
+* Tools used: gcc on the host
+* Reference: Bosch Sensortec BME680 driver integer compensation
+**/
+
+#include <stdint.h>
+#include "src/bme680_comp.h"
+#include "test/test.h"
+
+/* Calibration read from a BME680 */
+static const bme680_calib_t calib = {
+    .par_t1 = 25872, .par_t2 = 26203, .par_t3 = 3,
+    .par_p1 = 36593, .par_p2 = -10329, .par_p3 = 88, .par_p4 = 6792,
+    .par_p5 = -150, .par_p6 = 30, .par_p7 = 52, .par_p8 = -2765,
+    .par_p9 = -2163, .par_p10 = 30,
+    .par_h1 = 736, .par_h2 = 1027, .par_h3 = 0, .par_h4 = 45, .par_h5 = 20,
+    .par_h6 = 120, .par_h7 = -100,
+    .par_gh1 = -30, .par_gh2 = -5969, .par_gh3 = 18,
+    .res_heat_range = 1, .res_heat_val = 46, .range_sw_err = 0
+};
+
+#define T_FINE_WARM 137636   /* t_fine of temp_adc 500000, 26.88 degC */
+#define T_FINE_COLD (-54297) /* t_fine of temp_adc 380000, -10.60 degC */
+
+/*
+ * Function Name: ref_temperature
+ *
+ * Parameters:
+ * const bme680_calib_t *c Calibration coefficients
+ * uint32_t temp_adc 20 bit temperature ADC value
+ * int32_t *t_fine Fine temperature
+ *
+ * Returns:
+ * int16_t Temperature in 0.01 degC
+ *
+ * Brief: This function is the Bosch temperature compensation with its 64 bit
+ * intermediates.
+ *
+ */
+static int16_t ref_temperature(const bme680_calib_t *c, uint32_t temp_adc, int32_t *t_fine)
+{
+  int64_t var1 = ((int32_t)temp_adc >> 3) - ((int32_t)c->par_t1 << 1);
+  int64_t var2 = (var1 * (int32_t)c->par_t2) >> 11;
+  int64_t var3 = ((var1 >> 1) * (var1 >> 1)) >> 12;
+
+  var3 = (var3 * ((int32_t)c->par_t3 << 4)) >> 14;
+  *t_fine = (int32_t)(var2 + var3);
+
+  return (int16_t)(((*t_fine * 5) + 128) >> 8);
+}
+
+/*
+ * Function Name: ref_gas
+ *
+ * Parameters:
+ * int8_t range_sw_err Range switching error
+ * uint16_t gas_adc 10 bit gas ADC value
+ * uint8_t gas_range 4 bit gas range
+ *
+ * Returns:
+ * uint32_t Gas resistance in Ohm
+ *
+ * Brief: This function is the Bosch gas resistance compensation with its 64
+ * bit intermediates.
+ *
+ */
+static uint32_t ref_gas(int8_t range_sw_err, uint16_t gas_adc, uint8_t gas_range)
+{
+  static const uint32_t table1[16] = {
+      2147483647, 2147483647, 2147483647, 2147483647,
+      2147483647, 2126008810, 2147483647, 2130303777,
+      2147483647, 2147483647, 2143188679, 2136746228,
+      2147483647, 2126008810, 2147483647, 2147483647
+  };
+  static const uint32_t table2[16] = {
+      4096000000, 2048000000, 1024000000,
+      512000000, 255744255, 127110228, 64000000,
+      32258064, 16016016, 8000000, 4000000,
+      2000000, 1000000, 500000, 250000, 125000
+  };
+
+  int64_t var1 = ((1340 + (5 * (int64_t)range_sw_err)) * (int64_t)table1[gas_range]) >> 16;
+  uint64_t var2 = ((int64_t)gas_adc << 15) - 16777216 + var1;
+  int64_t var3 = ((int64_t)table2[gas_range] * var1) >> 9;
+
+  return (uint32_t)((var3 + ((int64_t)var2 >> 1)) / (int64_t)var2);
+}
+
+static void test_temperature(void)
+{
+  static const struct {
+    uint32_t adc;
+    int16_t temperature;
+    int32_t t_fine;
+  } vec[] = {
+      {       0, -12921, -661558 }, /* var1 < 0 */
+      {  300000,  -3559, -182208 }, /* var1 < 0 */
+      {  380000,  -1060,  -54297 }, /* var1 < 0 */
+      {  413952,      0,       0 }, /* var1 == 0 */
+      {  420000,    189,    9672 },
+      {  500000,   2688,  137636 },
+      {  540000,   3938,  201633 },
+      { 1048575,  19845, 1016069 },
+  };
+
+  for (unsigned i = 0; i < sizeof(vec) / sizeof(vec[0]); i++) {
+      int32_t t_fine;
+
+      CHECK_EQ(bme680_comp_temperature(&calib, vec[i].adc, &t_fine), vec[i].temperature);
+      CHECK_EQ(t_fine, vec[i].t_fine);
+  }
+
+  /* t_fine is optional */
+  CHECK_EQ(bme680_comp_temperature(&calib, 500000, NULL), 2688);
+}
+
+static void test_temperature_sweep(void)
+{
+  /* Extremes of each coefficient, with the sample calibration in between */
+  static const struct { uint16_t t1; int16_t t2; int8_t t3; } coef[] = {
+      { 25872,  26203,    3 },
+      {     0,  32767,  127 },
+      { 65535, -32768, -128 },
+      { 65535,  32767,  127 },
+      {     0, -32768, -128 },
+  };
+  unsigned mismatches = 0;
+
+  for (unsigned i = 0; i < sizeof(coef) / sizeof(coef[0]); i++) {
+      bme680_calib_t c = calib;
+
+      c.par_t1 = coef[i].t1;
+      c.par_t2 = coef[i].t2;
+      c.par_t3 = coef[i].t3;
+
+      for (uint32_t adc = 0; adc < (1UL << 20); adc++) {
+          int32_t t_fine, ref_t_fine;
+          int16_t t = bme680_comp_temperature(&c, adc, &t_fine);
+          int16_t ref_t = ref_temperature(&c, adc, &ref_t_fine);
+
+          if (t != ref_t || t_fine != ref_t_fine) {
+              if (mismatches++ < 4) {
+                  printf("temperature set %u adc %u: %d/%d, expected %d/%d\n",
+                         i, (unsigned)adc, t, (int)t_fine, ref_t, (int)ref_t_fine);
+              }
+          }
+      }
+  }
+
+  CHECK_EQ(mismatches, 0);
+}
+
+static void test_pressure(void)
+{
+  static const struct {
+    uint32_t adc;
+    int32_t t_fine;
+    uint32_t pressure;
+  } vec[] = {
+      /* 1048576 - adc is large, (x / var1) << 1 keeps it below 2^31 */
+      { 300000, T_FINE_WARM, 107782 },
+      { 350000, T_FINE_WARM, 101178 },
+      { 400000, T_FINE_WARM,  92560 },
+      { 350000, T_FINE_COLD,  95077 }, /* (t_fine >> 1) - 64000 < 0 */
+      { 400000, T_FINE_COLD,  86961 },
+      /* (x << 1) / var1 */
+      { 700000, T_FINE_WARM,  41261 },
+      { 700000, T_FINE_COLD,  38631 },
+  };
+
+  for (unsigned i = 0; i < sizeof(vec) / sizeof(vec[0]); i++) {
+      CHECK_EQ(bme680_comp_pressure(&calib, vec[i].adc, vec[i].t_fine), vec[i].pressure);
+  }
+
+  /* A blank calibration must not divide by zero */
+  bme680_calib_t blank = { 0 };
+  CHECK_EQ(bme680_comp_pressure(&blank, 350000, T_FINE_WARM), 0);
+}
+
+static void test_humidity(void)
+{
+  static const struct {
+    uint16_t adc;
+    int32_t t_fine;
+    uint32_t humidity;
+  } vec[] = {
+      {     0, T_FINE_WARM,      0 }, /* Clamped low */
+      { 10000, T_FINE_WARM,      0 },
+      { 20000, T_FINE_WARM,  42455 },
+      { 22000, T_FINE_WARM,  55024 },
+      { 25000, T_FINE_WARM,  75521 },
+      { 30000, T_FINE_WARM, 100000 }, /* Clamped high */
+      { 20000, T_FINE_COLD,  39040 },
+      { 22000, T_FINE_COLD,  50859 },
+      { 25000, T_FINE_COLD,  70296 },
+  };
+
+  for (unsigned i = 0; i < sizeof(vec) / sizeof(vec[0]); i++) {
+      CHECK_EQ(bme680_comp_humidity(&calib, vec[i].adc, vec[i].t_fine), vec[i].humidity);
+  }
+}
+
+static void test_gas(void)
+{
+  bme680_calib_t c = calib;
+  unsigned mismatches = 0;
+
+  CHECK_EQ(bme680_comp_gas(&c, 600, 4), 468719);
+  CHECK_EQ(bme680_comp_gas(&c, 300, 10), 9284);
+  CHECK_EQ(bme680_comp_gas(&c, 1023, 0), 5791464);
+  CHECK_EQ(bme680_comp_gas(&c, 512, 15), 244);
+  CHECK_EQ(bme680_comp_gas(&c, 600, 4 | 0x30), 468719); /* Bits above the range are ignored */
+
+  c.range_sw_err = -3;
+  CHECK_EQ(bme680_comp_gas(&c, 700, 8), 27394);
+
+  /* Every ADC value and range for every range_sw_err */
+  for (int err = INT8_MIN; err <= INT8_MAX; err++) {
+      c.range_sw_err = (int8_t)err;
+
+      for (uint8_t range = 0; range < 16; range++) {
+          for (uint16_t adc = 0; adc < 1024; adc++) {
+              uint32_t r = bme680_comp_gas(&c, adc, range);
+              uint32_t ref = ref_gas((int8_t)err, adc, range);
+
+              if (r != ref) {
+                  if (mismatches++ < 4) {
+                      printf("gas err %d range %u adc %u: %u, expected %u\n",
+                             err, range, adc, (unsigned)r, (unsigned)ref);
+                  }
+              }
+          }
+      }
+  }
+
+  CHECK_EQ(mismatches, 0);
+}
+
+static void test_res_heat(void)
+{
+  CHECK_EQ(bme680_calc_res_heat(&calib, 200, 25), 85);
+  CHECK_EQ(bme680_calc_res_heat(&calib, 320, 25), 117);
+  CHECK_EQ(bme680_calc_res_heat(&calib, 320, -10), 117);
+  CHECK_EQ(bme680_calc_res_heat(&calib, 400, 40), 138);
+  CHECK_EQ(bme680_calc_res_heat(&calib, 450, 25), 138); /* Limited to 400 degC */
+}
+
+static void test_gas_wait(void)
+{
+  static const struct {
+    uint16_t dur_ms;
+    uint8_t gas_wait;
+    uint32_t wait_ms;
+  } vec[] = {
+      {     0, 0x00,    0 },
+      {     1, 0x01,    1 },
+      {    63, 0x3F,   63 },
+      {    64, 0x50,   64 }, /* First value with the x4 multiplier */
+      {   100, 0x59,  100 }, /* Datasheet example */
+      {   150, 0x65,  148 }, /* Rounded down to the multiplier */
+      {  1000, 0xBE,  992 },
+      {  4031, 0xFE, 3968 },
+      {  4032, 0xFF, 4032 }, /* Longest duration */
+      { 65535, 0xFF, 4032 },
+  };
+
+  for (unsigned i = 0; i < sizeof(vec) / sizeof(vec[0]); i++) {
+      CHECK_EQ(bme680_calc_gas_wait(vec[i].dur_ms), vec[i].gas_wait);
+      CHECK_EQ(bme680_gas_wait_ms(vec[i].gas_wait), vec[i].wait_ms);
+  }
+}
+
+static void test_compensate(void)
+{
+  bme680_field_t field = {
+      .temp_adc = 500000, .press_adc = 350000, .hum_adc = 22000,
+      .gas_adc = 600, .gas_range = 4, .gas_status = BME680_GAS_VALID_MSK
+  };
+  bme680_data_t data;
+
+  bme680_compensate(&calib, &field, &data);
+  CHECK_EQ(data.temperature, 2688);
+  CHECK_EQ(data.pressure, 101178);
+  CHECK_EQ(data.humidity, 55024);
+  CHECK_EQ(data.gas_resistance, 468719);
+
+  /* No gas resistance without gas_valid_r */
+  field.gas_status = BME680_HEAT_STAB_MSK;
+  bme680_compensate(&calib, &field, &data);
+  CHECK_EQ(data.gas_resistance, 0);
+}
+
+int main(void)
+{
+  test_temperature();
+  test_temperature_sweep();
+  test_pressure();
+  test_humidity();
+  test_gas();
+  test_res_heat();
+  test_gas_wait();
+  test_compensate();
+
+  return TEST_RESULT("bme680_comp");
+}
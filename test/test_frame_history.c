@@ -0,0 +1,299 @@
+/*
+* File Name: test_frame_history.c
+* File Description: This file contains the host test of the delta encoded
+* Grid-EYE frame history in src/frame_history.c. Directed cases cover the
+* 4/5/6 bit delta widths, key frames, key slot reuse and pool eviction; a
+* random walk then checks every stored frame against a plain ring of the
+* appended frames while the pool wraps many times.
+* File Author: Gautama Gandhi
+* Tools used: gcc on the host
+**/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "src/frame_history.h"
+#include "test/test.h"
+
+#define UNITS(q) ((int16_t)((q) * 64)) /* 0.25 degC sensor units to Q8.8 */
+
+static frame_history_t h;
+
+/* Reference: the last FRAME_HISTORY_DEPTH appended frames */
+static int16_t ref[FRAME_HISTORY_DEPTH][GRID_EYE_PIXELS];
+static unsigned appended;
+
+/*
+ * Function Name: append
+ *
+ * Parameters:
+ * const int16_t *frame 64 pixel temperatures in Q8.8 degC
+ *
+ * Returns:
+ * uint8_t Delta width the frame was stored with, 0 for a key frame
+ *
+ * Brief: This function appends a frame to the history under test and to the
+ * reference ring.
+ *
+ */
+static uint8_t append(const int16_t *frame)
+{
+  frame_history_append(&h, frame);
+  memcpy(ref[appended % FRAME_HISTORY_DEPTH], frame, sizeof(ref[0]));
+  appended++;
+
+  return h.desc[(h.tail + h.count - 1) % FRAME_HISTORY_DEPTH].bits;
+}
+
+/*
+ * Function Name: reset
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function empties the history under test and the reference.
+ *
+ */
+static void reset(void)
+{
+  frame_history_init(&h);
+  appended = 0;
+}
+
+/*
+ * Function Name: check_all
+ *
+ * Parameters:
+ * none
+ *
+ * Returns:
+ * unsigned Number of frames that did not read back as appended
+ *
+ * Brief: This function reads back every stored frame and compares it with
+ * the reference. The history must hold the newest frames without gaps, and
+ * no frame beyond them.
+ *
+ */
+static unsigned check_all(void)
+{
+  int16_t frame[GRID_EYE_PIXELS];
+  unsigned bad = 0;
+  uint8_t count = frame_history_count(&h);
+
+  if (count > FRAME_HISTORY_DEPTH || count > appended || count == 0) {
+      return 1;
+  }
+
+  for (uint8_t age = 0; age < count; age++) {
+      if (!frame_history_get(&h, age, frame) ||
+          memcmp(frame, ref[(appended - 1 - age) % FRAME_HISTORY_DEPTH], sizeof(frame)) != 0) {
+          bad++;
+      }
+  }
+
+  if (frame_history_get(&h, count, frame)) {
+      bad++;
+  }
+
+  return bad;
+}
+
+/*
+ * Function Name: fill
+ *
+ * Parameters:
+ * int16_t *frame Frame out
+ * int16_t base Pixel value in sensor units
+ * int16_t step Added per pixel, alternating in sign
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function builds a frame whose pixels differ from base by
+ * +-step, so a frame following a base frame needs exactly |step| of range.
+ *
+ */
+static void fill(int16_t *frame, int16_t base, int16_t step)
+{
+  for (int p = 0; p < GRID_EYE_PIXELS; p++) {
+      frame[p] = UNITS(base + ((p & 1) ? -step : step) * (p % 3 == 0));
+  }
+}
+
+static void test_widths(void)
+{
+  static const struct {
+    int16_t step;
+    uint8_t bits;
+  } vec[] = {
+      {  0, 4 },
+      {  7, 4 },
+      { -7, 4 },
+      {  8, 5 },
+      { -8, 5 },
+      { 15, 5 },
+      { 16, 6 },
+      { 31, 6 },
+      {-31, 6 },
+      { 32, 0 }, /* Out of range of 6 bits, becomes a key frame */
+  };
+  int16_t frame[GRID_EYE_PIXELS];
+
+  for (unsigned i = 0; i < sizeof(vec) / sizeof(vec[0]); i++) {
+      reset();
+      fill(frame, 88, 0);
+      CHECK_EQ(append(frame), 0); /* The first frame is always a key frame */
+
+      fill(frame, 88, vec[i].step);
+      CHECK_EQ(append(frame), vec[i].bits);
+      CHECK_EQ(frame_history_count(&h), 2);
+      CHECK_EQ(check_all(), 0);
+  }
+
+  /* Bits below the sensor resolution are dropped */
+  int16_t out[GRID_EYE_PIXELS];
+  reset();
+  fill(frame, 88, 0);
+  frame[5] = UNITS(90) + 63;
+  frame_history_append(&h, frame);
+  CHECK(frame_history_get(&h, 0, out));
+  CHECK_EQ(out[5], UNITS(90));
+}
+
+static void test_key_slot_reuse(void)
+{
+  int16_t frame[GRID_EYE_PIXELS];
+
+  reset();
+
+  /* Each key frame is followed by two deltas against it */
+  for (int k = 0; k < FRAME_HISTORY_KEYS; k++) {
+      fill(frame, 40 * k, 0);
+      CHECK_EQ(append(frame), 0);
+      fill(frame, 40 * k, 3);
+      append(frame);
+      fill(frame, 40 * k, 12);
+      append(frame);
+  }
+  CHECK_EQ(frame_history_count(&h), 3 * FRAME_HISTORY_KEYS);
+  CHECK_EQ(check_all(), 0);
+
+  /* The next key frame takes slot 0 again, the three frames on it go */
+  fill(frame, -100, 0);
+  CHECK_EQ(append(frame), 0);
+  CHECK_EQ(h.key, 0);
+  CHECK_EQ(frame_history_count(&h), 3 * FRAME_HISTORY_KEYS - 3 + 1);
+  CHECK_EQ(check_all(), 0);
+
+  fill(frame, -100, 20);
+  append(frame);
+  CHECK_EQ(check_all(), 0);
+}
+
+static void test_pool_eviction(void)
+{
+  int16_t frame[GRID_EYE_PIXELS];
+  unsigned per_pool = FRAME_HISTORY_POOL / (6 * GRID_EYE_PIXELS / 8);
+
+  reset();
+  fill(frame, 88, 0);
+  append(frame);
+
+  /* 6 bit deltas fill the pool before the history is full; the key frame
+   * is the oldest and goes first, its slot stays valid for the deltas */
+  for (unsigned i = 0; i < 3 * FRAME_HISTORY_DEPTH; i++) {
+      fill(frame, 88, (i & 1) ? 20 : -20);
+      CHECK_EQ(append(frame), 6);
+      CHECK_EQ(check_all(), 0);
+  }
+  CHECK_EQ(frame_history_count(&h), per_pool);
+  CHECK(h.pool_used <= FRAME_HISTORY_POOL);
+
+  /* Narrower deltas make room for more frames, up to the history depth */
+  for (unsigned i = 0; i < 2 * FRAME_HISTORY_DEPTH; i++) {
+      fill(frame, 88, (i & 1) ? 3 : -3);
+      CHECK_EQ(append(frame), 4);
+      CHECK_EQ(check_all(), 0);
+  }
+  CHECK_EQ(frame_history_count(&h), FRAME_HISTORY_DEPTH);
+}
+
+static void test_random_walk(void)
+{
+  int16_t units[GRID_EYE_PIXELS];
+  int16_t frame[GRID_EYE_PIXELS];
+  unsigned widths[7] = { 0 };
+  unsigned wraps = 0, reuses = 0, bad = 0;
+  uint16_t last_head = 0;
+  uint8_t last_key = 0;
+
+  srand(5823);
+  reset();
+
+  for (int p = 0; p < GRID_EYE_PIXELS; p++) {
+      units[p] = 88;
+  }
+
+  for (int n = 0; n < 5000; n++) {
+      /* Mostly small drifts, now and then a jump that needs a key frame */
+      int r = rand() % 100;
+      int range = (r < 40) ? 7 : (r < 70) ? 15 : (r < 95) ? 31 : 200;
+
+      for (int p = 0; p < GRID_EYE_PIXELS; p++) {
+          int16_t v = units[p] + (int16_t)(rand() % (2 * range + 1) - range);
+
+          /* Stay within the 12 bit sensor range */
+          if (v > 2047) {
+              v = 2047;
+          }
+          if (v < -2048) {
+              v = -2048;
+          }
+          units[p] = (range > 31) ? v : units[p];
+          frame[p] = UNITS(v);
+      }
+
+      uint8_t bits = append(frame);
+      widths[bits]++;
+
+      if (h.pool_head < last_head) {
+          wraps++;
+      }
+      if (bits == 0 && h.key == 0 && last_key != 0) {
+          reuses++;
+      }
+      last_head = h.pool_head;
+      last_key = h.key;
+
+      bad += check_all();
+  }
+
+  CHECK_EQ(bad, 0);
+
+  /* The walk reached every path it is meant to cover */
+  CHECK(widths[0] > FRAME_HISTORY_KEYS);
+  CHECK(widths[4] > 0);
+  CHECK(widths[5] > 0);
+  CHECK(widths[6] > 0);
+  CHECK(wraps > 1);
+  CHECK(reuses > 1);
+}
+
+int main(void)
+{
+  int16_t frame[GRID_EYE_PIXELS];
+
+  frame_history_init(&h);
+  CHECK_EQ(frame_history_count(&h), 0);
+  CHECK(!frame_history_get(&h, 0, frame));
+
+  test_widths();
+  test_key_slot_reuse();
+  test_pool_eviction();
+  test_random_walk();
+
+  return TEST_RESULT("frame_history");
+}
@@ -0,0 +1,216 @@
+/*
+* File Name: test_grid_eye_frame.c
+* File Description: This file contains the host test of the Grid-EYE frame
+* conversion in src/grid_eye_frame.c. Every pair of 12 bit pixel values is
+* converted by the portable path and by a model of the QADD16 path, and both
+* are compared with a scalar reference.
+* File Author: Gautama Gandhi
+* Tools used: gcc on the host
+**/
+
+#include <stdint.h>
+#include <string.h>
+#include "src/grid_eye_frame.h"
+#include "test/test.h"
+
+/*
+ * Function Name: ref_pixel
+ *
+ * Parameters:
+ * uint16_t raw Pixel register pair, upper 4 bits ignored
+ *
+ * Returns:
+ * int16_t Temperature in Q8.8 degC
+ *
+ * Brief: This function sign extends the 12 bit pixel, scales 0.25 degC to
+ * 1/256 degC and saturates to the int16 range, one step at a time.
+ *
+ */
+static int16_t ref_pixel(uint16_t raw)
+{
+  int32_t v = raw & 0x0FFF;
+
+  if (v & 0x0800) {
+      v -= 0x1000;
+  }
+
+  v *= 64;
+
+  if (v > INT16_MAX) {
+      v = INT16_MAX;
+  }
+  if (v < INT16_MIN) {
+      v = INT16_MIN;
+  }
+
+  return (int16_t)v;
+}
+
+/*
+ * Function Name: qadd16
+ *
+ * Parameters:
+ * uint32_t a, uint32_t b Two signed halfwords each
+ *
+ * Returns:
+ * uint32_t Saturated halfword sums
+ *
+ * Brief: This function models the Cortex-M4 QADD16 instruction.
+ *
+ */
+static uint32_t qadd16(uint32_t a, uint32_t b)
+{
+  uint32_t r = 0;
+
+  for (int h = 0; h < 2; h++) {
+      int32_t s = (int16_t)(a >> (16 * h)) + (int16_t)(b >> (16 * h));
+
+      if (s > INT16_MAX) {
+          s = INT16_MAX;
+      }
+      if (s < INT16_MIN) {
+          s = INT16_MIN;
+      }
+      r |= ((uint32_t)s & 0xFFFF) << (16 * h);
+  }
+
+  return r;
+}
+
+/*
+ * Function Name: simd_frame_to_q88
+ *
+ * Parameters:
+ * const uint8_t *frame 128 byte register dump
+ * int16_t *out 64 temperatures in Q8.8 degC
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function runs the GRID_EYE_FRAME_SIMD path of
+ * grid_eye_frame_to_q88 with QADD16 modelled in C.
+ *
+ */
+static void simd_frame_to_q88(const uint8_t *frame, int16_t *out)
+{
+  for (int i = 0; i < GRID_EYE_PIXELS / 2; i++) {
+      uint32_t w;
+
+      memcpy(&w, &frame[4 * i], sizeof(w));
+      w = (w & 0x0FFF0FFFUL) << 4;
+      w = qadd16(w, w);
+      w = qadd16(w, w);
+      memcpy(&out[2 * i], &w, sizeof(w));
+  }
+}
+
+/*
+ * Function Name: put_pixel
+ *
+ * Parameters:
+ * uint8_t *frame Register dump
+ * int p Pixel index
+ * uint16_t raw Register pair, little endian as the sensor sends it
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function stores one pixel register pair in a register dump.
+ *
+ */
+static void put_pixel(uint8_t *frame, int p, uint16_t raw)
+{
+  frame[2 * p] = (uint8_t)raw;
+  frame[2 * p + 1] = (uint8_t)(raw >> 8);
+}
+
+static void test_full_range(void)
+{
+  uint8_t buf[2 * GRID_EYE_PIXELS + 1];
+  int16_t out[GRID_EYE_PIXELS], simd[GRID_EYE_PIXELS];
+  unsigned mismatches = 0;
+
+  /* Every (even, odd) pixel pair, with junk in the unused upper 4 bits. The
+   * dump starts at an odd address, which the word loads must handle */
+  for (uint32_t a = 0; a < 0x1000; a++) {
+      for (uint32_t b0 = 0; b0 < 0x1000; b0 += GRID_EYE_PIXELS / 2) {
+          uint8_t *frame = &buf[1];
+
+          for (int i = 0; i < GRID_EYE_PIXELS / 2; i++) {
+              put_pixel(frame, 2 * i, (uint16_t)(a | ((b0 + i) & 0xF) << 12));
+              put_pixel(frame, 2 * i + 1, (uint16_t)((b0 + i) | (a & 0xF) << 12));
+          }
+
+          grid_eye_frame_to_q88(frame, out);
+          simd_frame_to_q88(frame, simd);
+
+          for (int i = 0; i < GRID_EYE_PIXELS / 2; i++) {
+              int16_t ref_a = ref_pixel((uint16_t)a);
+              int16_t ref_b = ref_pixel((uint16_t)(b0 + i));
+
+              if (out[2 * i] != ref_a || out[2 * i + 1] != ref_b ||
+                  simd[2 * i] != ref_a || simd[2 * i + 1] != ref_b) {
+                  if (mismatches++ < 4) {
+                      printf("pixels 0x%03X 0x%03X: %d %d, QADD16 %d %d, expected %d %d\n",
+                             (unsigned)a, (unsigned)(b0 + i), out[2 * i], out[2 * i + 1],
+                             simd[2 * i], simd[2 * i + 1], ref_a, ref_b);
+                  }
+              }
+          }
+      }
+  }
+
+  CHECK_EQ(mismatches, 0);
+}
+
+static void test_pixels(void)
+{
+  static const struct {
+    uint16_t raw;
+    int16_t q88;
+  } vec[] = {
+      { 0x0000,      0 },
+      { 0x0001,     64 },  /* 0.25 degC */
+      { 0x0064,   6400 },  /* 25 degC */
+      { 0x01FF,  32704 },  /* 127.75 degC, largest that fits */
+      { 0x0200,  32767 },  /* 128 degC saturates */
+      { 0x07FF,  32767 },
+      { 0x0FFF,    -64 },  /* -0.25 degC */
+      { 0x0FB0,  -5120 },  /* -20 degC */
+      { 0x0E00, -32768 },  /* -128 degC, exact */
+      { 0x0DFF, -32768 },  /* Below saturates */
+      { 0x0800, -32768 },
+      { 0xF064,   6400 },  /* Upper 4 bits ignored */
+  };
+  uint8_t frame[2 * GRID_EYE_PIXELS];
+  int16_t out[GRID_EYE_PIXELS];
+
+  memset(frame, 0, sizeof(frame));
+  for (unsigned i = 0; i < sizeof(vec) / sizeof(vec[0]); i++) {
+      put_pixel(frame, i, vec[i].raw);
+  }
+
+  grid_eye_frame_to_q88(frame, out);
+
+  for (unsigned i = 0; i < sizeof(vec) / sizeof(vec[0]); i++) {
+      CHECK_EQ(out[i], vec[i].q88);
+  }
+}
+
+static void test_thermistor(void)
+{
+  CHECK_EQ(grid_eye_thermistor_to_q88(0x0000), 0);
+  CHECK_EQ(grid_eye_thermistor_to_q88(0x0190), 6400);   /* 25 degC */
+  CHECK_EQ(grid_eye_thermistor_to_q88(0x0001), 16);     /* 0.0625 degC */
+  CHECK_EQ(grid_eye_thermistor_to_q88(0x0801), -16);    /* Sign and magnitude */
+  CHECK_EQ(grid_eye_thermistor_to_q88(0x0A80), -10240); /* -40 degC */
+}
+
+int main(void)
+{
+  test_full_range();
+  test_pixels();
+  test_thermistor();
+
+  return TEST_RESULT("grid_eye_frame");
+}
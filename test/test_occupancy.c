@@ -0,0 +1,196 @@
+/*
+* File Name: test_occupancy.c
+* File Description: This file contains the host driver of the Grid-EYE
+* occupancy detection in src/occupancy.c. It replays a capture file frame by
+* frame through grid_eye_frame_to_q88() and occupancy_update(), as
+* grid_eye_task does on the board, and checks the blob count and centroids
+* given by the "expect" lines of the capture.
+* File Author: Gautama Gandhi
+* Tools used: gcc on the host
+*
+* Usage: test_occupancy [capture.txt ...]   (defaults to the fixtures)
+*
+* Capture format, one item per line, # starts a comment:
+*   64 pixel register values (0.25 degC units, 12 bit), row 0 first
+*   expect <count> [<x>,<y> ...]   centroids in pixels with two decimals
+**/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "src/grid_eye_frame.h"
+#include "src/occupancy.h"
+#include "test/test.h"
+
+static const char *default_captures[] = {
+    "fixtures/occupancy_office.txt",
+    "fixtures/occupancy_learnt_occupant.txt",
+};
+
+/*
+ * Function Name: parse_frame
+ *
+ * Parameters:
+ * char *line Capture line with 64 pixel values
+ * uint8_t *frame 128 byte register dump out
+ *
+ * Returns:
+ * int 0 on success, -1 if the line does not hold 64 values
+ *
+ * Brief: This function packs one capture line into the register dump the
+ * sensor returns from 0x80, low byte first.
+ *
+ */
+static int parse_frame(char *line, uint8_t *frame)
+{
+  int n = 0;
+
+  for (char *tok = strtok(line, " \t\r\n"); tok; tok = strtok(NULL, " \t\r\n")) {
+      char *end;
+      unsigned long v = strtoul(tok, &end, 0);
+
+      if (*end != '\0' || v > 0xFFFF || n == GRID_EYE_PIXELS) {
+          return -1;
+      }
+
+      frame[2 * n] = (uint8_t)v;
+      frame[2 * n + 1] = (uint8_t)(v >> 8);
+      n++;
+  }
+
+  return (n == GRID_EYE_PIXELS) ? 0 : -1;
+}
+
+/*
+ * Function Name: check_expect
+ *
+ * Parameters:
+ * char *line Capture line after "expect"
+ * const occupancy_result_t *result Result of the last frame
+ * unsigned frame_no Frame number, for the report
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function compares the blob count and the centroids of the last
+ * frame with an expect line. Centroids are compared as the firmware logs
+ * them, Q8.8 pixels printed with two decimals.
+ *
+ */
+static void check_expect(char *line, const occupancy_result_t *result, unsigned frame_no)
+{
+  char *tok = strtok(line, " \t\r\n");
+  unsigned i = 0;
+
+  if (tok == NULL) {
+      printf("frame %u: expect line without a count\n", frame_no);
+      test_failures++;
+      return;
+  }
+
+  if (result->count != strtoul(tok, NULL, 0)) {
+      printf("frame %u: %u blob(s), expected %s\n", frame_no, result->count, tok);
+      test_failures++;
+  }
+
+  for (tok = strtok(NULL, " \t\r\n"); tok; tok = strtok(NULL, " \t\r\n"), i++) {
+      char got[32] = "none";
+
+      if (i < result->count) {
+          const occupancy_blob_t *blob = &result->blobs[i];
+
+          snprintf(got, sizeof(got), "%u.%02u,%u.%02u",
+                   Q88_INT(blob->x), Q88_FRAC_HUNDREDTHS(blob->x),
+                   Q88_INT(blob->y), Q88_FRAC_HUNDREDTHS(blob->y));
+      }
+
+      if (strcmp(got, tok) != 0) {
+          printf("frame %u: blob %u at %s, expected %s\n", frame_no, i, got, tok);
+          test_failures++;
+      }
+  }
+}
+
+/*
+ * Function Name: replay
+ *
+ * Parameters:
+ * const char *path Capture file
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function runs one capture through a freshly reset background
+ * model and checks every expect line in it.
+ *
+ */
+static void replay(const char *path)
+{
+  FILE *capture = fopen(path, "r");
+  occupancy_model_t model;
+  occupancy_result_t result;
+  uint8_t frame[2 * GRID_EYE_PIXELS];
+  int16_t pixels[GRID_EYE_PIXELS];
+  char line[1024];
+  unsigned frames = 0, checks = 0, line_no = 0;
+
+  if (capture == NULL) {
+      printf("cannot open %s\n", path);
+      test_failures++;
+      return;
+  }
+
+  occupancy_reset(&model);
+  memset(&result, 0, sizeof(result));
+
+  while (fgets(line, sizeof(line), capture)) {
+      char *p = line + strspn(line, " \t");
+
+      line_no++;
+      if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0') {
+          continue;
+      }
+
+      if (strncmp(p, "expect", 6) == 0) {
+          if (frames == 0) {
+              printf("%s:%u: expect line before the first frame\n", path, line_no);
+              test_failures++;
+              continue;
+          }
+          check_expect(p + 6, &result, frames - 1);
+          checks++;
+          continue;
+      }
+
+      if (parse_frame(p, frame) != 0) {
+          printf("%s:%u: not a frame of %d pixels\n", path, line_no, GRID_EYE_PIXELS);
+          test_failures++;
+          continue;
+      }
+
+      grid_eye_frame_to_q88(frame, pixels);
+      occupancy_update(&model, pixels, &result);
+      frames++;
+  }
+
+  fclose(capture);
+
+  printf("%s: %u frames, %u checks\n", path, frames, checks);
+  CHECK(frames > 0 && checks > 0);
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc > 1) {
+      for (int i = 1; i < argc; i++) {
+          replay(argv[i]);
+      }
+  }
+  else {
+      for (unsigned i = 0; i < sizeof(default_captures) / sizeof(default_captures[0]); i++) {
+          replay(default_captures[i]);
+      }
+  }
+
+  return TEST_RESULT("occupancy");
+}
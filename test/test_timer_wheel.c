@@ -0,0 +1,304 @@
+/*
+* File Name: test_timer_wheel.c
+* File Description: This file contains the host test of the hierarchical
+* timer wheel in src/timer_wheel.c. Directed cases cover expiry on every
+* level and the cascades between them, cancel, timer_wheel_next and the wrap
+* of the tick counter; a random run then checks the wheel against a plain
+* list of expiry ticks.
+* File Author: Gautama Gandhi
+* Tools used: gcc on the host
+**/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "src/timer_wheel.h"
+#include "test/test.h"
+
+#define LEVEL_TICKS(level) (1UL << ((level) * TIMER_WHEEL_SLOT_BITS))
+
+static timer_wheel_t wheel;
+
+/*
+ * Function Name: arm
+ *
+ * Parameters:
+ * sw_timer_t *timer Timer to arm
+ * uint32_t delay Ticks from the wheel time
+ *
+ * Returns:
+ * none
+ *
+ * Brief: This function arms a timer delay ticks after the wheel time, as
+ * timerStart does.
+ *
+ */
+static void arm(sw_timer_t *timer, uint32_t delay)
+{
+  memset(timer, 0, sizeof(*timer));
+  timer->expiry = wheel.now + delay;
+  timer_wheel_add(&wheel, timer);
+}
+
+/*
+ * Function Name: step_until_empty
+ *
+ * Parameters:
+ * sw_timer_t **order Expired timers out, in the order they expired
+ * unsigned max Size of order
+ *
+ * Returns:
+ * unsigned Number of timers that expired
+ *
+ * Brief: This function advances the wheel one tick at a time until no timer
+ * is armed. Every timer must come out on the tick of its expiry.
+ *
+ */
+static unsigned step_until_empty(sw_timer_t **order, unsigned max)
+{
+  unsigned n = 0;
+  uint32_t when;
+
+  while (timer_wheel_next(&wheel, &when)) {
+      uint32_t tick = wheel.now + 1;
+
+      for (sw_timer_t *t = timer_wheel_advance(&wheel, tick); t; t = t->next) {
+          CHECK_EQ(t->expiry, tick);
+          CHECK(!t->armed);
+          if (n < max) {
+              order[n] = t;
+          }
+          n++;
+      }
+  }
+
+  return n;
+}
+
+static void test_levels(void)
+{
+  static const uint32_t delays[] = {
+      1, 2, 31,                                    /* Level 0 */
+      32, 33, 1023,                                /* Level 1 */
+      1024, 1025, 32767,                           /* Level 2 */
+      32768, 32769, TIMER_WHEEL_MAX_DELAY,         /* Level 3 */
+  };
+  static const uint8_t levels[] = { 0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3 };
+  const unsigned count = sizeof(delays) / sizeof(delays[0]);
+  sw_timer_t timers[sizeof(delays) / sizeof(delays[0])];
+  sw_timer_t *order[sizeof(delays) / sizeof(delays[0])];
+
+  /* Start part way into every level so the slots are not aligned */
+  timer_wheel_init(&wheel, 0x00012345);
+
+  /* Added backwards, they must still expire in order */
+  for (unsigned i = count; i-- > 0; ) {
+      arm(&timers[i], delays[i]);
+      CHECK_EQ(timers[i].level, levels[i]);
+  }
+
+  CHECK_EQ(step_until_empty(order, count), count);
+  for (unsigned i = 0; i < count; i++) {
+      CHECK(order[i] == &timers[i]);
+  }
+}
+
+static void test_clamp(void)
+{
+  sw_timer_t due, late;
+
+  timer_wheel_init(&wheel, 5000);
+
+  /* An expiry that has passed fires on the next tick */
+  memset(&due, 0, sizeof(due));
+  due.expiry = 4000;
+  timer_wheel_add(&wheel, &due);
+  CHECK_EQ(due.expiry, 5001);
+
+  /* An expiry beyond the wheel is pulled in to the longest delay */
+  memset(&late, 0, sizeof(late));
+  late.expiry = 5000 + TIMER_WHEEL_MAX_DELAY + 100;
+  timer_wheel_add(&wheel, &late);
+  CHECK_EQ(late.expiry, 5000 + TIMER_WHEEL_MAX_DELAY);
+
+  CHECK(timer_wheel_advance(&wheel, 5001) == &due);
+  CHECK(timer_wheel_advance(&wheel, 5000 + TIMER_WHEEL_MAX_DELAY) == &late);
+}
+
+static void test_cancel(void)
+{
+  sw_timer_t a, b, c, far;
+  uint32_t when;
+
+  timer_wheel_init(&wheel, 0);
+
+  /* Three timers in one slot: drop the middle, the head and then the tail */
+  arm(&a, 10);
+  arm(&b, 10);
+  arm(&c, 10);
+  timer_wheel_remove(&wheel, &b);
+  CHECK(!b.armed);
+  CHECK(b.next == NULL && b.prev == NULL);
+  timer_wheel_remove(&wheel, &b); /* Not armed, nothing happens */
+  timer_wheel_remove(&wheel, &c);
+  CHECK(wheel.occupied[0] != 0);
+  timer_wheel_remove(&wheel, &a);
+  CHECK_EQ(wheel.occupied[0], 0);
+  CHECK(!timer_wheel_next(&wheel, &when));
+  CHECK(timer_wheel_advance(&wheel, 100) == NULL);
+
+  /* Cancel after a cascade has moved the timer to a finer level; the
+   * timers expire on ticks 2000 and 2100 */
+  arm(&far, 1900);
+  arm(&a, 2000);
+  CHECK_EQ(far.level, 2);
+  CHECK(timer_wheel_advance(&wheel, 1990) == NULL);
+  CHECK(far.level < 2);
+  CHECK(far.armed);
+  timer_wheel_remove(&wheel, &far);
+  CHECK(timer_wheel_advance(&wheel, 2099) == NULL);
+  CHECK(timer_wheel_advance(&wheel, 2100) == &a);
+  for (int level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+      CHECK_EQ(wheel.occupied[level], 0);
+  }
+}
+
+static void test_next(void)
+{
+  sw_timer_t fine, coarse;
+  uint32_t when = 0;
+
+  timer_wheel_init(&wheel, 1000);
+  CHECK(!timer_wheel_next(&wheel, &when));
+
+  /* Level 0: the expiry itself */
+  arm(&fine, 20);
+  CHECK(timer_wheel_next(&wheel, &when));
+  CHECK_EQ(when, 1020);
+
+  /* Level 2: the start of its window, where it moves down, if that is
+   * sooner than the level 0 timer */
+  arm(&coarse, 3000);
+  CHECK(timer_wheel_next(&wheel, &when));
+  CHECK_EQ(when, 1020);
+  timer_wheel_remove(&wheel, &fine);
+  CHECK(timer_wheel_next(&wheel, &when));
+  CHECK_EQ(when, 4000 & ~(LEVEL_TICKS(2) - 1));
+
+  /* Advancing to that tick cascades without expiring, then next is exact */
+  CHECK(timer_wheel_advance(&wheel, when) == NULL);
+  while (timer_wheel_next(&wheel, &when) && when != coarse.expiry) {
+      CHECK(when < coarse.expiry);
+      CHECK(timer_wheel_advance(&wheel, when) == NULL);
+  }
+  CHECK_EQ(when, 4000);
+  CHECK(timer_wheel_advance(&wheel, when) == &coarse);
+}
+
+static void test_wrap(void)
+{
+  sw_timer_t timers[4];
+  sw_timer_t *order[4];
+
+  /* The tick counter wraps while the timers are pending */
+  timer_wheel_init(&wheel, UINT32_MAX - 40);
+  arm(&timers[0], 30);
+  arm(&timers[1], 41);   /* Expires on tick 0 */
+  arm(&timers[2], 100);
+  arm(&timers[3], 40000);
+
+  CHECK_EQ(timers[1].expiry, 0);
+  CHECK_EQ(step_until_empty(order, 4), 4);
+  for (unsigned i = 0; i < 4; i++) {
+      CHECK(order[i] == &timers[i]);
+  }
+}
+
+/*
+ * Random run: timers are armed, cancelled and rearmed with delays on every
+ * level while the wheel is advanced in jumps of random size. Each advance
+ * must return exactly the armed timers whose expiry was passed, in expiry
+ * order, and timer_wheel_next must never skip past a pending expiry.
+ */
+#define RANDOM_TIMERS 48
+
+static void test_random(void)
+{
+  static sw_timer_t timers[RANDOM_TIMERS];
+  bool pending[RANDOM_TIMERS];
+  unsigned fired = 0, cancelled = 0, bad = 0;
+
+  srand(1553);
+  timer_wheel_init(&wheel, UINT32_MAX - 300000);
+  memset(pending, 0, sizeof(pending));
+
+  for (int n = 0; n < 20000; n++) {
+      int i = rand() % RANDOM_TIMERS;
+      int r = rand() % 100;
+      uint32_t from = wheel.now, to, when, step;
+
+      if (r < 45) {
+          /* Rearm, from the first level up to the longest delay */
+          static const uint32_t ranges[] = { 32, 1024, 32768, TIMER_WHEEL_MAX_DELAY };
+
+          timer_wheel_remove(&wheel, &timers[i]);
+          arm(&timers[i], 1 + (uint32_t)rand() % ranges[rand() % 4]);
+          pending[i] = true;
+      }
+      else if (r < 55) {
+          timer_wheel_remove(&wheel, &timers[i]);
+          cancelled += pending[i];
+          pending[i] = false;
+      }
+
+      /* The next tick may be a cascade before any expiry, never after one */
+      if (timer_wheel_next(&wheel, &when)) {
+          for (int k = 0; k < RANDOM_TIMERS; k++) {
+              if (pending[k] && when - from > timers[k].expiry - from) {
+                  bad++;
+              }
+          }
+          bad += (when == from);
+      }
+
+      step = (r % 3 == 0) ? (uint32_t)rand() % 64 : (uint32_t)rand() % 20000;
+      to = from + step;
+
+      uint32_t last = 0;
+      for (sw_timer_t *t = timer_wheel_advance(&wheel, to); t; t = t->next) {
+          int k = (int)(t - timers);
+          uint32_t age = t->expiry - from;
+
+          if (!pending[k] || age == 0 || age > step || age < last || t->armed) {
+              bad++;
+          }
+          pending[k] = false;
+          last = age;
+          fired++;
+      }
+      CHECK_EQ(wheel.now, to);
+
+      /* Whatever is still pending has not expired yet */
+      for (int k = 0; k < RANDOM_TIMERS; k++) {
+          if (pending[k] != timers[k].armed || (pending[k] && timers[k].expiry - from <= step)) {
+              bad++;
+          }
+      }
+  }
+
+  CHECK_EQ(bad, 0);
+  CHECK(fired > 1000);
+  CHECK(cancelled > 100);
+}
+
+int main(void)
+{
+  test_levels();
+  test_clamp();
+  test_cancel();
+  test_next();
+  test_wrap();
+  test_random();
+
+  return TEST_RESULT("timer_wheel");
+}
@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+#
+# File Name: log_decode.py
+# File Description: Rebuilds the text of a VCOM capture taken from a build
+# with LOG_BINARY 1 (src/log.h). Each binary frame carries the address of a
+# log_msg_t descriptor in flash; the descriptor and its strings are read back
+# from the .axf of the same build, which is the message ID table.
+# File Author: Gautama Gandhi
+#
+# Usage: log_decode.py <image.axf> [capture.bin]   (capture defaults to stdin)
+#
+# Frame: FF A5 <nargs> <msg id u32> <timestamp u32> <arg u32> * nargs, little
+# endian. Bytes outside frames are text written with LOG_*_NOW and are passed
+# through unchanged.
+
+import re
+import struct
+import sys
+
+FRAME_SYNC = b"\xff\xa5"
+
+CONVERSION = re.compile(
+    r"%(?P<flags>[-+ #0]*)(?P<width>\d+)?(?:\.(?P<prec>\d+))?"
+    r"(?P<len>hh|h|ll|l|j|z|t)?(?P<conv>[diouxXcsp%])")
+
+
+class Image:
+    """Loadable segments of an ELF file, addressed like the target memory."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+
+        if self.data[:4] != b"\x7fELF":
+            raise ValueError("%s is not an ELF file" % path)
+
+        self.is64 = self.data[4] == 2
+        self.ptr = "<Q" if self.is64 else "<I"
+        self.ptr_size = 8 if self.is64 else 4
+
+        if self.is64:
+            phoff, = struct.unpack_from("<Q", self.data, 0x20)
+            phentsize, phnum = struct.unpack_from("<HH", self.data, 0x36)
+        else:
+            phoff, = struct.unpack_from("<I", self.data, 0x1C)
+            phentsize, phnum = struct.unpack_from("<HH", self.data, 0x2A)
+
+        self.segments = []
+        for i in range(phnum):
+            base = phoff + i * phentsize
+            if self.is64:
+                p_type, _, offset, vaddr, _, filesz = struct.unpack_from("<IIQQQQ", self.data, base)
+            else:
+                p_type, offset, vaddr, _, filesz = struct.unpack_from("<IIIII", self.data, base)
+            if p_type == 1 and filesz:  # PT_LOAD
+                self.segments.append((vaddr, offset, filesz))
+
+    def read(self, addr, size):
+        for vaddr, offset, filesz in self.segments:
+            if vaddr <= addr and addr + size <= vaddr + filesz:
+                start = offset + addr - vaddr
+                return self.data[start:start + size]
+        return None
+
+    def pointer(self, addr):
+        raw = self.read(addr, self.ptr_size)
+        return struct.unpack(self.ptr, raw)[0] if raw else None
+
+    def string(self, addr):
+        for vaddr, offset, filesz in self.segments:
+            if vaddr <= addr < vaddr + filesz:
+                start = offset + addr - vaddr
+                end = self.data.find(b"\0", start, offset + filesz)
+                if end < 0:
+                    return None
+                return self.data[start:end].decode("latin-1")
+        return None
+
+
+def signed(value, bits):
+    value &= (1 << bits) - 1
+    return value - (1 << bits) if value >> (bits - 1) else value
+
+
+def format_message(image, fmt, args):
+    """printf for 32 bit argument words, as the target's vsnprintf sees them."""
+    words = iter(args)
+
+    def convert(m):
+        conv, length = m.group("conv"), m.group("len") or ""
+        if conv == "%":
+            return "%"
+
+        word = next(words, 0)
+        spec = "%" + m.group("flags") + (m.group("width") or "")
+        if m.group("prec") is not None:
+            spec += "." + m.group("prec")
+
+        bits = 8 if length == "hh" else 16 if length == "h" else 32
+        if conv in "di":
+            return (spec + "d") % signed(word, bits)
+        if conv in "ouxX":
+            return (spec + conv) % (word & ((1 << bits) - 1))
+        if conv == "c":
+            return (spec + "c") % chr(word & 0xFF)
+        if conv == "p":
+            return "0x%08x" % word
+        text = image.string(word)
+        return (spec + "s") % (text if text is not None else "<0x%08x>" % word)
+
+    return CONVERSION.sub(convert, fmt)
+
+
+def decode(image, stream, out):
+    data = stream.read()
+    pos = 0
+
+    while pos < len(data):
+        start = data.find(FRAME_SYNC, pos)
+        if start < 0:
+            out.write(data[pos:].decode("latin-1"))
+            break
+
+        out.write(data[pos:start].decode("latin-1"))
+
+        if start + 3 > len(data):
+            break
+        nargs = data[start + 2]
+        end = start + 3 + 4 * (2 + nargs)
+        if end > len(data):
+            break  # Capture ends inside a frame
+
+        words = struct.unpack_from("<%dI" % (2 + nargs), data, start + 3)
+        msg_id, timestamp, args = words[0], words[1], words[2:]
+
+        level = func = fmt = None
+        if image.pointer(msg_id) is not None:
+            level = image.string(image.pointer(msg_id))
+            func = image.string(image.pointer(msg_id + image.ptr_size))
+            fmt = image.string(image.pointer(msg_id + 2 * image.ptr_size))
+
+        if fmt is None:
+            out.write("%5u:?????:?: unknown message 0x%08x %s\n" %
+                      (timestamp, msg_id, " ".join("0x%08x" % a for a in args)))
+        else:
+            out.write("%5u:%s:%s: %s\n" % (timestamp, level, func, format_message(image, fmt, args)))
+
+        pos = end
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.stderr.write(__doc__ or "usage: log_decode.py <image.axf> [capture.bin]\n")
+        return 2
+
+    image = Image(sys.argv[1])
+
+    if len(sys.argv) == 3:
+        with open(sys.argv[2], "rb") as stream:
+            decode(image, stream, sys.stdout)
+    else:
+        decode(image, sys.stdin.buffer, sys.stdout)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())